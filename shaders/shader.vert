@@ -6,10 +6,14 @@
 
 // clang-format off
 layout(binding = 0) uniform UniformBufferObject {
-  mat4 model;
   mat4 view;
   mat4 proj;
 } ubo;
+
+// Pushed before every draw, the interpolated transform of the entity
+layout(push_constant) uniform Push {
+  mat4 model;
+} push;
 // clang-format on
 
 layout(location = 0) in vec2 inPosition;
@@ -18,6 +22,6 @@ layout(location = 1) in vec3 inColor;
 layout(location = 0) out vec3 fragColor;
 
 void main() {
-  gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 0.0, 1.0);
+  gl_Position = ubo.proj * ubo.view * push.model * vec4(inPosition, 0.0, 1.0);
   fragColor = inColor;
 }
@@ -4,14 +4,15 @@
 
 #include "ecs/entity.hpp"
 #include "engine/component/ModelComponent.hpp"
-#include "engine/component/UniformBufferObjectComponent.hpp"
+#include "engine/component/TransformComponent.hpp"
 #include "engine/system/RenderSystem.hpp"
+#include "engine/system/RotationSystem.hpp"
 #include "rlm/model.hpp"
 
 #include "Game.hpp"
 
 namespace app {
-Game::Game() : myEngine() {
+Game::Game(const engine::EngineConfig &config) : myEngine(config) {
   setupRenderer();
   setupSystems();
 }
@@ -24,12 +25,14 @@ void Game::run() {
 void Game::setupRenderer() {
   std::shared_ptr<engine::system::RenderSystem> renderSystem =
       std::make_shared<engine::system::RenderSystem>(
-          myEngine.getRenderer(), myEngine.getSimpleRenderSystem());
+          myEngine.getRenderer(),
+          myEngine.getSimpleRenderSystem(),
+          myEngine.getInterpolator());
   myEngine.setRenderingSystem(renderSystem);
 }
 
 void Game::setupSystems() {
-  // myEngine.addSystem(std::make_unique<engine::system::RotationSystem>());
+  myEngine.addSystem(std::make_unique<engine::system::RotationSystem>());
 }
 
 void Game::setupScene() {
@@ -43,18 +46,17 @@ void Game::setupScene() {
   const rlm::Model::Builder &modelBuilder = {
       .vertices = vertices, .indices = indices};
 
-  ecs::ComponentIDGenerator::registerComponent<
-      engine::component::ModelComponent>();
-
-  ecs::EntityID myTriangle =
-      myEngine.createEntity<engine::component::ModelComponent>(
+  // Stored once, every entity using the model shares it
+  ecs::SharedHandle<engine::component::ModelComponent> triangleModel =
+      myEngine.addSharedValue(
           engine::component::ModelComponent(
-              std::make_unique<rlm::Model>(
+              std::make_shared<rlm::Model>(
                   myEngine.getDevice(), modelBuilder)));
 
-  // engine::component::UniformBufferObject myTrianglePosition{};
-  // myEngine.addComponent<engine::component::UniformBufferObject>(
-  //     myTrianglePosition, myTriangle);
+  // Placed and spun through its transform, drawn with the interpolated matrix
+  ecs::EntityID myTriangle =
+      myEngine.createEntity(engine::component::TransformComponent{});
+  myEngine.setShared(myTriangle, triangleModel);
 }
 
 }  // namespace app
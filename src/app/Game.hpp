@@ -1,11 +1,12 @@
 #pragma once
 
 #include "engine/Engine.hpp"
+#include "engine/EngineConfig.hpp"
 
 namespace app {
 class Game {
  public:
-  Game();
+  explicit Game(const engine::EngineConfig &config = {});
   void run();
 
  private:
@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+#include "ecs/register.hpp"
+#include "engine/component/TransformComponent.hpp"
+#include "engine/system/RenderSystem.hpp"
+#include "engine/system/System.hpp"
+#include "rlm/model.hpp"
+
+#include "StressScene.hpp"
+
+namespace app {
+
+namespace {
+
+using engine::component::ModelComponent;
+using engine::component::TransformComponent;
+
+// Every set bit of an entity's variant adds one of these, so 8 tags give the
+// 256 combinations of MAX_ARCHETYPES
+constexpr size_t TAG_COUNT = 8;
+
+template <size_t Bit> struct StressTag {};
+
+template <size_t... Bits>
+void addTags(
+    ecs::Register &register_,
+    ecs::EntityID entity,
+    uint32_t variant,
+    std::index_sequence<Bits...>) {
+  (
+      [&]() {
+        if (variant & (1u << Bits)) {
+          register_.addComponent(StressTag<Bits>{}, entity);
+        }
+      }(),
+      ...);
+}
+
+// Spawns the scene on its first tick and then keeps replacing entities, so
+// every tick pays for archetype moves, deletions and maintenance
+class ChurnSystem : public engine::system::System {
+ public:
+  ChurnSystem(
+      const StressSceneConfig &config,
+      const std::vector<ecs::SharedHandle<ModelComponent>> &meshes)
+      : config(config), meshes(meshes), generator(config.seed) {}
+
+  const char *getName() const override { return "ChurnSystem::update"; }
+
+  void update(ecs::Register &register_, float deltaTime) override {
+    if (entities.empty()) {
+      entities.reserve(config.entityCount);
+      for (uint32_t i = 0; i < config.entityCount; i++) {
+        entities.push_back(spawn(register_));
+      }
+      return;
+    }
+    std::uniform_int_distribution<size_t> pick(0, entities.size() - 1);
+    for (uint32_t i = 0; i < config.churnPerTick; i++) {
+      ecs::EntityID &entity = entities[pick(generator)];
+      register_.deleteEntity(entity);
+      entity = spawn(register_);
+    }
+  }
+
+ private:
+  ecs::EntityID spawn(ecs::Register &register_) {
+    std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+    TransformComponent transform;
+    transform.position =
+        glm::vec3(coordinate(generator), coordinate(generator), 0.0f);
+    ecs::EntityID entity = register_.createEntity(transform);
+    register_.setShared(entity, meshes[spawned % meshes.size()]);
+    addTags(
+        register_,
+        entity,
+        static_cast<uint32_t>(spawned % config.archetypeCount),
+        std::make_index_sequence<TAG_COUNT>());
+    spawned++;
+    return entity;
+  }
+
+  const StressSceneConfig &config;
+  const std::vector<ecs::SharedHandle<ModelComponent>> &meshes;
+  std::mt19937 generator;
+  std::vector<ecs::EntityID> entities;
+  uint64_t spawned = 0;
+};
+
+struct Summary {
+  size_t samples = 0;
+  double mean = 0.0;
+  double p50 = 0.0;
+  double p95 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+// Nearest rank percentiles, every reported value is a frame that happened
+Summary summarize(std::vector<double> samples) {
+  Summary summary;
+  summary.samples = samples.size();
+  if (samples.empty()) {
+    return summary;
+  }
+  std::sort(samples.begin(), samples.end());
+  auto percentile = [&](double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+    return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+  };
+  double sum = 0.0;
+  for (double sample : samples) {
+    sum += sample;
+  }
+  summary.mean = sum / samples.size();
+  summary.p50 = percentile(0.50);
+  summary.p95 = percentile(0.95);
+  summary.p99 = percentile(0.99);
+  summary.max = samples.back();
+  return summary;
+}
+
+}  // namespace
+
+StressScene::StressScene(
+    const engine::EngineConfig &engineConfig,
+    const StressSceneConfig &config)
+    : config(config), myEngine(withFrameLimit(engineConfig)) {
+  if (config.entityCount == 0 || config.meshCount == 0 ||
+      config.archetypeCount == 0) {
+    throw std::runtime_error("stress scene needs entities, meshes and "
+                             "archetypes");
+  }
+  if (config.archetypeCount > MAX_ARCHETYPES) {
+    throw std::runtime_error(
+        std::format(
+            "stress scene supports at most {} archetypes", MAX_ARCHETYPES));
+  }
+  if (config.resizeEvery != 0 && engineConfig.headless) {
+    throw std::runtime_error("stress scene resizes need a window");
+  }
+  setupRenderer();
+  setupMeshes();
+  setupSystems();
+}
+
+engine::EngineConfig
+StressScene::withFrameLimit(engine::EngineConfig engineConfig) {
+  if (engineConfig.frameLimit == 0) {
+    engineConfig.frameLimit = DEFAULT_FRAMES;
+  }
+  return engineConfig;
+}
+
+void StressScene::run() {
+  uint64_t measured = myEngine.getConfig().frameLimit;
+  measured -= std::min<uint64_t>(measured, config.warmupFrames);
+  frameSamples.reserve(measured);
+  simulateSamples.reserve(measured);
+  recordSamples.reserve(measured);
+  submitSamples.reserve(measured);
+  gpuSamples.reserve(measured);
+
+  auto lastFrame = std::chrono::steady_clock::now();
+  myEngine.setFrameCallback(
+      [&](const engine::profiler::FrameStats &stats) {
+        // Wall time between submissions, the frame time of the stats is one
+        // tick when headless
+        auto now = std::chrono::steady_clock::now();
+        double frameMilliseconds =
+            std::chrono::duration<double, std::milli>(now - lastFrame).count();
+        lastFrame = now;
+        if (stats.frame > config.warmupFrames) {
+          frameSamples.push_back(frameMilliseconds);
+          recordFrame(stats);
+        }
+        if (config.resizeEvery != 0 && stats.frame % config.resizeEvery == 0) {
+          resizeWindow();
+        }
+      });
+  myEngine.run();
+  writeReport();
+}
+
+void StressScene::setupRenderer() {
+  myEngine.setRenderingSystem(
+      std::make_shared<engine::system::RenderSystem>(
+          myEngine.getRenderer(),
+          myEngine.getSimpleRenderSystem(),
+          myEngine.getInterpolator()));
+}
+
+void StressScene::setupSystems() {
+  myEngine.addSystem(std::make_unique<ChurnSystem>(config, meshes));
+}
+
+void StressScene::setupMeshes() {
+  // Regular polygons with 3, 4, 5, ... corners, so the meshes differ in size
+  for (uint32_t mesh = 0; mesh < config.meshCount; mesh++) {
+    uint32_t corners = 3 + mesh;
+    rlm::Model::Builder builder;
+    builder.vertices.push_back({{0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}});
+    for (uint32_t corner = 0; corner < corners; corner++) {
+      float angle = 2.0f * std::numbers::pi_v<float> * corner / corners;
+      builder.vertices.push_back(
+          {{0.1f * std::cos(angle), 0.1f * std::sin(angle)},
+           {0.5f + 0.5f * std::cos(angle), 0.5f + 0.5f * std::sin(angle),
+            static_cast<float>(mesh) / config.meshCount}});
+      builder.indices.push_back(0);
+      builder.indices.push_back(1 + corner);
+      builder.indices.push_back(1 + (corner + 1) % corners);
+    }
+    meshes.push_back(
+        myEngine.addSharedValue(
+            ModelComponent(
+                std::make_shared<rlm::Model>(myEngine.getDevice(), builder))));
+  }
+}
+
+void StressScene::recordFrame(const engine::profiler::FrameStats &stats) {
+  simulateSamples.push_back(stats.simulateMilliseconds);
+  recordSamples.push_back(stats.recordMilliseconds);
+  submitSamples.push_back(stats.submitMilliseconds);
+  // The same GPU results stay in the stats until a newer frame is read back
+  if (stats.gpuFrame != lastGpuFrame && stats.gpuFrame > config.warmupFrames) {
+    lastGpuFrame = stats.gpuFrame;
+    double gpuMilliseconds = 0.0;
+    for (const engine::profiler::ScopeTiming &scope : stats.gpuScopes) {
+      if (std::string_view(scope.name) == "RenderPass") {
+        gpuMilliseconds += scope.milliseconds;
+      }
+    }
+    gpuSamples.push_back(gpuMilliseconds);
+  }
+}
+
+void StressScene::resizeWindow() {
+  const engine::EngineConfig &engineConfig = myEngine.getConfig();
+  resizes++;
+  uint32_t divisor = resizes % 2 == 1 ? 2 : 1;
+  myEngine.resizeWindow(
+      engineConfig.width / divisor, engineConfig.height / divisor);
+}
+
+void StressScene::writeReport() {
+  const engine::EngineConfig &engineConfig = myEngine.getConfig();
+  std::string report = std::format(
+      "{{\n  \"config\": {{\"entities\": {}, \"meshes\": {}, "
+      "\"archetypes\": {}, \"churnPerTick\": {}, \"frames\": {}, "
+      "\"warmupFrames\": {}, \"headless\": {}, \"pipelined\": {}, "
+      "\"width\": {}, \"height\": {}, \"resizeEvery\": {}, "
+      "\"resizes\": {}}},\n  \"phases\": {{",
+      config.entityCount,
+      config.meshCount,
+      config.archetypeCount,
+      config.churnPerTick,
+      engineConfig.frameLimit,
+      config.warmupFrames,
+      engineConfig.headless,
+      engineConfig.pipelined,
+      engineConfig.width,
+      engineConfig.height,
+      config.resizeEvery,
+      resizes);
+
+  // All values in milliseconds
+  std::pair<const char *, const std::vector<double> *> phases[] = {
+      {"frame", &frameSamples},
+      {"simulate", &simulateSamples},
+      {"record", &recordSamples},
+      {"submit", &submitSamples},
+      {"gpu", &gpuSamples},
+  };
+  bool first = true;
+  for (auto [name, samples] : phases) {
+    Summary summary = summarize(*samples);
+    report += std::format(
+        "{}\n    \"{}\": {{\"samples\": {}, \"mean\": {:.4f}, "
+        "\"p50\": {:.4f}, \"p95\": {:.4f}, \"p99\": {:.4f}, "
+        "\"max\": {:.4f}}}",
+        first ? "" : ",",
+        name,
+        summary.samples,
+        summary.mean,
+        summary.p50,
+        summary.p95,
+        summary.p99,
+        summary.max);
+    first = false;
+  }
+  report += "\n  }\n}\n";
+
+  if (config.reportOutput.empty()) {
+    std::cout << report;
+    return;
+  }
+  std::ofstream file(config.reportOutput);
+  if (!file) {
+    throw std::runtime_error("failed to open " + config.reportOutput);
+  }
+  file << report;
+}
+
+}  // namespace app
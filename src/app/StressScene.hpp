@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ecs/shared.hpp"
+#include "engine/Engine.hpp"
+#include "engine/EngineConfig.hpp"
+#include "engine/component/ModelComponent.hpp"
+#include "engine/profiler/FrameStats.hpp"
+
+namespace app {
+
+struct StressSceneConfig {
+  uint32_t entityCount = 10000;
+  // Distinct models the entities are spread over
+  uint32_t meshCount = 8;
+  // Tag combinations the entities are spread over, each model splits them
+  // further since entities sharing a model share an archetype
+  uint32_t archetypeCount = 16;
+  // Entities deleted and spawned again every tick
+  uint32_t churnPerTick = 100;
+  // Frames left out of the report while caches, pools and archetypes fill up
+  uint32_t warmupFrames = 60;
+  // Resizes the window every this many frames, alternating between the
+  // engine's size and half of it, so the run includes swap chain recreation.
+  // 0 never resizes, anything else needs a window.
+  uint32_t resizeEvery = 0;
+  uint32_t seed = 42;
+  // JSON report, printed to stdout when empty
+  std::string reportOutput;
+};
+
+/// Benchmark workload: spawns a configurable scene, runs the engine for the
+/// frame limit of its config and reports p50, p95 and p99 of each frame phase
+class StressScene {
+ public:
+  // Most tag combinations a scene can use
+  static constexpr uint32_t MAX_ARCHETYPES = 256;
+  // Frames run when the engine config has no frame limit
+  static constexpr uint64_t DEFAULT_FRAMES = 1000;
+
+  /// @throws std::runtime_error if a count is 0, archetypeCount is above
+  /// MAX_ARCHETYPES or resizeEvery is set for a headless engine
+  StressScene(
+      const engine::EngineConfig &engineConfig,
+      const StressSceneConfig &config);
+
+  /// Runs the frames and writes the report
+  void run();
+
+ private:
+  void setupRenderer();
+  void setupSystems();
+  void setupMeshes();
+  void recordFrame(const engine::profiler::FrameStats &stats);
+  void resizeWindow();
+  void writeReport();
+
+  static engine::EngineConfig
+  withFrameLimit(engine::EngineConfig engineConfig);
+
+  StressSceneConfig config;
+  engine::Engine myEngine;
+  std::vector<ecs::SharedHandle<engine::component::ModelComponent>> meshes;
+
+  // One sample per measured frame, in milliseconds
+  std::vector<double> frameSamples;
+  std::vector<double> simulateSamples;
+  std::vector<double> recordSamples;
+  std::vector<double> submitSamples;
+  // GPU timings arrive frames late and only when the queue has timestamps
+  std::vector<double> gpuSamples;
+  uint64_t lastGpuFrame = 0;
+  uint32_t resizes = 0;
+};
+
+}  // namespace app
@@ -1,13 +1,67 @@
 #pragma once
 
-#include <atomic>
 #include <cstdint>
-#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace ecs {
 using ComponentID = uint32_t;
 using ArchetypeId = uint32_t;
 
+// Name of the type as the compiler spells it, taken from the signature of this
+// function so it is available at compile time
+template <typename Component> constexpr std::string_view getTypeName() {
+  std::string_view signature = __PRETTY_FUNCTION__;
+  size_t begin = signature.find("Component = ");
+  if (begin == std::string_view::npos) {
+    return signature;
+  }
+  begin += std::string_view("Component = ").size();
+  size_t end = signature.find(';', begin);
+  if (end == std::string_view::npos) {
+    end = signature.rfind(']');
+  }
+  return signature.substr(begin, end - begin);
+}
+
+// Specialize to give a component a name of its own, its stable id is the hash
+// of it. The default is the type name as the compiler spells it. hashTypeName
+// evens out the spacing and the anonymous namespace, so plain, nested and
+// class template names hash the same with GCC and Clang. Other spellings, like
+// non-type template arguments or default arguments of library templates, can
+// still differ between compilers and their versions, give those a name.
+template <typename Component>
+inline constexpr std::string_view componentName = getTypeName<Component>();
+
+// 32 bit FNV-1a of the name without spaces, with Clang's "(anonymous
+// namespace)" hashed as GCC's "{anonymous}". GCC writes "Box<Box<int> >" and
+// "Box<Box<int>>" depending on the version, both hash the same.
+constexpr uint32_t hashTypeName(std::string_view name) {
+  constexpr std::string_view clangAnonymous = "(anonymous namespace)";
+  constexpr std::string_view gccAnonymous = "{anonymous}";
+  uint32_t hash = 2166136261u;
+  auto add = [&hash](char c) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 16777619u;
+  };
+  for (size_t i = 0; i < name.size(); i++) {
+    if (name.substr(i).starts_with(clangAnonymous)) {
+      for (char c : gccAnonymous) {
+        add(c);
+      }
+      i += clangAnonymous.size() - 1;
+    } else if (name[i] != ' ') {
+      add(name[i]);
+    }
+  }
+  return hash;
+}
+
 class ComponentIDGenerator {
  public:
   struct ComponentInfo {
@@ -16,6 +70,16 @@ class ComponentIDGenerator {
     void (*ctor)(void *, int);
     void (*dtor)(void *, int);
     void (*move)(void *, void *, int);
+    void (*swap)(void *, void *);
+    // Copy constructs count elements, nullptr for types that can't be copied
+    void (*copy)(void *, const void *, int);
+    // Snapshots copy trivially copyable components with memcpy
+    bool triviallyCopyable;
+    // Hash of componentName. The same in every run and in every build by the
+    // same compiler and version. Across compilers for the names hashTypeName
+    // evens out and for components that specialize componentName.
+    uint32_t stableID;
+    std::string_view name;
   };
 
   template <typename Component>
@@ -37,11 +101,63 @@ class ComponentIDGenerator {
         reinterpret_cast<Component *>(dst));
   }
 
-  template <typename Component> static uint32_t nextID() {
-    return current_id.fetch_add(1);
+  template <typename Component>
+  static void copy_function(void *dst, const void *src, int count) {
+    std::uninitialized_copy_n(
+        reinterpret_cast<const Component *>(src),
+        count,
+        reinterpret_cast<Component *>(dst));
+  }
+
+  template <typename Component> static void swap_function(void *a, void *b) {
+    using std::swap;
+    swap(*reinterpret_cast<Component *>(a), *reinterpret_cast<Component *>(b));
+  }
+
+  // Components register themselves during static initialization, calling this
+  // is only needed to use a component from another static initializer
+  template <typename Component> static ComponentID registerComponent() {
+    return componentID<Component>;
+  }
+
+  // A plain load of a variable set up before main, so it is cheap enough for
+  // hot loops. The ids are dense and small, which lets archetypes index
+  // tables with them, but their order follows static initialization. Use
+  // getStableComponentID for anything that leaves the process, with a
+  // componentName for anything read back by another compiler.
+  template <typename Component> static ComponentID getComponentID() {
+    return componentID<Component>;
+  }
+
+  template <typename Component>
+  static constexpr uint32_t getStableComponentID() {
+    return hashTypeName(componentName<Component>);
+  }
+
+  // 0 if no registered component has the stable id
+  static ComponentID findComponentByStableID(uint32_t stableID) {
+    auto &infos = componentInfos();
+    for (ComponentID componentID = 1; componentID < infos.size();
+         componentID++) {
+      if (infos[componentID].stableID == stableID) {
+        return componentID;
+      }
+    }
+    return 0;
+  }
+
+  static const ComponentInfo &getComponentInfo(ComponentID componentID) {
+    return componentInfos()[componentID];
   }
 
-  template <typename Component> static void registerComponent() {
+  static size_t getComponentSize(ComponentID componentID) {
+    return componentInfos()[componentID].size;
+  }
+
+  static size_t getComponentCount() { return componentInfos().size(); }
+
+ private:
+  template <typename Component> static ComponentID assignComponentID() {
     ComponentInfo ti;
     ti.size = sizeof(Component);
     ti.align = alignof(Component);
@@ -49,30 +165,49 @@ class ComponentIDGenerator {
     ti.ctor = &ctor_function<Component>;
     ti.dtor = &dtor_function<Component>;
     ti.move = &move_function<Component>;
-
-    uint32_t id = getComponentID<Component>();
-    if (id >= typeInfoMap.size()) {
-      typeInfoMap.resize(id + 1);
+    ti.swap = &swap_function<Component>;
+    if constexpr (std::is_copy_constructible_v<Component>) {
+      ti.copy = &copy_function<Component>;
+    } else {
+      ti.copy = nullptr;
+    }
+    ti.triviallyCopyable = std::is_trivially_copyable_v<Component>;
+    ti.stableID = getStableComponentID<Component>();
+    ti.name = componentName<Component>;
+
+    // Components register during static initialization, where an exception
+    // would end in std::terminate without its message
+    ComponentID existing = findComponentByStableID(ti.stableID);
+    if (existing != 0) {
+      std::string_view other = componentInfos()[existing].name;
+      std::fprintf(
+          stderr,
+          "stable component id of %.*s collides with %.*s, specialize "
+          "ecs::componentName for one of them\n",
+          static_cast<int>(ti.name.size()),
+          ti.name.data(),
+          static_cast<int>(other.size()),
+          other.data());
+      std::abort();
     }
 
-    typeInfoMap[getComponentID<Component>()] = ti;
+    // Id 0 is the empty entry, ids start at 1
+    auto &infos = componentInfos();
+    infos.push_back(ti);
+    return static_cast<ComponentID>(infos.size() - 1);
   }
 
-  template <typename Component> static uint32_t getComponentID() {
-    // C++ guarantees that this line is executed only once, safely,
-    // even if the IDGenerator itself is non-atomic.
-    static const uint32_t componentID = nextID<Component>();
-    return componentID;
+  // Function local so it exists before the first component registers itself,
+  // whatever order the static initializers run in. A deque so the columns can
+  // keep pointers to the entries while more components register.
+  static std::deque<ComponentInfo> &componentInfos() {
+    static std::deque<ComponentInfo> infos{ComponentInfo{}};
+    return infos;
   }
 
-  static size_t getComponentSize(ComponentID componentID) {
-    return typeInfoMap[componentID].size;
-  }
-
-  inline static std::vector<ComponentInfo> typeInfoMap{ComponentInfo{}};
-
- private:
-  inline static std::atomic<ComponentID> current_id = 1;
+  template <typename Component>
+  inline static const ComponentID componentID =
+      assignComponentID<Component>();
 };
 
 }  // namespace ecs
@@ -2,19 +2,34 @@
 
 #include <cstdint>
 
+// Define ECS_ENTITY_64 (the CMake option of the same name) for 64 bit entity
+// ids, 32 bits of index and 32 bits of generation instead of 24 and 8
 namespace ecs {
+#ifdef ECS_ENTITY_64
+using EntityID = uint64_t;
+#else
 using EntityID = uint32_t;
+#endif
 
 class Entity {
  public:
+#ifdef ECS_ENTITY_64
+  using physid_t = uint32_t;  // 32 bits physical id
+  using genid_t = uint32_t;   // 32 bits generational id
+
+  static constexpr unsigned ID_BITS = 32;
+#else
   using physid_t = uint32_t;  // 24 bits physical id
   using genid_t = uint8_t;    // 8 bits generational id
 
-  static const uint32_t GEN_MASK = 0xFF000000;
-  static const uint32_t ID_MASK = 0x00FFFFFF;
+  static constexpr unsigned ID_BITS = 24;
+#endif
+
+  static constexpr EntityID ID_MASK = (EntityID{1} << ID_BITS) - 1;
+  static constexpr EntityID GEN_MASK = ~ID_MASK;
 
   static EntityID createEntity(physid_t id = 0, genid_t gen = 0) {
-    return (static_cast<EntityID>(gen) << 24 | (id & ID_MASK));
+    return (static_cast<EntityID>(gen) << ID_BITS | (id & ID_MASK));
   }
 
   Entity() = delete;
@@ -24,12 +39,12 @@ class Entity {
 
   static physid_t getId(EntityID entityId) { return entityId & ID_MASK; }
 
-  static genid_t getGen(EntityID entityId) { return entityId >> 24; }
+  static genid_t getGen(EntityID entityId) { return entityId >> ID_BITS; }
 
   static EntityID incrementGen(EntityID entityId) {
     genid_t gen = getGen(entityId);
     gen++;
-    return (static_cast<EntityID>(gen) << 24) | getId(entityId);
+    return (static_cast<EntityID>(gen) << ID_BITS) | getId(entityId);
   }
 
   static void setId(EntityID *entityId, physid_t id) {
@@ -37,7 +52,7 @@ class Entity {
   }
 
   static void setGen(EntityID *entityId, genid_t gen) {
-    *entityId = (static_cast<EntityID>(gen) << 24) | (*entityId & ID_MASK);
+    *entityId = (static_cast<EntityID>(gen) << ID_BITS) | (*entityId & ID_MASK);
   }
 };
 }  // namespace ecs
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ecs {
+
+enum class ObserverEvent : uint8_t { Add, Remove, UpdateComponent };
+
+inline constexpr size_t OBSERVER_EVENT_COUNT = 3;
+
+// Event tags passed to Register::observe, e.g. observe<OnAdd<Position>>(...)
+template <typename Component> struct OnAdd {};
+
+template <typename Component> struct OnRemove {};
+
+// Raised when a value is handed to the register by createEntity,
+// addComponent or updateComponent. Writes through get, tryGet or each don't
+// raise it, eachChangedChunk finds the chunks those wrote.
+template <typename Component> struct OnUpdateComponent {};
+
+template <typename Event> struct ObserverEventTraits;
+
+template <typename C> struct ObserverEventTraits<OnAdd<C>> {
+  using Component = C;
+  static constexpr ObserverEvent event = ObserverEvent::Add;
+};
+
+template <typename C> struct ObserverEventTraits<OnRemove<C>> {
+  using Component = C;
+  static constexpr ObserverEvent event = ObserverEvent::Remove;
+};
+
+template <typename C> struct ObserverEventTraits<OnUpdateComponent<C>> {
+  using Component = C;
+  static constexpr ObserverEvent event = ObserverEvent::UpdateComponent;
+};
+
+}  // namespace ecs
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <bitset>
+
+#include "component.hpp"
+
+// Width of the archetype signatures, every component id has to be below it
+#ifndef ECS_MAX_COMPONENTS
+#define ECS_MAX_COMPONENTS 256
+#endif
+
+namespace ecs {
+
+using ComponentMask = std::bitset<ECS_MAX_COMPONENTS>;
+
+// Query terms, a bare component type in a query is the same as With<T>. A
+// const component is passed as a const reference and, unlike the other
+// terms, doesn't mark its rows as written for eachChangedChunk and snapshots.
+template <typename Component> struct With {};
+
+template <typename Component> struct Without {};
+
+// Matches archetypes with and without the component, each() passes a pointer
+// that is nullptr for entities that don't have it. Optional<const T> passes a
+// const pointer and doesn't mark anything as written.
+template <typename Component> struct Optional {};
+
+// Matches archetypes with a shared value of the component, each() passes a
+// const reference to the value of the archetype
+template <typename Component> struct Shared {};
+
+enum class QueryTermKind { With, Without, Optional, Shared };
+
+template <typename Term> struct QueryTerm {
+  using Component = Term;
+  static constexpr QueryTermKind kind = QueryTermKind::With;
+  static constexpr bool readOnly = false;
+};
+
+template <typename C> struct QueryTerm<const C> {
+  using Component = C;
+  static constexpr QueryTermKind kind = QueryTermKind::With;
+  static constexpr bool readOnly = true;
+};
+
+template <typename C> struct QueryTerm<With<C>> : QueryTerm<C> {};
+
+template <typename C> struct QueryTerm<Without<C>> {
+  using Component = C;
+  static constexpr QueryTermKind kind = QueryTermKind::Without;
+};
+
+template <typename C> struct QueryTerm<Optional<C>> {
+  using Component = C;
+  static constexpr QueryTermKind kind = QueryTermKind::Optional;
+  static constexpr bool readOnly = false;
+};
+
+template <typename C> struct QueryTerm<Optional<const C>> {
+  using Component = C;
+  static constexpr QueryTermKind kind = QueryTermKind::Optional;
+  static constexpr bool readOnly = true;
+};
+
+template <typename C> struct QueryTerm<Shared<C>> {
+  using Component = C;
+  static constexpr QueryTermKind kind = QueryTermKind::Shared;
+};
+
+}  // namespace ecs
@@ -1,11 +1,23 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <bit>
+#include <chrono>
+#include <concepts>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
 #include <memory>
+#include <memory_resource>
 #include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -13,6 +25,10 @@
 
 #include "component.hpp"
 #include "entity.hpp"
+#include "observer.hpp"
+#include "query.hpp"
+#include "shared.hpp"
+#include "stats.hpp"
 
 namespace ecs {
 
@@ -21,48 +37,120 @@ using ArchetypeId = uint32_t;
 
 struct Register {
  public:
+  // Copy of the rows of one column, owned by a register snapshot
+  struct ColumnSnapshot {
+    ColumnSnapshot(
+        const ComponentIDGenerator::ComponentInfo *info,
+        std::pmr::memory_resource *resource)
+        : info(info), resource(resource) {}
+
+    ~ColumnSnapshot() {
+      if (data != nullptr) {
+        info->dtor(data, count);
+        resource->deallocate(data, capacity * info->size, info->align);
+      }
+    }
+
+    ColumnSnapshot(const ColumnSnapshot &) = delete;
+    ColumnSnapshot &operator=(const ColumnSnapshot &) = delete;
+
+    ColumnSnapshot(ColumnSnapshot &&other) noexcept
+        : info(other.info), resource(other.resource), data(other.data),
+          count(other.count), capacity(other.capacity) {
+      other.data = nullptr;
+      other.count = 0;
+      other.capacity = 0;
+    }
+
+    ColumnSnapshot &operator=(ColumnSnapshot &&) = delete;
+
+    // Grows the buffer keeping the rows, only for trivially copyable columns
+    // since the rows are moved with memcpy
+    void reserve(size_t newCapacity) {
+      if (newCapacity <= capacity) {
+        return;
+      }
+      void *newData =
+          resource->allocate(newCapacity * info->size, info->align);
+      if (data != nullptr) {
+        std::memcpy(newData, data, count * info->size);
+        resource->deallocate(data, capacity * info->size, info->align);
+      }
+      data = newData;
+      capacity = newCapacity;
+    }
+
+    const ComponentIDGenerator::ComponentInfo *info;
+    std::pmr::memory_resource *resource;
+    void *data = nullptr;
+    size_t count = 0;
+    size_t capacity = 0;
+  };
+
   struct Column {
    public:
-    explicit Column(const ComponentIDGenerator::ComponentInfo *info)
-        : info(info), element_size(info->size) {
-      data = malloc(capacity * element_size);
+    // Rows per chunk, the unit snapshots track writes in
+    static constexpr size_t CHUNK_ROWS = 64;
+
+    // changeTick is the counter of the register, every chunk remembers its
+    // value from the last write so snapshots and eachChangedChunk can skip
+    // unchanged chunks
+    Column(
+        const ComponentIDGenerator::ComponentInfo *info,
+        std::pmr::memory_resource *resource,
+        const uint32_t *changeTick)
+        : element_size(info->size), info(info), resource(resource),
+          changeTick(changeTick), chunkVersions(resource) {
+      data = allocate(capacity);
     }
 
     ~Column() {
       if (info)
         info->dtor(data, count);
-      free(data);
+      deallocate(data, capacity);
     }
 
     Column(const Column &) = delete;
     Column &operator=(const Column &) = delete;
 
-    Column(Column &&other) noexcept {
+    Column(Column &&other) noexcept
+        : changeTick(other.changeTick),
+          chunkVersions(std::move(other.chunkVersions)) {
       data = other.data;
       element_size = other.element_size;
       count = other.count;
       capacity = other.capacity;
       info = other.info;
+      resource = other.resource;
       other.data = nullptr;  // prevent double free
+      other.count = 0;
     }
 
     Column &operator=(Column &&other) noexcept {
       if (this != &other) {
         if (info)
           info->dtor(data, count);
-        free(data);
+        deallocate(data, capacity);
         data = other.data;
         element_size = other.element_size;
         count = other.count;
         capacity = other.capacity;
         info = other.info;
+        resource = other.resource;
+        changeTick = other.changeTick;
+        chunkVersions = std::move(other.chunkVersions);
         other.data = nullptr;
+        other.count = 0;
       }
       return *this;
     }
 
     size_t size() { return count; }
 
+    size_t getCapacity() const { return capacity; }
+
+    size_t getElementSize() const { return element_size; }
+
     void *at(size_t index) const {
       if (index > count) {
         return nullptr;
@@ -70,6 +158,10 @@ struct Register {
       return static_cast<char *>(data) + index * element_size;
     }
 
+    template <typename Component> Component *componentData() {
+      return static_cast<Component *>(data);
+    }
+
     template <typename Component> Component *atComponent(size_t index) {
       if (index >= count) {
         return nullptr;
@@ -77,67 +169,180 @@ struct Register {
       return &(reinterpret_cast<Component *>(data))[index];
     }
 
-    void swapWithLastElement(size_t row) {
-      if (count == 0) {
-        return;
-      }
-      info->dtor(at(row), 1);
-      info->move(at(row), at(count - 1), 1);
-
-      // if (count > 16 && count < capacity / 4) {
-      //   data = reallocarray(data, capacity / 2, element_size);
-      //   capacity /= 2;
-      // }
-    }
-
     void pushBack(const Column &inputColumn, size_t index) {
       if (count >= capacity) {
-        void *new_data = reallocarray(data, capacity * 2, element_size);
-        if (new_data == nullptr) {
-          // handle memory error
-          return;
-        }
-        data = new_data;
-        capacity *= 2;
+        reallocate(capacity * 2);
       }
-      info->ctor(at(count), 1);
       info->move(at(count), inputColumn.at(index), 1);
+      markDirty(count);
       count++;
     }
 
     template <typename Component> void pushBackComponent(Component *component) {
       if (count >= capacity) {
-        data = reallocarray(data, capacity * 2, element_size);
-        capacity *= 2;
+        reallocate(capacity * 2);
       }
-      info->ctor(at(count), 1);
       info->move(at(count), component, 1);
+      markDirty(count);
       count++;
     }
 
     template <typename Component>
     void updateElement(Component *component, size_t index) {
-      if (index >= capacity) {
+      if (index >= count) {
         return;
       }
       info->dtor(at(index), 1);
       info->move(at(index), component, 1);
+      markDirty(index);
     }
 
+    // Snapshots and eachChangedChunk only look at the chunks written since
+    // they last looked. Everything that writes through componentData has to
+    // mark the rows, the register does it for get, each and structural changes.
+    void markDirty(size_t row) {
+      size_t chunk = row / CHUNK_ROWS;
+      if (chunk >= chunkVersions.size()) {
+        chunkVersions.resize(chunk + 1);
+      }
+      chunkVersions[chunk] = *changeTick;
+    }
+
+    void markAllDirty() {
+      if (count == 0) {
+        return;
+      }
+      size_t chunkCount = (count + CHUNK_ROWS - 1) / CHUNK_ROWS;
+      if (chunkCount > chunkVersions.size()) {
+        chunkVersions.resize(chunkCount);
+      }
+      std::fill_n(chunkVersions.begin(), chunkCount, *changeTick);
+    }
+
+    // Calls function(begin, end) for every chunk of rows written after
+    // sinceTick
+    template <typename Function>
+    void eachChunkChangedSince(uint32_t sinceTick, Function &&function) const {
+      for (size_t begin = 0; begin < count; begin += CHUNK_ROWS) {
+        size_t chunk = begin / CHUNK_ROWS;
+        if (chunk < chunkVersions.size() && chunkVersions[chunk] <= sinceTick) {
+          continue;
+        }
+        function(begin, std::min(count, begin + CHUNK_ROWS));
+      }
+    }
+
+    void clear() {
+      info->dtor(data, count);
+      count = 0;
+    }
+
+    // Copies the rows into the snapshot, which has to hold the rows as of
+    // sinceTick (0 for an empty one). Trivially copyable columns only copy the
+    // chunks written after it, other columns are copy constructed whole.
+    void saveTo(ColumnSnapshot &snapshot, uint32_t sinceTick) const {
+      if (info->copy == nullptr) {
+        throw std::runtime_error(
+            "component " + std::string(info->name) +
+            " can't be copied into a snapshot");
+      }
+      if (!info->triviallyCopyable) {
+        info->dtor(snapshot.data, snapshot.count);
+        snapshot.count = 0;
+        snapshot.reserve(count);
+        info->copy(snapshot.data, data, count);
+        snapshot.count = count;
+        return;
+      }
+
+      snapshot.reserve(count);
+      for (size_t begin = 0; begin < count; begin += CHUNK_ROWS) {
+        size_t chunk = begin / CHUNK_ROWS;
+        size_t end = std::min(count, begin + CHUNK_ROWS);
+        if (end <= snapshot.count && chunk < chunkVersions.size() &&
+            chunkVersions[chunk] <= sinceTick) {
+          continue;
+        }
+        std::memcpy(
+            static_cast<char *>(snapshot.data) + begin * element_size,
+            at(begin),
+            (end - begin) * element_size);
+      }
+      snapshot.count = count;
+    }
+
+    // Brings the rows back to a snapshot taken at snapshotTick. Trivially
+    // copyable columns only copy the chunks written since then or missing
+    // rows, the restored chunks count as written so every other snapshot
+    // picks them up again.
+    void restoreFrom(const ColumnSnapshot &snapshot, uint32_t snapshotTick) {
+      if (!info->triviallyCopyable) {
+        clear();
+        reserve(snapshot.count);
+        info->copy(data, snapshot.data, snapshot.count);
+        count = snapshot.count;
+        markAllDirty();
+        return;
+      }
+
+      reserve(snapshot.count);
+      for (size_t begin = 0; begin < snapshot.count; begin += CHUNK_ROWS) {
+        size_t chunk = begin / CHUNK_ROWS;
+        size_t end = std::min(snapshot.count, begin + CHUNK_ROWS);
+        if (end <= count && chunk < chunkVersions.size() &&
+            chunkVersions[chunk] <= snapshotTick) {
+          continue;
+        }
+        std::memcpy(
+            static_cast<char *>(data) + begin * element_size,
+            static_cast<const char *>(snapshot.data) + begin * element_size,
+            (end - begin) * element_size);
+        markDirty(begin);
+      }
+      count = snapshot.count;
+    }
+
+    // Destroys the element and fills the hole with the last element. Also used
+    // after the element was moved to another archetype, in that case it
+    // destroys the moved from leftover
     void deleteElement(size_t index) {
       if (count == 0 || index >= count)
         return;
 
+      info->dtor(at(index), 1);
       if (index != count - 1) {
         info->move(at(index), at(count - 1), 1);
+        info->dtor(at(count - 1), 1);
+        markDirty(index);
       }
+      count--;
+    }
 
-      // resize
-      if (count > 16 && count < capacity / 4) {
-        data = reallocarray(data, capacity / 2, element_size);
-        capacity /= 2;
+    void swapElements(size_t a, size_t b) {
+      info->swap(at(a), at(b));
+      markDirty(a);
+      markDirty(b);
+    }
+
+    // Gives memory back once the column is mostly empty. Growing doubles at
+    // full capacity while shrinking only happens under a quarter of it, so a
+    // column that hovers around a size doesn't keep reallocating
+    bool shrink() {
+      if (capacity <= MIN_CAPACITY || count >= capacity / 4) {
+        return false;
       }
-      count--;
+      reallocate(std::max(MIN_CAPACITY, std::bit_ceil(count * 2)));
+      return true;
+    }
+
+    // Makes room for at least newCapacity elements without further growth,
+    // including the chunk bookkeeping writes to them touch
+    void reserve(size_t newCapacity) {
+      if (newCapacity > capacity) {
+        reallocate(newCapacity);
+      }
+      size_t chunkCount = (newCapacity + CHUNK_ROWS - 1) / CHUNK_ROWS;
+      chunkVersions.reserve(chunkCount);
     }
 
     template <typename Component> struct ColumnIterable {
@@ -196,17 +401,56 @@ struct Register {
     }
 
    private:
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    size_t alignment() const { return std::max<size_t>(info->align, 1); }
+
+    void *allocate(size_t elementCount) {
+      return resource->allocate(elementCount * element_size, alignment());
+    }
+
+    void deallocate(void *elements, size_t elementCount) {
+      if (elements != nullptr) {
+        resource->deallocate(
+            elements, elementCount * element_size, alignment());
+      }
+    }
+
+    // Moves the elements to a new allocation, memory resources can't grow an
+    // allocation in place like realloc does
+    void reallocate(size_t newCapacity) {
+      void *new_data = allocate(newCapacity);
+      info->move(new_data, data, count);
+      info->dtor(data, count);
+      deallocate(data, capacity);
+      data = new_data;
+      capacity = newCapacity;
+    }
+
     void *data = nullptr;
     size_t element_size = 0;
 
     size_t count = 0;
-    size_t capacity = 16;
+    size_t capacity = MIN_CAPACITY;
     const ComponentIDGenerator::ComponentInfo *info = nullptr;
+    std::pmr::memory_resource *resource = nullptr;
+
+    const uint32_t *changeTick = nullptr;
+    // Tick of the last write of every CHUNK_ROWS rows
+    std::pmr::vector<uint32_t> chunkVersions;
   };  // namespace ecs
 
   // Basically a sorted vector of component ids
   struct Type {
    public:
+    Type() = default;
+
+    explicit Type(std::pmr::memory_resource *resource)
+        : componentIDs(resource) {}
+
+    Type(const Type &other, std::pmr::memory_resource *resource)
+        : componentIDs(other.componentIDs, resource) {}
+
     size_t size() const { return componentIDs.size(); }
 
     auto begin() { return componentIDs.begin(); }
@@ -222,24 +466,40 @@ struct Register {
       return std::distance(componentIDs.begin(), it);
     }
 
-    Type clone() {
-      Type clonedType;
-      clonedType.componentIDs = componentIDs;
-      return clonedType;
+    bool contains(ComponentID id) const {
+      return std::binary_search(componentIDs.begin(), componentIDs.end(), id);
+    }
+
+    Type clone(std::pmr::memory_resource *resource) const {
+      return Type(*this, resource);
     }
 
     bool operator==(const Type &other) const {
       return componentIDs == other.componentIDs;
     }
 
-    std::vector<Column> initComponentVector() {
-      std::vector<Column> returnColumn;
+    // Shared pairs sort after every component id because of their flag bit,
+    // so the columns line up with the first ids of the type
+    size_t columnCount() const {
+      return std::distance(
+          componentIDs.begin(),
+          std::lower_bound(
+              componentIDs.begin(), componentIDs.end(), SHARED_PAIR_FLAG));
+    }
+
+    std::pmr::vector<Column> initComponentVector(
+        std::pmr::memory_resource *resource, const uint32_t *changeTick) {
+      std::pmr::vector<Column> returnColumn(resource);
+      returnColumn.reserve(columnCount());
       std::transform(
           componentIDs.begin(),
-          componentIDs.end(),
+          componentIDs.begin() + columnCount(),
           std::back_inserter(returnColumn),
-          [](auto componentID) {
-            return Column(&ComponentIDGenerator::typeInfoMap[componentID]);
+          [resource, changeTick](auto componentID) {
+            return Column(
+                &ComponentIDGenerator::getComponentInfo(componentID),
+                resource,
+                changeTick);
           });
       return returnColumn;
     }
@@ -268,7 +528,7 @@ struct Register {
     }
 
    private:
-    std::vector<ComponentID> componentIDs;
+    std::pmr::vector<ComponentID> componentIDs;
   };
 
   struct Archetype;
@@ -283,37 +543,102 @@ struct Register {
     Type type;
     // void pointer to be cast to the right value later on, it is the same
     // order as the type variable
-    std::vector<Column> components;
-    // Store the entities list
-    std::vector<EntityID> entities;
-    std::unordered_map<ComponentID, ArchetypeEdge> edges;
-
-    Archetype() { entities.push_back(Entity::createEntity(0, 0)); }
+    std::pmr::vector<Column> components;
+    // Store the entities list, entities[row] owns the row in every column
+    std::pmr::vector<EntityID> entities;
+    std::pmr::unordered_map<ComponentID, ArchetypeEdge> edges;
+    // One bit per row, set while the entity of the row is enabled
+    std::pmr::vector<uint64_t> enabledRows;
+    size_t disabledCount = 0;
+    // One bit per component of the type, what queries are matched against
+    ComponentMask mask;
+    // One bit per component the archetype has a shared value of
+    ComponentMask sharedMask;
+    // Column of each component id, NO_COLUMN for components not in the type.
+    // Only sized up to the largest component id of the type
+    std::pmr::vector<uint16_t> columnIndex;
+    // Set while the archetype waits in the maintenance queue of the register
+    bool queuedForMaintenance = false;
+
+    explicit Archetype(std::pmr::memory_resource *resource)
+        : type(resource), components(resource), entities(resource),
+          edges(resource), enabledRows(resource), columnIndex(resource) {}
+
+    static constexpr uint16_t NO_COLUMN = UINT16_MAX;
 
     size_t size() { return entities.size(); }
 
     template <typename Component> auto findComponents() {
-      size_t row = type.find(ComponentIDGenerator::getComponentID<Component>());
-      return components[row].iter<Component>();
+      return getColumn<Component>().template iter<Component>();
     }
 
+    // The archetype has to have the component
+    template <typename Component> Column &getColumn() {
+      return components
+          [columnIndex[ComponentIDGenerator::getComponentID<Component>()]];
+    }
+
+    // nullptr if the component isn't part of the type
+    Column *findColumn(ComponentID componentID) {
+      if (componentID >= columnIndex.size() ||
+          columnIndex[componentID] == NO_COLUMN) {
+        return nullptr;
+      }
+      return &components[columnIndex[componentID]];
+    }
+
+    // The pair id of the shared value of the component, 0 if there is none
+    ComponentID findSharedPair(ComponentID componentID) const {
+      if (componentID >= ECS_MAX_COMPONENTS || !sharedMask.test(componentID)) {
+        return 0;
+      }
+      return *std::lower_bound(
+          type.begin(), type.end(), makeSharedPair(componentID, 0));
+    }
+
+    // Removes the row by moving the last row into it, returns the entity that
+    // now lives in the row (the deleted one itself if it was the last row)
     EntityID deleteElement(size_t row) {
-      for (int i = 0; i < components.size(); i++) {
+      for (size_t i = 0; i < components.size(); i++) {
         components[i].deleteElement(row);
       }
-      EntityID changedEntity = entities[entities.size() - 1];
+      size_t lastRow = entities.size() - 1;
+      if (!isRowEnabled(row)) {
+        disabledCount--;
+      }
+      setRowBit(row, isRowEnabled(lastRow));
+      setRowBit(lastRow, false);
+      if (lastRow % 64 == 0) {
+        enabledRows.pop_back();
+      }
+      EntityID changedEntity = entities[lastRow];
       entities[row] = changedEntity;
       entities.pop_back();
       return changedEntity;
     }
 
-    EntityID swapWithLastElement(size_t row) {
-      for (int i = 0; i < components.size(); i++) {
-        components[i].swapWithLastElement(row);
+    bool isRowEnabled(size_t row) const {
+      return (enabledRows[row / 64] >> (row % 64)) & 1;
+    }
+
+    void setRowEnabled(size_t row, bool enabled) {
+      if (isRowEnabled(row) != enabled) {
+        disabledCount += enabled ? -1 : 1;
+        setRowBit(row, enabled);
+      }
+    }
+
+    // Appends the entity of a new row, the columns are filled by the caller
+    void pushEntity(EntityID entity, bool enabled = true) {
+      size_t row = entities.size();
+      if (row % 64 == 0) {
+        enabledRows.push_back(0);
+      }
+      entities.push_back(entity);
+      setRowBit(row, enabled);
+      if (!enabled) {
+        disabledCount++;
       }
-      EntityID changedEntity = entities[entities.size() - 1];
-      entities[row] = changedEntity;
-      return changedEntity;
     }
 
     // Adds a value to the archetype given the archetype the components resides
@@ -326,7 +651,7 @@ struct Register {
       size_t component_index =
           type.find(ComponentIDGenerator::getComponentID<Component>());
       components[component_index].pushBackComponent<Component>(&component);
-      entities.push_back(entityID);
+      pushEntity(entityID);
     }
 
     // Adds a value to the archetype given the archetype the components resides
@@ -340,7 +665,8 @@ struct Register {
         size_t component_index =
             type.find(ComponentIDGenerator::getComponentID<Component>());
         components[component_index].pushBackComponent<Component>(&component);
-        entities.push_back(oldArchetype.entities[row]);
+        pushEntity(
+            oldArchetype.entities[row], oldArchetype.isRowEnabled(row));
         return;
       }
 
@@ -348,7 +674,7 @@ struct Register {
       auto &newType = type;
       auto &oldComponents = oldArchetype.components;
       auto &oldType = oldArchetype.type;
-      for (int i = 0, j = 0; i < newComponents.size(); i++) {
+      for (size_t i = 0, j = 0; i < newComponents.size(); i++) {
         if (j < oldComponents.size() && newType[i] == oldType[j]) {
           newComponents[i].pushBack(oldComponents[j], row);
 
@@ -357,7 +683,7 @@ struct Register {
           newComponents[i].pushBackComponent<Component>(&component);
         }
       }
-      entities.push_back(oldArchetype.entities[row]);
+      pushEntity(oldArchetype.entities[row], oldArchetype.isRowEnabled(row));
     }
 
     // Adds a value to the archetype given the archetype the components resides
@@ -368,202 +694,1425 @@ struct Register {
       auto &newType = type;
       auto &oldComponents = oldArchetype.components;
       auto &oldType = oldArchetype.type;
-      for (int i = 0, j = 0; i < oldComponents.size(); i++) {
-        if (newType[j] == oldType[i]) {
-          newComponents[i].pushBack(oldComponents[j], row);
+      for (size_t i = 0, j = 0; i < oldComponents.size(); i++) {
+        if (j < newComponents.size() && newType[j] == oldType[i]) {
+          newComponents[j].pushBack(oldComponents[i], row);
           j++;
         }
       }
+      pushEntity(oldArchetype.entities[row], oldArchetype.isRowEnabled(row));
+    }
+
+    // Exchanges two rows in every column, the entity index has to be fixed up
+    // by the caller
+    void swapRows(size_t a, size_t b) {
+      for (auto &column : components) {
+        column.swapElements(a, b);
+      }
+      std::swap(entities[a], entities[b]);
+      bool enabledA = isRowEnabled(a);
+      setRowBit(a, isRowEnabled(b));
+      setRowBit(b, enabledA);
+    }
+
+    // Shrinks the columns that are mostly empty, returns true if any did
+    bool shrinkColumns() {
+      bool shrunk = false;
+      for (auto &column : components) {
+        shrunk |= column.shrink();
+      }
+      if (entities.capacity() > 16 &&
+          entities.size() < entities.capacity() / 4) {
+        entities.shrink_to_fit();
+        enabledRows.shrink_to_fit();
+        shrunk = true;
+      }
+      return shrunk;
+    }
+
+    void reserve(size_t rowCount) {
+      for (auto &column : components) {
+        column.reserve(rowCount);
+      }
+      entities.reserve(rowCount);
+      enabledRows.reserve((rowCount + 63) / 64);
+    }
+
+   private:
+    void setRowBit(size_t row, bool enabled) {
+      uint64_t bit = uint64_t{1} << (row % 64);
+      if (enabled) {
+        enabledRows[row / 64] |= bit;
+      } else {
+        enabledRows[row / 64] &= ~bit;
+      }
     }
   };
 
+  // Slot of the entity index, archetype is nullptr while the slot is free
   struct Record {
-    Archetype *archetype;
-    size_t row;
+    Archetype *archetype = nullptr;
+    size_t row = 0;
+    // Id with the generation that currently owns the slot
+    EntityID entity = 0;
   };
 
-  template <typename Component> EntityID createEntity(Component &component) {
-    // Find the id of the entity
-    EntityID newEntity;
-    if (deletedEntities.empty()) {
-      newEntity = nextId;
-      nextId++;
-    } else {
-      // pop the last element and use it
-      newEntity = deletedEntities[deletedEntities.size() - 1];
-      newEntity = Entity::incrementGen(newEntity);
-      deletedEntities.pop_back();
+  Register() : Register(std::pmr::get_default_resource()) {}
+
+  // Every allocation of the register, column storage included, goes through
+  // the given resource. With an arena the whole world is released at once when
+  // the arena is dropped after the register. Left out are the objects holding
+  // the shared values of each component (not their values), the targets of
+  // observer callbacks and the process wide component registry.
+  explicit Register(std::pmr::memory_resource *resource)
+      : resource(resource), baseArchetype(resource), deletedEntities(resource),
+        entityIndex(resource), archetypeIndex(resource),
+        componentIndex(resource), maintenanceQueue(resource),
+        queries(resource), querySlots(resource), sharedStorages(resource),
+        snapshots(resource), snapshotLookup(resource),
+        snapshotScratch(resource), restoredArchetypes(resource),
+        observerChannels(resource), observerPending(resource),
+        observerEntries(resource), observerEntities(resource),
+        deferredObservers(resource) {}
+
+  // Archetypes point at each other and at the base archetype
+  Register(const Register &) = delete;
+  Register &operator=(const Register &) = delete;
+
+  // Scratch memory for work that is done within the frame, like the keys of
+  // sort. Systems can take their temporaries from it too. The engine points
+  // it at its frame arena, memory from it must not be kept across frames.
+  void setFrameResource(std::pmr::memory_resource *frameResource) {
+    this->frameResource = frameResource;
+  }
+
+  std::pmr::memory_resource *getFrameResource() const { return frameResource; }
+
+  // Sizes the archetype of exactly these components for rowCount entities, so
+  // filling it doesn't go through the column growth steps one by one
+  template <typename... Components> void reserve(size_t rowCount) {
+    assertNotIterating();
+    Type type(frameResource);
+    (type.add(ComponentIDGenerator::getComponentID<Components>()), ...);
+    Archetype *archetype = getOrCreateArchetype(type);
+    if (rowCount > archetype->size()) {
+      archetype->reserve(rowCount);
+      entityIndex.reserve(nextId + rowCount - archetype->size());
     }
+  }
+
+  // Entity without components, it stays in the base archetype until the first
+  // component or shared value is added
+  EntityID createEntity() {
+    assertNotIterating();
+    EntityID newEntity = allocateEntityId();
+    size_t row = baseArchetype.size();
+    baseArchetype.pushEntity(newEntity);
+    setRecord(Record{&baseArchetype, row, newEntity});
+    frameCounters.entitiesCreated++;
+    return newEntity;
+  }
+
+  template <typename Component> EntityID createEntity(Component &component) {
+    assertNotIterating();
+    EntityID newEntity = allocateEntityId();
 
     // find the archetype if it exists
-    auto &edgesMap = baseArchetype.edges;
     ComponentID componentID = ComponentIDGenerator::getComponentID<Component>();
-    auto it = edgesMap.find(componentID);
-    Archetype *newArchetype;
-    if (it != edgesMap.end()) {
-      newArchetype = it->second.edge;
-    } else {
-      Type newType = Type();
-      newType.add(componentID);
-      // if it doesnt exist create a new archetype and insert it to the map
-      auto [itArche, inserted] = archetypeIndex.emplace(
-          std::move(newType), std::make_unique<Archetype>());
-      newArchetype = itArche->second.get();
-      if (inserted) {
-        newArchetype->type = itArche->first;  // The key Type
-        newArchetype->components = newArchetype->type.initComponentVector();
-        newArchetype->edges.emplace(componentID, ArchetypeEdge{&baseArchetype});
-        componentIndex[componentID].emplace(newArchetype);
-      }
-      baseArchetype.edges.emplace(componentID, ArchetypeEdge{newArchetype});
-    }
+    Archetype *newArchetype = traverseEdge(&baseArchetype, componentID, true);
     size_t row = newArchetype->size();
 
-    // and create a record
-    Record record = Record();
-    record.archetype = newArchetype;
-    record.row = row;
-
     newArchetype->copyValueFromBaseArchetype<Component>(
         baseArchetype, component, newEntity);
 
-    // update the EntityIndex map
-    entityIndex[newEntity] = record;
+    // update the entity index
+    setRecord(Record{newArchetype, row, newEntity});
+    frameCounters.entitiesCreated++;
+    recordObserverEvent(componentID, ObserverEvent::Add, newEntity);
+    recordObserverEvent(
+        componentID, ObserverEvent::UpdateComponent, newEntity);
 
     return newEntity;
   }
 
   void deleteEntity(EntityID entity) {
-    Record &record = entityIndex[entity];
+    assertNotIterating();
+    Record &record = getRecord(entity);
     Archetype *archetype = record.archetype;
-    entityIndex[archetype->deleteElement(record.row)].row = record.row;
-    entityIndex.erase(entity);
+    if (hasRemoveObservers) {
+      for (ComponentID componentID : archetype->type) {
+        recordObserverEvent(componentID, ObserverEvent::Remove, entity);
+      }
+    }
+    getRecord(archetype->deleteElement(record.row)).row = record.row;
+    record = Record{};
     deletedEntities.push_back(entity);
+    frameCounters.entitiesDeleted++;
+    queueMaintenance(archetype);
+  }
+
+  bool isEntityAlive(EntityID entity) { return findRecord(entity) != nullptr; }
+
+  // Disabled entities keep their row and components but are skipped by each(),
+  // toggling never moves data between archetypes
+  void setEnabled(EntityID entity, bool enabled) {
+    Record &record = getRecord(entity);
+    if (record.archetype->isRowEnabled(record.row) == enabled) {
+      return;
+    }
+    record.archetype->setRowEnabled(record.row, enabled);
+    // A toggle counts as a write of the row, so eachChangedChunk sees it
+    for (Column &column : record.archetype->components) {
+      column.markDirty(record.row);
+    }
   }
 
-  bool isEntityAlive(EntityID entity) {
-    return entityIndex.find(entity) != entityIndex.end();
+  void enable(EntityID entity) { setEnabled(entity, true); }
+
+  void disable(EntityID entity) { setEnabled(entity, false); }
+
+  bool isEnabled(EntityID entity) {
+    Record &record = getRecord(entity);
+    return record.archetype->isRowEnabled(record.row);
+  }
+
+  // tryGet for entities that might be gone or lack the component
+  // @throws std::runtime_error if the entity is dead, including ids whose slot
+  // was reused, or doesn't have the component
+  template <typename Component> Component &get(EntityID entity) {
+    Component *component = tryGet<Component>(entity);
+    if (component == nullptr) {
+      throw std::runtime_error(
+          "entity is dead or has no " +
+          std::string(getTypeName<std::remove_const_t<Component>>()));
+    }
+    return *component;
+  }
+
+  // nullptr if the entity is dead or doesn't have the component. The pointer
+  // is invalidated by the next structural change of its archetype. Like in
+  // each(), tryGet<const T> reads without marking the row as written, so
+  // eachChangedChunk and snapshots don't see a change.
+  template <typename Component> Component *tryGet(EntityID entity) {
+    Record *record = findRecord(entity);
+    if (record == nullptr) {
+      return nullptr;
+    }
+    Column *column = record->archetype->findColumn(
+        ComponentIDGenerator::getComponentID<std::remove_const_t<Component>>());
+    if (column == nullptr) {
+      return nullptr;
+    }
+    if constexpr (!std::is_const_v<Component>) {
+      column->markDirty(record->row);
+    }
+    return column->componentData<Component>() + record->row;
+  }
+
+  template <typename Component> bool has(EntityID entity) {
+    Record *record = findRecord(entity);
+    return record != nullptr &&
+           record->archetype->findColumn(
+               ComponentIDGenerator::getComponentID<Component>()) != nullptr;
   }
 
   // it isnt safe and might cause unexpected bugs if tried to add components
   // that exist
   template <typename Component>
   void addComponent(Component component, EntityID entity) {
-    Record &record = entityIndex[entity];
-    auto &edgesMap = record.archetype->edges;
+    assertNotIterating();
+    Record &record = getRecord(entity);
     ComponentID componentID = ComponentIDGenerator::getComponentID<Component>();
-    auto it = edgesMap.find(componentID);
     Archetype *oldArchetype = record.archetype;
-    Archetype *newArchetype;
-    if (it != edgesMap.end()) {
-      newArchetype = it->second.edge;
-    } else {
-      Type newType = oldArchetype->type.clone();
-      newType.add(ComponentIDGenerator::getComponentID<Component>());
-      // if it doesnt exist create a new archetype and insert it to the map
-      auto [itArche, inserted] = archetypeIndex.emplace(
-          std::move(newType), std::make_unique<Archetype>());
-      newArchetype = itArche->second.get();
-      if (inserted) {
-        newArchetype->type = itArche->first;  // The key Type
-        newArchetype->components = newArchetype->type.initComponentVector();
-        newArchetype->edges.emplace(componentID, ArchetypeEdge{oldArchetype});
-        componentIndex[componentID].emplace(newArchetype);
-      }
-      oldArchetype->edges.emplace(componentID, ArchetypeEdge{newArchetype});
-    }
+    Archetype *newArchetype = traverseEdge(oldArchetype, componentID, true);
+    size_t oldRow = record.row;
 
-    newArchetype->copyValue<Component>(*oldArchetype, component, record.row);
-    entityIndex[oldArchetype->swapWithLastElement(record.row)].row = record.row;
-    record.archetype = newArchetype;
+    newArchetype->copyValue<Component>(*oldArchetype, component, oldRow);
+    getRecord(oldArchetype->deleteElement(oldRow)).row = oldRow;
+    queueMaintenance(oldArchetype);
+    frameCounters.componentsAdded++;
+    recordObserverEvent(componentID, ObserverEvent::Add, entity);
+    recordObserverEvent(componentID, ObserverEvent::UpdateComponent, entity);
 
     // update the EntityIndex map
-    entityIndex[entity].archetype = newArchetype;
-    entityIndex[entity].row = newArchetype->components[0].size() - 1;
+    record.archetype = newArchetype;
+    record.row = newArchetype->size() - 1;
   }
 
   template <typename Component>
   void updateComponent(Component component, EntityID entity) {
-    Record &entityRecord = entityIndex[entity];
-    Archetype &entityArchetype = *entityRecord.archetype;
-    Column &componentColumn =
-        entityArchetype.components[entityArchetype.type.find(
-            ComponentIDGenerator::getComponentID<Component>())];
-    componentColumn.updateElement<Component>(component, entityRecord.row);
+    Record &entityRecord = getRecord(entity);
+    Column &componentColumn = entityRecord.archetype->getColumn<Component>();
+    componentColumn.updateElement<Component>(&component, entityRecord.row);
+    recordObserverEvent(
+        ComponentIDGenerator::getComponentID<Component>(),
+        ObserverEvent::UpdateComponent,
+        entity);
   }
 
   // it isnt safe and might cause unexpected bugs if tried to delete components
   // that doesnt exist
   template <typename Component> void deleteComponent(EntityID entity) {
-    Record &record = entityIndex[entity];
-    auto &edgesMap = record.archetype->edges;
+    assertNotIterating();
+    Record &record = getRecord(entity);
     ComponentID componentID = ComponentIDGenerator::getComponentID<Component>();
-    auto it = edgesMap.find(componentID);
-    Archetype *newArchetype;
     Archetype *oldArchetype = record.archetype;
-    if (it != edgesMap.end()) {
-      newArchetype = it->second.edge;
+    Archetype *newArchetype = traverseEdge(oldArchetype, componentID, false);
+    size_t oldRow = record.row;
+
+    newArchetype->copyValue(*oldArchetype, oldRow);
+    getRecord(oldArchetype->deleteElement(oldRow)).row = oldRow;
+    queueMaintenance(oldArchetype);
+    frameCounters.componentsRemoved++;
+    recordObserverEvent(componentID, ObserverEvent::Remove, entity);
+
+    // update the EntityIndex map
+    record.archetype = newArchetype;
+    record.row = newArchetype->size() - 1;
+  }
+
+  // Stores a value entities can share with setShared. Equal values are only
+  // stored once, values live as long as the register
+  template <typename Component>
+  SharedHandle<Component> addSharedValue(Component value) {
+    auto &values = getSharedStorage<Component>().values;
+    if constexpr (std::equality_comparable<Component>) {
+      for (uint32_t i = 0; i < values.size(); i++) {
+        if (values[i] == value) {
+          return SharedHandle<Component>{i};
+        }
+      }
+    }
+    if (values.size() > SHARED_VALUE_MASK) {
+      throw std::runtime_error("too many shared values for one component");
+    }
+    values.push_back(std::move(value));
+    return SharedHandle<Component>{static_cast<uint32_t>(values.size() - 1)};
+  }
+
+  // Moves the entity to the archetype of the shared value, replacing the
+  // value it had for the component
+  template <typename Component>
+  void setShared(EntityID entity, SharedHandle<Component> handle) {
+    assertNotIterating();
+    Record &record = getRecord(entity);
+    ComponentID componentID = ComponentIDGenerator::getComponentID<Component>();
+    ComponentID pair = makeSharedPair(componentID, handle.index);
+    Archetype *oldArchetype = record.archetype;
+    ComponentID oldPair = oldArchetype->findSharedPair(componentID);
+    if (oldPair == pair) {
+      return;
+    }
+
+    Archetype *newArchetype;
+    if (oldPair == 0) {
+      newArchetype = traverseEdge(oldArchetype, pair, true);
+      frameCounters.componentsAdded++;
     } else {
-      Type newType = oldArchetype->type.clone();
-      newType.remove(ComponentIDGenerator::getComponentID<Component>());
-      auto [itArche, inserted] = archetypeIndex.emplace(
-          std::move(newType), std::make_unique<Archetype>());
-      newArchetype = itArche->second.get();
-      if (inserted) {
-        newArchetype->type = itArche->first;  // The key Type
-        newArchetype->components = newArchetype->type.initComponentVector();
-        newArchetype->edges.emplace(componentID, ArchetypeEdge{oldArchetype});
-        componentIndex[componentID].emplace(newArchetype);
+      Type newType = oldArchetype->type.clone(frameResource);
+      newType.remove(oldPair);
+      newType.add(pair);
+      newArchetype = getOrCreateArchetype(newType);
+    }
+    moveEntity(record, newArchetype);
+  }
+
+  template <typename Component> void removeShared(EntityID entity) {
+    assertNotIterating();
+    Record &record = getRecord(entity);
+    ComponentID pair = record.archetype->findSharedPair(
+        ComponentIDGenerator::getComponentID<Component>());
+    if (pair == 0) {
+      return;
+    }
+    moveEntity(record, traverseEdge(record.archetype, pair, false));
+    frameCounters.componentsRemoved++;
+  }
+
+  // The shared value every entity of the archetype uses, nullptr if it has
+  // none for the component
+  template <typename Component>
+  const Component *getShared(const Archetype &archetype) {
+    ComponentID pair = archetype.findSharedPair(
+        ComponentIDGenerator::getComponentID<Component>());
+    if (pair == 0) {
+      return nullptr;
+    }
+    return &getSharedStorage<Component>().values[getSharedValueIndex(pair)];
+  }
+
+  template <typename Component>
+  const Component *getShared(EntityID entity) {
+    Record *record = findRecord(entity);
+    return record == nullptr ? nullptr
+                             : getShared<Component>(*record->archetype);
+  }
+
+  // Keeps the last frameCount snapshots, older ones are overwritten. The
+  // buffers of a slot are reused when it comes around again, so after the ring
+  // filled once taking snapshots stops allocating unless the world grows.
+  void setSnapshotFrames(size_t frameCount) {
+    snapshots.clear();
+    snapshots.reserve(frameCount);
+    for (size_t i = 0; i < frameCount; i++) {
+      snapshots.emplace_back(resource);
+    }
+    lastSnapshotFrame = 0;
+  }
+
+  // Saves the entities and every column into the next slot of the ring. Only
+  // the chunks written since the slot was last filled are copied, trivially
+  // copyable components with memcpy. Shared values are not saved, they never
+  // change once added.
+  // @return The frame number to pass to restore
+  // @throws std::runtime_error without a ring or for components that can't be
+  // copied
+  uint64_t snapshot() {
+    if (snapshots.empty()) {
+      throw std::runtime_error("snapshot ring has no frames");
+    }
+    uint64_t frame = lastSnapshotFrame + 1;
+    WorldSnapshot &slot = snapshots[frame % snapshots.size()];
+    uint32_t sinceTick = slot.tick;
+
+    snapshotLookup.clear();
+    for (size_t i = 0; i < slot.archetypes.size(); i++) {
+      snapshotLookup.emplace(slot.archetypes[i].archetype, i);
+    }
+    snapshotScratch.clear();
+    auto saveArchetype = [&](Archetype &archetype) {
+      if (archetype.size() == 0) {
+        return;
+      }
+      auto it = snapshotLookup.find(&archetype);
+      bool reuse = it != snapshotLookup.end() &&
+                   slot.archetypes[it->second].type == archetype.type;
+      if (reuse) {
+        snapshotScratch.push_back(std::move(slot.archetypes[it->second]));
+      } else {
+        snapshotScratch.push_back(makeArchetypeSnapshot(archetype));
       }
-      oldArchetype->edges.emplace(componentID, ArchetypeEdge{newArchetype});
+      ArchetypeSnapshot &saved = snapshotScratch.back();
+      for (size_t i = 0; i < archetype.components.size(); i++) {
+        archetype.components[i].saveTo(
+            saved.columns[i], reuse ? sinceTick : 0);
+      }
+      saved.entities.assign(
+          archetype.entities.begin(), archetype.entities.end());
+      saved.enabledRows.assign(
+          archetype.enabledRows.begin(), archetype.enabledRows.end());
+      saved.disabledCount = archetype.disabledCount;
+    };
+    saveArchetype(baseArchetype);
+    for (auto &[type, archetype] : archetypeIndex) {
+      saveArchetype(*archetype);
     }
+    // Archetypes that emptied or got freed since drop their buffers here
+    std::swap(slot.archetypes, snapshotScratch);
+    snapshotScratch.clear();
+
+    slot.nextId = nextId;
+    slot.deletedEntities.assign(deletedEntities.begin(), deletedEntities.end());
+    slot.frame = frame;
+    slot.tick = changeTick;
+    // Writes from now on are newer than anything in the slot
+    changeTick++;
+    lastSnapshotFrame = frame;
+    return frame;
+  }
 
-    newArchetype->copyValue(*oldArchetype, record.row);
-    entityIndex[oldArchetype->swapWithLastElement(record.row)].row = record.row;
-    record.archetype = newArchetype;
+  bool hasSnapshot(uint64_t frame) const {
+    if (snapshots.empty() || frame == 0) {
+      return false;
+    }
+    const WorldSnapshot &slot = snapshots[frame % snapshots.size()];
+    return slot.tick != 0 && slot.frame == frame;
+  }
 
-    // update the EntityIndex map
-    entityIndex[entity].archetype = newArchetype;
-    entityIndex[entity].row = newArchetype->components[0].size() - 1;
+  // Puts every entity and component back the way they were when the frame
+  // was saved and rebuilds the entity index. Chunks that weren't written
+  // since are left alone. Snapshots after the frame are dropped since the
+  // world continues from the restored one. Observers are not notified.
+  // @throws std::runtime_error if the frame isn't in the ring anymore
+  void restore(uint64_t frame) {
+    assertNotIterating();
+    if (!hasSnapshot(frame)) {
+      throw std::runtime_error("frame is not in the snapshot ring");
+    }
+    WorldSnapshot &slot = snapshots[frame % snapshots.size()];
+
+    restoredArchetypes.clear();
+    for (ArchetypeSnapshot &saved : slot.archetypes) {
+      // Recreates the archetype if it was freed since
+      Archetype *archetype = getOrCreateArchetype(saved.type);
+      for (size_t i = 0; i < archetype->components.size(); i++) {
+        archetype->components[i].restoreFrom(saved.columns[i], slot.tick);
+      }
+      archetype->entities.assign(saved.entities.begin(), saved.entities.end());
+      archetype->enabledRows.assign(
+          saved.enabledRows.begin(), saved.enabledRows.end());
+      archetype->disabledCount = saved.disabledCount;
+      restoredArchetypes.insert(archetype);
+    }
+
+    // Everything the snapshot doesn't have was empty at the time
+    auto clearArchetype = [&](Archetype &archetype) {
+      if (archetype.size() == 0 || restoredArchetypes.contains(&archetype)) {
+        return;
+      }
+      for (auto &column : archetype.components) {
+        column.clear();
+      }
+      archetype.entities.clear();
+      archetype.enabledRows.clear();
+      archetype.disabledCount = 0;
+      queueMaintenance(&archetype);
+    };
+    clearArchetype(baseArchetype);
+    for (auto &[type, archetype] : archetypeIndex) {
+      clearArchetype(*archetype);
+    }
+
+    nextId = slot.nextId;
+    deletedEntities.assign(
+        slot.deletedEntities.begin(), slot.deletedEntities.end());
+    entityIndex.assign(nextId, Record{});
+    for (Archetype *archetype : restoredArchetypes) {
+      for (size_t row = 0; row < archetype->size(); row++) {
+        EntityID entity = archetype->entities[row];
+        entityIndex[Entity::getId(entity)] = Record{archetype, row, entity};
+      }
+    }
+
+    for (WorldSnapshot &other : snapshots) {
+      if (other.frame > frame) {
+        other.tick = 0;
+      }
+    }
+    lastSnapshotFrame = frame;
+  }
+
+  // Entities of one archetype that got the same event since the last flush.
+  // For removals the archetype is where the entity lives now, or nullptr if
+  // the entity was deleted, the removed value itself is already gone.
+  struct ObserverBatch {
+    Archetype *archetype;
+    std::span<const EntityID> entities;
+  };
+
+  using ObserverCallback =
+      std::function<void(Register &, const ObserverBatch &)>;
+
+  // Registers a callback for OnAdd<T>, OnRemove<T> or OnUpdateComponent<T>,
+  // see observer.hpp for what raises them. Structural changes only queue the
+  // entity, the callbacks run in flushObservers. Callbacks registered by a
+  // callback take effect once the flush finished.
+  template <typename Event> void observe(ObserverCallback callback) {
+    using Traits = ObserverEventTraits<Event>;
+    size_t index = observerChannelIndex(
+        ComponentIDGenerator::getComponentID<typename Traits::Component>(),
+        Traits::event);
+    if (flushingObservers) {
+      deferredObservers.emplace_back(index, std::move(callback));
+      return;
+    }
+    addObserver(index, std::move(callback));
+  }
+
+  // Delivers the events queued since the last flush, one call per archetype
+  // and event with all the entities of that archetype. Adds and updates are
+  // only delivered for entities that still have the component. Changes made
+  // by the callbacks are delivered by the next flush. A callback calling
+  // flushObservers only asks for another pass once the current one finished,
+  // the batch it is handed points into buffers the pass still uses.
+  void flushObservers() {
+    if (flushingObservers) {
+      observerFlushRequested = true;
+      return;
+    }
+    flushingObservers = true;
+    try {
+      do {
+        observerFlushRequested = false;
+        deliverObserverEvents();
+      } while (observerFlushRequested);
+    } catch (...) {
+      finishObserverFlush();
+      throw;
+    }
+    finishObserverFlush();
   }
 
   Archetype *findArchetype(EntityID entity) {
-    return entityIndex[entity].archetype;
+    return getRecord(entity).archetype;
+  }
+
+  using ArchetypeSet = std::pmr::unordered_set<Archetype *>;
+
+  // Archetypes matching a set of query terms. The register keeps the list up
+  // to date as archetypes are created and freed, so it is only matched in full
+  // once when the query is first created.
+  struct Query {
+    Query() = default;
+
+    explicit Query(std::pmr::memory_resource *resource)
+        : archetypes(resource) {}
+
+    ComponentMask with;
+    ComponentMask without;
+    ComponentMask shared;
+    std::pmr::vector<Archetype *> archetypes;
+
+    bool matches(const Archetype &archetype) const {
+      return (archetype.mask & with) == with &&
+             (archetype.mask & without).none() &&
+             (archetype.sharedMask & shared) == shared;
+    }
+  };
+
+  // Returns the cached query for the terms, see query.hpp for the terms.
+  // Every term pack gets a process wide slot during static initialization,
+  // a register finds its query by that slot with a plain load.
+  template <typename... Terms> Query &query() {
+    size_t slot = querySlot<Terms...>;
+    if (slot < querySlots.size() && querySlots[slot] != nullptr) {
+      return *querySlots[slot];
+    }
+
+    // Only the masks are filled in, so looking up a cached query allocates
+    // nothing. Term packs that only differ in order share one query.
+    Query key;
+    (addQueryTerm<Terms>(key), ...);
+
+    Query *found = nullptr;
+    for (auto &cachedQuery : queries) {
+      if (cachedQuery->with == key.with &&
+          cachedQuery->without == key.without &&
+          cachedQuery->shared == key.shared) {
+        found = cachedQuery.get();
+        break;
+      }
+    }
+    if (found == nullptr) {
+      found = &createQuery(key);
+    }
+    // Slot 0 is a pack whose slot isn't assigned yet, a query made from
+    // another static initializer, it is looked up by its masks every time
+    if (slot == 0) {
+      return *found;
+    }
+    if (slot >= querySlots.size()) {
+      querySlots.resize(slot + 1, nullptr);
+    }
+    querySlots[slot] = found;
+    return *found;
   }
 
-  using ArchetypeSet = std::unordered_set<Archetype *>;
+  // Calls the function for every enabled entity matching the terms. With terms
+  // are passed as references, Optional terms as pointers that are nullptr when
+  // the entity doesn't have the component and Without terms are not passed.
+  // The entity id is passed first if the function accepts it.
+  // The function must not make structural changes, that is create or delete
+  // entities, add or remove components or shared values, reserve, sort,
+  // maintain or restore, they move the rows being visited. Debug builds
+  // assert on it. Writing components and enabling or disabling entities is
+  // fine.
+  template <typename... Terms, typename Function>
+  void each(Function &&function) {
+    IterationScope scope(iterationDepth);
+    const auto &archetypes = query<Terms...>().archetypes;
+    for (size_t index = 0; index < archetypes.size(); index++) {
+      Archetype *archetype = archetypes[index];
+      size_t rowCount = archetype->size();
+      if (rowCount == 0) {
+        continue;
+      }
+      auto accessors = std::tuple_cat(getTermAccessor<Terms>(*archetype)...);
+      std::apply(
+          [&](auto &...accessor) {
+            auto visit = [&](size_t row) {
+              if constexpr (std::is_invocable_v<
+                                Function &,
+                                EntityID,
+                                decltype(accessor.get(row))...>) {
+                function(archetype->entities[row], accessor.get(row)...);
+              } else {
+                function(accessor.get(row)...);
+              }
+            };
+            if (archetype->disabledCount == 0) {
+              for (size_t row = 0; row < rowCount; row++) {
+                visit(row);
+              }
+              return;
+            }
+            // Walks the set bits only, fully disabled words cost one test
+            for (size_t word = 0; word < archetype->enabledRows.size();
+                 word++) {
+              uint64_t bits = archetype->enabledRows[word];
+              while (bits != 0) {
+                visit(word * 64 + std::countr_zero(bits));
+                bits &= bits - 1;
+              }
+            }
+          },
+          accessors);
+    }
+  }
 
-  static ArchetypeSet
-  intersect(const ArchetypeSet &set1, const ArchetypeSet &set2) {
-    ArchetypeSet resultSet{};
-    for (auto setElement : set1) {
-      if (set2.contains(setElement)) {
-        resultSet.insert(setElement);
+  // Calls function(archetype, begin, end) for every chunk of CHUNK_ROWS rows
+  // of an archetype with the component whose column was written after
+  // sinceTick, disabled rows included, then moves sinceTick past every write
+  // so far. Passing the same variable every update visits what changed since
+  // the last pass, 0 visits everything. Besides writes through get and each,
+  // a chunk counts as changed when rows were added to it, a deleted row was
+  // filled with the last one or an entity in it was enabled or disabled.
+  // Entities that left the archetype are not reported, observe OnRemove for
+  // them.
+  template <typename Component, typename Function>
+  void eachChangedChunk(uint32_t &sinceTick, Function &&function) {
+    ComponentID componentID = ComponentIDGenerator::getComponentID<
+        std::remove_const_t<Component>>();
+    for (Archetype *archetype : query<const Component>().archetypes) {
+      // Shared values have no column
+      Column *column = archetype->findColumn(componentID);
+      if (column == nullptr) {
+        continue;
       }
+      column->eachChunkChangedSince(sinceTick, [&](size_t begin, size_t end) {
+        function(*archetype, begin, end);
+      });
     }
-    return resultSet;
+    sinceTick = changeTick;
+    // Writes from now on are newer than this pass
+    changeTick++;
+  }
+
+  // Archetypes that have all of the given components
+  template <typename C, typename... Components>
+  const std::pmr::vector<Archetype *> &findArchetypes() {
+    return query<C, Components...>().archetypes;
   }
 
-  // For performance reasons its better to put the component likely to have the
-  // least amount of members as first parameter
-  template <typename C, typename... Components> ArchetypeSet findArchetypes() {
-    ComponentID componentID = ComponentIDGenerator::getComponentID<C>();
-    ArchetypeSet resultSet = componentIndex[componentID];
+  // Reorders the rows of the archetype by the key of their component, so
+  // iteration visits them in that order. Rows that are still mostly in order
+  // from the last sort are fixed with a few adjacent swaps, everything else
+  // is sorted once and moved into place by following the permutation. Equal
+  // keys keep their order. Does nothing if the archetype lacks the component.
+  template <typename Component, typename KeyFunction>
+  void sort(Archetype &archetype, KeyFunction &&keyFunction) {
+    assertNotIterating();
+    Column *column = archetype.findColumn(
+        ComponentIDGenerator::getComponentID<Component>());
+    size_t rowCount = archetype.size();
+    if (column == nullptr || rowCount < 2) {
+      return;
+    }
 
-    ((resultSet = intersect(
-          resultSet,
-          componentIndex[ComponentIDGenerator::getComponentID<Components>()])),
-     ...);
+    using Key = std::decay_t<
+        std::invoke_result_t<KeyFunction &, const Component &>>;
+    const Component *data = column->componentData<Component>();
+    std::pmr::vector<Key> keys(frameResource);
+    keys.reserve(rowCount);
+    for (size_t row = 0; row < rowCount; row++) {
+      keys.push_back(keyFunction(data[row]));
+    }
 
-    return resultSet;
+    // Insertion sort until it costs more swaps than rows, whatever it got
+    // done is still valid input for the full sort
+    size_t swapBudget = rowCount;
+    bool sorted = true;
+    for (size_t row = 1; row < rowCount && sorted; row++) {
+      for (size_t i = row; i > 0 && keys[i] < keys[i - 1]; i--) {
+        if (swapBudget == 0) {
+          sorted = false;
+          break;
+        }
+        swapBudget--;
+        std::swap(keys[i], keys[i - 1]);
+        archetype.swapRows(i, i - 1);
+      }
+    }
+
+    if (!sorted) {
+      // order[row] is the current row of the element that belongs in row
+      std::pmr::vector<size_t> order(rowCount, frameResource);
+      std::iota(order.begin(), order.end(), 0);
+      // Ties broken by row keep it stable, std::stable_sort would take a
+      // temporary buffer from the global heap
+      std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (keys[a] < keys[b]) {
+          return true;
+        }
+        return !(keys[b] < keys[a]) && a < b;
+      });
+      for (size_t start = 0; start < rowCount; start++) {
+        size_t row = start;
+        while (order[row] != start) {
+          size_t source = order[row];
+          archetype.swapRows(row, source);
+          order[row] = row;
+          row = source;
+        }
+        order[row] = row;
+      }
+    }
+
+    for (size_t row = 0; row < rowCount; row++) {
+      getRecord(archetype.entities[row]).row = row;
+    }
+  }
+
+  // Sorts every archetype of the query on its own, rows never move between
+  // archetypes
+  template <typename Component, typename KeyFunction>
+  void sort(Query &query, KeyFunction &&keyFunction) {
+    for (Archetype *archetype : query.archetypes) {
+      sort<Component>(*archetype, keyFunction);
+    }
+  }
+
+  // Works through the archetypes that lost rows since the last pass until the
+  // time budget runs out. Empty archetypes are freed together with their edges
+  // and index entries, the rest get their oversized columns shrunk. Whatever
+  // doesn't fit in the budget stays queued for the next call.
+  // @return The number of archetypes that were freed
+  size_t maintain(std::chrono::nanoseconds budget) {
+    return maintainUntil(std::chrono::steady_clock::now() + budget);
+  }
+
+  // Runs the whole maintenance queue regardless of how long it takes
+  size_t compact() {
+    return maintainUntil(std::chrono::steady_clock::time_point::max());
+  }
+
+  // Closes the structural change counters of the previous frame, they are
+  // reported as lastFrame by stats()
+  void newFrame() {
+    lastFrameCounters = frameCounters;
+    frameCounters = StructuralChangeCounters{};
+  }
+
+  RegisterStats stats() {
+    RegisterStats registerStats;
+    stats(registerStats);
+    return registerStats;
+  }
+
+  // Fills the given stats reusing its vectors, so sampling it every frame
+  // doesn't allocate once the vectors have grown to the archetype count
+  void stats(RegisterStats &registerStats) {
+    size_t archetypeCount = archetypeIndex.size() + 1;
+    registerStats.archetypes.resize(archetypeCount);
+    registerStats.entityCount = 0;
+    registerStats.archetypeBytes = 0;
+    registerStats.edgeMapBytes = 0;
+
+    size_t index = 0;
+    auto addArchetype = [&](Archetype &archetype) {
+      ArchetypeStats &archetypeStats = registerStats.archetypes[index++];
+      archetypeStats.components.assign(
+          archetype.type.begin(), archetype.type.end());
+      archetypeStats.entityCount = archetype.size();
+      archetypeStats.edgeCount = archetype.edges.size();
+      archetypeStats.bytes = archetype.entities.capacity() * sizeof(EntityID);
+      archetypeStats.columns.resize(archetype.components.size());
+      for (size_t i = 0; i < archetype.components.size(); i++) {
+        Column &column = archetype.components[i];
+        ColumnStats &columnStats = archetypeStats.columns[i];
+        columnStats.component = archetype.type[i];
+        columnStats.elementSize = column.getElementSize();
+        columnStats.count = column.size();
+        columnStats.capacity = column.getCapacity();
+        columnStats.bytes = column.getCapacity() * column.getElementSize();
+        archetypeStats.bytes += columnStats.bytes;
+      }
+
+      registerStats.entityCount += archetypeStats.entityCount;
+      registerStats.archetypeBytes += archetypeStats.bytes;
+      registerStats.edgeMapBytes +=
+          approximateHashContainerBytes(archetype.edges);
+    };
+    addArchetype(baseArchetype);
+    for (auto &[type, archetype] : archetypeIndex) {
+      addArchetype(*archetype);
+    }
+
+    registerStats.entityIndexBytes = entityIndex.capacity() * sizeof(Record);
+    registerStats.freeListSize = deletedEntities.size();
+    registerStats.freeListBytes = deletedEntities.capacity() * sizeof(EntityID);
+    registerStats.lookupIndexBytes =
+        approximateHashContainerBytes(archetypeIndex) +
+        approximateHashContainerBytes(componentIndex);
+    for (auto &[componentID, archetypes] : componentIndex) {
+      registerStats.lookupIndexBytes +=
+          approximateHashContainerBytes(archetypes);
+    }
+    registerStats.totalBytes =
+        registerStats.archetypeBytes + registerStats.entityIndexBytes +
+        registerStats.edgeMapBytes + registerStats.freeListBytes +
+        registerStats.lookupIndexBytes;
+    registerStats.lastFrame = lastFrameCounters;
   }
 
  private:
+  struct ArchetypeSnapshot {
+    ArchetypeSnapshot(
+        const Type &type,
+        Archetype *archetype,
+        std::pmr::memory_resource *resource)
+        : type(type, resource), archetype(archetype), columns(resource),
+          entities(resource), enabledRows(resource) {}
+
+    Type type;
+    // Only used to match the archetype on the next lap of the ring, the type
+    // is what restore goes by
+    Archetype *archetype;
+    std::pmr::vector<ColumnSnapshot> columns;
+    std::pmr::vector<EntityID> entities;
+    std::pmr::vector<uint64_t> enabledRows;
+    size_t disabledCount = 0;
+  };
+
+  struct WorldSnapshot {
+    explicit WorldSnapshot(std::pmr::memory_resource *resource)
+        : archetypes(resource), deletedEntities(resource) {}
+
+    uint64_t frame = 0;
+    // changeTick when the slot was saved, 0 while it holds nothing
+    uint32_t tick = 0;
+    std::pmr::vector<ArchetypeSnapshot> archetypes;
+    EntityID nextId = 1;
+    std::pmr::vector<EntityID> deletedEntities;
+  };
+
+  ArchetypeSnapshot makeArchetypeSnapshot(Archetype &archetype) {
+    ArchetypeSnapshot saved(archetype.type, &archetype, resource);
+    saved.columns.reserve(archetype.components.size());
+    for (size_t i = 0; i < archetype.components.size(); i++) {
+      saved.columns.emplace_back(
+          &ComponentIDGenerator::getComponentInfo(archetype.type[i]),
+          resource);
+    }
+    return saved;
+  }
+
+  EntityID allocateEntityId() {
+    if (deletedEntities.empty()) {
+      if (nextId > Entity::ID_MASK) {
+        throw std::runtime_error("ran out of entity ids, see ECS_ENTITY_64");
+      }
+      return nextId++;
+    }
+    // Reuse the last freed slot with the next generation
+    EntityID entity = Entity::incrementGen(deletedEntities.back());
+    deletedEntities.pop_back();
+    return entity;
+  }
+
+  void setRecord(const Record &record) {
+    size_t index = Entity::getId(record.entity);
+    if (index >= entityIndex.size()) {
+      entityIndex.resize(index + 1);
+    }
+    entityIndex[index] = record;
+  }
+
+  // Moves the row of the entity to an archetype with the same or fewer columns
+  void moveEntity(Record &record, Archetype *newArchetype) {
+    Archetype *oldArchetype = record.archetype;
+    size_t oldRow = record.row;
+    newArchetype->copyValue(*oldArchetype, oldRow);
+    getRecord(oldArchetype->deleteElement(oldRow)).row = oldRow;
+    queueMaintenance(oldArchetype);
+    record.archetype = newArchetype;
+    record.row = newArchetype->size() - 1;
+  }
+
+  template <typename Component>
+  TypedSharedStorage<Component> &getSharedStorage() {
+    ComponentID componentID = ComponentIDGenerator::getComponentID<Component>();
+    if (componentID > SHARED_MAX_COMPONENT) {
+      throw std::runtime_error("component id too large for shared values");
+    }
+    if (componentID >= sharedStorages.size()) {
+      sharedStorages.resize(componentID + 1);
+    }
+    if (!sharedStorages[componentID]) {
+      sharedStorages[componentID] =
+          std::make_unique<TypedSharedStorage<Component>>(resource);
+    }
+    return static_cast<TypedSharedStorage<Component> &>(
+        *sharedStorages[componentID]);
+  }
+
+  // Record of an entity that is alive, indexed without checking the generation
+  Record &getRecord(EntityID entity) {
+    return entityIndex[Entity::getId(entity)];
+  }
+
+  // nullptr if the entity was deleted or never existed
+  Record *findRecord(EntityID entity) {
+    size_t index = Entity::getId(entity);
+    if (index >= entityIndex.size()) {
+      return nullptr;
+    }
+    Record &record = entityIndex[index];
+    if (record.archetype == nullptr || record.entity != entity) {
+      return nullptr;
+    }
+    return &record;
+  }
+
+  template <typename Term>
+  static void addQueryTerm(Query &query) {
+    using Traits = QueryTerm<Term>;
+    ComponentID componentID =
+        ComponentIDGenerator::getComponentID<typename Traits::Component>();
+    if (Traits::kind == QueryTermKind::With) {
+      query.with.set(componentID);
+    } else if (Traits::kind == QueryTermKind::Without) {
+      query.without.set(componentID);
+    } else if (Traits::kind == QueryTermKind::Shared) {
+      query.shared.set(componentID);
+    }
+  }
+
+  // Slots start at 1, 0 is what querySlot reads before it is initialized
+  static size_t nextQuerySlot() {
+    static std::atomic<size_t> nextSlot{1};
+    return nextSlot.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Assigned before main like the component ids, so reading it doesn't go
+  // through the guard of a function local static
+  template <typename... Terms>
+  inline static const size_t querySlot = nextQuerySlot();
+
+  // Counts each() calls on the stack, exceptions included
+  struct IterationScope {
+    explicit IterationScope(uint32_t &depth) : depth(depth) { depth++; }
+    ~IterationScope() { depth--; }
+    IterationScope(const IterationScope &) = delete;
+    IterationScope &operator=(const IterationScope &) = delete;
+
+    uint32_t &depth;
+  };
+
+  void assertNotIterating() const {
+    assert(
+        iterationDepth == 0 &&
+        "structural change inside Register::each, see its comment");
+  }
+
+  Query &createQuery(const Query &key) {
+    std::pmr::polymorphic_allocator<Query> allocator(resource);
+    QueryPtr newQuery(
+        allocator.new_object<Query>(resource),
+        ResourceDeleter<Query>{resource});
+    newQuery->with = key.with;
+    newQuery->without = key.without;
+    newQuery->shared = key.shared;
+    const ComponentMask &with = newQuery->with;
+
+    // Only the archetypes of the rarest With component can match
+    const ArchetypeSet *candidates = nullptr;
+    for (ComponentID componentID = 0; componentID < ECS_MAX_COMPONENTS;
+         componentID++) {
+      if (!with.test(componentID)) {
+        continue;
+      }
+      auto it = componentIndex.find(componentID);
+      if (it == componentIndex.end()) {
+        candidates = nullptr;
+        break;
+      }
+      if (candidates == nullptr || it->second.size() < candidates->size()) {
+        candidates = &it->second;
+      }
+    }
+
+    if (with.none()) {
+      if (newQuery->matches(baseArchetype)) {
+        newQuery->archetypes.push_back(&baseArchetype);
+      }
+      for (auto &[type, archetype] : archetypeIndex) {
+        if (newQuery->matches(*archetype)) {
+          newQuery->archetypes.push_back(archetype.get());
+        }
+      }
+    } else if (candidates != nullptr) {
+      for (Archetype *archetype : *candidates) {
+        if (newQuery->matches(*archetype)) {
+          newQuery->archetypes.push_back(archetype);
+        }
+      }
+    }
+
+    queries.push_back(std::move(newQuery));
+    return *queries.back();
+  }
+
+  template <typename Component> struct WithAccessor {
+    Component *data;
+
+    Component &get(size_t row) const { return data[row]; }
+  };
+
+  // Marks the chunk of every row it hands out as written. each visits rows in
+  // ascending order, so that is one check per row and one mark per chunk.
+  template <typename Component> struct WritableAccessor {
+    Component *data;
+    Column *column;
+    size_t markedChunk = SIZE_MAX;
+
+    Component &get(size_t row) {
+      size_t chunk = row / Column::CHUNK_ROWS;
+      if (chunk != markedChunk) {
+        column->markDirty(row);
+        markedChunk = chunk;
+      }
+      return data[row];
+    }
+  };
+
+  template <typename Component> struct OptionalAccessor {
+    Component *data;
+
+    Component *get(size_t row) const {
+      return data == nullptr ? nullptr : data + row;
+    }
+  };
+
+  // nullptr for every row when the archetype lacks the component
+  template <typename Component> struct WritableOptionalAccessor {
+    WritableAccessor<Component> accessor;
+
+    Component *get(size_t row) {
+      return accessor.data == nullptr ? nullptr : &accessor.get(row);
+    }
+  };
+
+  template <typename Component> struct SharedAccessor {
+    const Component *value;
+
+    const Component &get(size_t) const { return *value; }
+  };
+
+  template <typename Term> auto getTermAccessor(Archetype &archetype) {
+    using Traits = QueryTerm<Term>;
+    using Component = typename Traits::Component;
+    if constexpr (Traits::kind == QueryTermKind::With) {
+      Column &column = archetype.getColumn<Component>();
+      if constexpr (Traits::readOnly) {
+        return std::make_tuple(WithAccessor<const Component>{
+            column.template componentData<Component>()});
+      } else {
+        return std::make_tuple(WritableAccessor<Component>{
+            column.template componentData<Component>(), &column});
+      }
+    } else if constexpr (Traits::kind == QueryTermKind::Optional) {
+      Column *column = archetype.findColumn(
+          ComponentIDGenerator::getComponentID<Component>());
+      Component *data = column == nullptr
+                            ? nullptr
+                            : column->template componentData<Component>();
+      if constexpr (Traits::readOnly) {
+        return std::make_tuple(OptionalAccessor<const Component>{data});
+      } else {
+        return std::make_tuple(WritableOptionalAccessor<Component>{
+            WritableAccessor<Component>{data, column}});
+      }
+    } else if constexpr (Traits::kind == QueryTermKind::Shared) {
+      return std::make_tuple(
+          SharedAccessor<Component>{getShared<Component>(archetype)});
+    } else {
+      return std::tuple<>();
+    }
+  }
+
+  struct ObserverChannel {
+    explicit ObserverChannel(std::pmr::memory_resource *resource)
+        : callbacks(resource), pending(resource) {}
+
+    std::pmr::vector<ObserverCallback> callbacks;
+    std::pmr::vector<EntityID> pending;
+  };
+
+  struct ObserverEntry {
+    Archetype *archetype;
+    size_t row;
+    EntityID entity;
+  };
+
+  static size_t
+  observerChannelIndex(ComponentID componentID, ObserverEvent event) {
+    return componentID * OBSERVER_EVENT_COUNT + static_cast<size_t>(event);
+  }
+
+  // One pass over the channels, see flushObservers
+  void deliverObserverEvents() {
+    for (size_t index = 0; index < observerChannels.size(); index++) {
+      if (observerChannels[index].pending.empty()) {
+        continue;
+      }
+      std::swap(observerChannels[index].pending, observerPending);
+      ComponentID componentID = index / OBSERVER_EVENT_COUNT;
+      auto event = static_cast<ObserverEvent>(index % OBSERVER_EVENT_COUNT);
+
+      observerEntries.clear();
+      for (EntityID entity : observerPending) {
+        Record *record = findRecord(entity);
+        if (record == nullptr) {
+          if (event == ObserverEvent::Remove) {
+            observerEntries.push_back({nullptr, 0, entity});
+          }
+          continue;
+        }
+        Archetype *archetype = record->archetype;
+        if (event != ObserverEvent::Remove &&
+            archetype->findColumn(componentID) == nullptr) {
+          continue;
+        }
+        observerEntries.push_back({archetype, record->row, entity});
+      }
+      observerPending.clear();
+
+      // Grouping by archetype and row keeps each batch walking its columns
+      // front to back, duplicates come from several events on one entity
+      std::sort(
+          observerEntries.begin(),
+          observerEntries.end(),
+          [](const ObserverEntry &a, const ObserverEntry &b) {
+            if (a.archetype != b.archetype) {
+              return std::less<Archetype *>()(a.archetype, b.archetype);
+            }
+            if (a.row != b.row) {
+              return a.row < b.row;
+            }
+            return a.entity < b.entity;
+          });
+      observerEntries.erase(
+          std::unique(
+              observerEntries.begin(),
+              observerEntries.end(),
+              [](const ObserverEntry &a, const ObserverEntry &b) {
+                return a.archetype == b.archetype && a.entity == b.entity;
+              }),
+          observerEntries.end());
+
+      observerEntities.clear();
+      for (const ObserverEntry &entry : observerEntries) {
+        observerEntities.push_back(entry.entity);
+      }
+
+      size_t begin = 0;
+      while (begin < observerEntries.size()) {
+        size_t end = begin;
+        while (end < observerEntries.size() &&
+               observerEntries[end].archetype ==
+                   observerEntries[begin].archetype) {
+          end++;
+        }
+        ObserverBatch batch{
+            observerEntries[begin].archetype,
+            std::span<const EntityID>(observerEntities)
+                .subspan(begin, end - begin)};
+        // Observers added meanwhile are deferred, so neither the channels nor
+        // the callbacks move while one of them runs
+        for (ObserverCallback &callback : observerChannels[index].callbacks) {
+          callback(*this, batch);
+        }
+        begin = end;
+      }
+    }
+  }
+
+  void finishObserverFlush() {
+    flushingObservers = false;
+    observerFlushRequested = false;
+    for (auto &[index, callback] : deferredObservers) {
+      addObserver(index, std::move(callback));
+    }
+    deferredObservers.clear();
+  }
+
+  void addObserver(size_t index, ObserverCallback callback) {
+    while (index >= observerChannels.size()) {
+      observerChannels.emplace_back(resource);
+    }
+    observerChannels[index].callbacks.push_back(std::move(callback));
+    if (static_cast<ObserverEvent>(index % OBSERVER_EVENT_COUNT) ==
+        ObserverEvent::Remove) {
+      hasRemoveObservers = true;
+    }
+  }
+
+  // Only queues the entity when something observes the event, so unobserved
+  // components pay a bounds check and an empty() on the structural change path
+  void recordObserverEvent(
+      ComponentID componentID,
+      ObserverEvent event,
+      EntityID entity) {
+    size_t index = observerChannelIndex(componentID, event);
+    if (index < observerChannels.size() &&
+        !observerChannels[index].callbacks.empty()) {
+      observerChannels[index].pending.push_back(entity);
+    }
+  }
+
+  size_t maintainUntil(std::chrono::steady_clock::time_point deadline) {
+    assertNotIterating();
+    size_t freedArchetypes = 0;
+    while (!maintenanceQueue.empty()) {
+      Archetype *archetype = maintenanceQueue.back();
+      maintenanceQueue.pop_back();
+      archetype->queuedForMaintenance = false;
+
+      if (archetype->size() == 0) {
+        freeArchetype(archetype);
+        freedArchetypes++;
+      } else {
+        archetype->shrinkColumns();
+      }
+
+      if (std::chrono::steady_clock::now() >= deadline) {
+        break;
+      }
+    }
+    return freedArchetypes;
+  }
+
+  // Returns the archetype of the given type, creating it on the first use.
+  // The type can live in scratch memory, a new archetype copies it.
+  Archetype *getOrCreateArchetype(const Type &newType) {
+    if (newType.size() == 0) {
+      return &baseArchetype;
+    }
+
+    auto itArche = archetypeIndex.find(newType);
+    if (itArche == archetypeIndex.end()) {
+      itArche =
+          archetypeIndex.emplace(Type(newType, resource), nullptr).first;
+      std::pmr::polymorphic_allocator<Archetype> allocator(resource);
+      itArche->second = ArchetypePtr(
+          allocator.new_object<Archetype>(resource),
+          ResourceDeleter<Archetype>{resource});
+      Archetype *newArchetype = itArche->second.get();
+      newArchetype->type = itArche->first;  // The key Type
+      newArchetype->components =
+          newArchetype->type.initComponentVector(resource, &changeTick);
+      for (ComponentID componentID : newArchetype->type) {
+        ComponentID maskID = isSharedPair(componentID)
+                                 ? getSharedComponent(componentID)
+                                 : componentID;
+        if (maskID >= ECS_MAX_COMPONENTS) {
+          throw std::runtime_error("component id exceeds ECS_MAX_COMPONENTS");
+        }
+        if (isSharedPair(componentID)) {
+          newArchetype->sharedMask.set(maskID);
+        } else {
+          newArchetype->mask.set(maskID);
+        }
+        componentIndex[componentID].emplace(newArchetype);
+      }
+      size_t columnCount = newArchetype->components.size();
+      if (columnCount > 0) {
+        newArchetype->columnIndex.assign(
+            newArchetype->type[columnCount - 1] + 1, Archetype::NO_COLUMN);
+      }
+      for (size_t i = 0; i < columnCount; i++) {
+        newArchetype->columnIndex[newArchetype->type[i]] = i;
+      }
+      for (auto &cachedQuery : queries) {
+        if (cachedQuery->matches(*newArchetype)) {
+          cachedQuery->archetypes.push_back(newArchetype);
+        }
+      }
+      frameCounters.archetypesCreated++;
+    }
+    return itArche->second.get();
+  }
+
+  // Follows the add/remove edge of the component, edges are always linked in
+  // both directions so freeing an archetype can unlink all of them
+  Archetype *
+  traverseEdge(Archetype *oldArchetype, ComponentID componentID, bool add) {
+    auto it = oldArchetype->edges.find(componentID);
+    if (it != oldArchetype->edges.end()) {
+      return it->second.edge;
+    }
+
+    Type newType = oldArchetype->type.clone(frameResource);
+    if (add) {
+      newType.add(componentID);
+    } else {
+      newType.remove(componentID);
+    }
+    // if it doesnt exist create a new archetype and insert it to the map
+    Archetype *newArchetype = getOrCreateArchetype(newType);
+    oldArchetype->edges.emplace(componentID, ArchetypeEdge{newArchetype});
+    newArchetype->edges.emplace(componentID, ArchetypeEdge{oldArchetype});
+    return newArchetype;
+  }
+
+  void queueMaintenance(Archetype *archetype) {
+    if (archetype == &baseArchetype || archetype->queuedForMaintenance) {
+      return;
+    }
+    archetype->queuedForMaintenance = true;
+    maintenanceQueue.push_back(archetype);
+  }
+
+  void freeArchetype(Archetype *archetype) {
+    for (auto &cachedQuery : queries) {
+      std::erase(cachedQuery->archetypes, archetype);
+    }
+
+    for (auto &[componentID, archetypeEdge] : archetype->edges) {
+      auto &neighbourEdges = archetypeEdge.edge->edges;
+      auto it = neighbourEdges.find(componentID);
+      if (it != neighbourEdges.end() && it->second.edge == archetype) {
+        neighbourEdges.erase(it);
+      }
+    }
+
+    for (ComponentID componentID : archetype->type) {
+      auto it = componentIndex.find(componentID);
+      if (it == componentIndex.end()) {
+        continue;
+      }
+      it->second.erase(archetype);
+      if (it->second.empty()) {
+        componentIndex.erase(it);
+      }
+    }
+
+    // Erasing the entry frees the archetype itself, so it goes last
+    archetypeIndex.erase(archetypeIndex.find(archetype->type));
+    frameCounters.archetypesFreed++;
+  }
+
+  // Destroys objects made with new_object of a polymorphic_allocator
+  template <typename T> struct ResourceDeleter {
+    std::pmr::memory_resource *resource = nullptr;
+
+    void operator()(T *object) const {
+      std::pmr::polymorphic_allocator<T>(resource).delete_object(object);
+    }
+  };
+
+  using ArchetypePtr = std::unique_ptr<Archetype, ResourceDeleter<Archetype>>;
+  using QueryPtr = std::unique_ptr<Query, ResourceDeleter<Query>>;
+
+  std::pmr::memory_resource *resource;
+
   EntityID nextId = 1;
 
-  Archetype baseArchetype = Archetype();  // to be initialized at creation
-  std::vector<EntityID> deletedEntities;
-  std::unordered_map<EntityID, Record> entityIndex;
+  Archetype baseArchetype;
+  std::pmr::vector<EntityID> deletedEntities;
+  // Indexed by Entity::getId, so one lookup resolves an entity to its row
+  std::pmr::vector<Record> entityIndex;
 
   struct TypeHasher {
     size_t operator()(const Type &type) const {
@@ -579,11 +2128,45 @@ struct Register {
   };
 
   // In struct Register:
-  std::unordered_map<Type, std::unique_ptr<Archetype>, TypeHasher>
-      archetypeIndex;
+  std::pmr::unordered_map<Type, ArchetypePtr, TypeHasher> archetypeIndex;
 
   // Find the archetypes for a component
-  std::unordered_map<ComponentID, ArchetypeSet> componentIndex;
+  std::pmr::unordered_map<ComponentID, ArchetypeSet> componentIndex;
+  // Archetypes that lost rows and should be checked by the next maintain call
+  std::pmr::vector<Archetype *> maintenanceQueue;
+  // Cached queries, kept behind pointers so references to them stay valid
+  std::pmr::vector<QueryPtr> queries;
+  // Indexed by the slot query() gives each term pack, nullptr for packs this
+  // register hasn't seen
+  std::pmr::vector<Query *> querySlots;
+  // Shared values indexed by component id
+  std::pmr::vector<std::unique_ptr<SharedStorage>> sharedStorages;
+  std::pmr::memory_resource *frameResource = std::pmr::get_default_resource();
+  // Bumped by every snapshot and eachChangedChunk, columns stamp their written
+  // chunks with it
+  uint32_t changeTick = 1;
+  std::pmr::vector<WorldSnapshot> snapshots;
+  uint64_t lastSnapshotFrame = 0;
+  std::pmr::unordered_map<Archetype *, size_t> snapshotLookup;
+  std::pmr::vector<ArchetypeSnapshot> snapshotScratch;
+  std::pmr::unordered_set<Archetype *> restoredArchetypes;
+
+  StructuralChangeCounters frameCounters;
+  StructuralChangeCounters lastFrameCounters;
+
+  // Indexed by observerChannelIndex
+  std::pmr::vector<ObserverChannel> observerChannels;
+  bool hasRemoveObservers = false;
+  // Scratch buffers reused by every flush
+  std::pmr::vector<EntityID> observerPending;
+  std::pmr::vector<ObserverEntry> observerEntries;
+  std::pmr::vector<EntityID> observerEntities;
+  bool flushingObservers = false;
+  bool observerFlushRequested = false;
+  // Nesting depth of each(), structural changes assert it is 0
+  uint32_t iterationDepth = 0;
+  // Observers registered by callbacks during a flush, with their channel
+  std::pmr::vector<std::pair<size_t, ObserverCallback>> deferredObservers;
   ComponentIDGenerator componentIDGenerator;
 };
 }  // namespace ecs
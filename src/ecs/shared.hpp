@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+
+#include "component.hpp"
+
+namespace ecs {
+
+// Shared components are stored once in the register instead of once per
+// entity. An archetype holds one value of each shared component, encoded in its
+// type as a pair id of the component and the index of the value, so entities
+// with different values end up in different archetypes.
+inline constexpr ComponentID SHARED_PAIR_FLAG = 0x80000000;
+inline constexpr ComponentID SHARED_VALUE_BITS = 16;
+inline constexpr ComponentID SHARED_VALUE_MASK = (1u << SHARED_VALUE_BITS) - 1;
+inline constexpr ComponentID SHARED_MAX_COMPONENT =
+    (SHARED_PAIR_FLAG >> SHARED_VALUE_BITS) - 1;
+
+inline constexpr ComponentID
+makeSharedPair(ComponentID componentID, uint32_t valueIndex) {
+  return SHARED_PAIR_FLAG | (componentID << SHARED_VALUE_BITS) | valueIndex;
+}
+
+inline constexpr bool isSharedPair(ComponentID id) {
+  return (id & SHARED_PAIR_FLAG) != 0;
+}
+
+inline constexpr ComponentID getSharedComponent(ComponentID pair) {
+  return (pair & ~SHARED_PAIR_FLAG) >> SHARED_VALUE_BITS;
+}
+
+inline constexpr uint32_t getSharedValueIndex(ComponentID pair) {
+  return pair & SHARED_VALUE_MASK;
+}
+
+// Value added with Register::addSharedValue, only valid for that register
+template <typename Component> struct SharedHandle {
+  uint32_t index;
+
+  bool operator==(const SharedHandle &) const = default;
+};
+
+// Type erased owner of the shared values of one component
+struct SharedStorage {
+  virtual ~SharedStorage() = default;
+};
+
+template <typename Component> struct TypedSharedStorage : SharedStorage {
+  explicit TypedSharedStorage(std::pmr::memory_resource *resource)
+      : values(resource) {}
+
+  // A deque so references to the values stay valid when more are added
+  std::pmr::deque<Component> values;
+};
+
+}  // namespace ecs
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "component.hpp"
+#include "shared.hpp"
+
+namespace ecs {
+
+struct ColumnStats {
+  ComponentID component;
+  size_t elementSize;
+  size_t count;
+  size_t capacity;
+  size_t bytes;
+};
+
+struct ArchetypeStats {
+  // The type of the archetype, shared values included as their pair ids
+  std::vector<ComponentID> components;
+  size_t entityCount;
+  size_t edgeCount;
+  // Column storage plus the entity list of the archetype
+  size_t bytes;
+  std::vector<ColumnStats> columns;
+};
+
+// Structural changes done by the register during one frame
+struct StructuralChangeCounters {
+  uint32_t entitiesCreated = 0;
+  uint32_t entitiesDeleted = 0;
+  uint32_t componentsAdded = 0;
+  uint32_t componentsRemoved = 0;
+  uint32_t archetypesCreated = 0;
+  uint32_t archetypesFreed = 0;
+};
+
+// Snapshot of where the memory of a register goes. The byte counts of the hash
+// maps are estimates based on their bucket and node counts, the column and
+// vector numbers are exact.
+struct RegisterStats {
+  std::vector<ArchetypeStats> archetypes;
+
+  size_t entityCount = 0;
+  size_t archetypeBytes = 0;
+  size_t entityIndexBytes = 0;
+  size_t edgeMapBytes = 0;
+  size_t freeListSize = 0;
+  size_t freeListBytes = 0;
+  // archetypeIndex and componentIndex
+  size_t lookupIndexBytes = 0;
+  size_t totalBytes = 0;
+
+  StructuralChangeCounters lastFrame;
+
+  // Components are written as their stable ids, the dense ids follow static
+  // initialization and differ between builds. See componentName for which
+  // stable ids also match across compilers. The shared values of an
+  // archetype are listed apart as {component, value} with the value index.
+  void writeJson(std::ostream &out) const {
+    out << "{\"entityCount\":" << entityCount
+        << ",\"archetypeCount\":" << archetypes.size()
+        << ",\"archetypeBytes\":" << archetypeBytes
+        << ",\"entityIndexBytes\":" << entityIndexBytes
+        << ",\"edgeMapBytes\":" << edgeMapBytes
+        << ",\"freeListSize\":" << freeListSize
+        << ",\"freeListBytes\":" << freeListBytes
+        << ",\"lookupIndexBytes\":" << lookupIndexBytes
+        << ",\"totalBytes\":" << totalBytes;
+
+    out << ",\"lastFrame\":{\"entitiesCreated\":" << lastFrame.entitiesCreated
+        << ",\"entitiesDeleted\":" << lastFrame.entitiesDeleted
+        << ",\"componentsAdded\":" << lastFrame.componentsAdded
+        << ",\"componentsRemoved\":" << lastFrame.componentsRemoved
+        << ",\"archetypesCreated\":" << lastFrame.archetypesCreated
+        << ",\"archetypesFreed\":" << lastFrame.archetypesFreed << "}";
+
+    out << ",\"archetypes\":[";
+    for (size_t i = 0; i < archetypes.size(); i++) {
+      const ArchetypeStats &archetype = archetypes[i];
+      out << (i == 0 ? "" : ",") << "{\"components\":[";
+      const char *separator = "";
+      for (ComponentID componentID : archetype.components) {
+        if (!isSharedPair(componentID)) {
+          out << separator << stableID(componentID);
+          separator = ",";
+        }
+      }
+      out << "],\"shared\":[";
+      separator = "";
+      for (ComponentID componentID : archetype.components) {
+        if (isSharedPair(componentID)) {
+          out << separator
+              << "{\"component\":" << stableID(getSharedComponent(componentID))
+              << ",\"value\":" << getSharedValueIndex(componentID) << "}";
+          separator = ",";
+        }
+      }
+      out << "],\"entityCount\":" << archetype.entityCount
+          << ",\"edgeCount\":" << archetype.edgeCount
+          << ",\"bytes\":" << archetype.bytes << ",\"columns\":[";
+      for (size_t j = 0; j < archetype.columns.size(); j++) {
+        const ColumnStats &column = archetype.columns[j];
+        out << (j == 0 ? "" : ",")
+            << "{\"component\":" << stableID(column.component)
+            << ",\"elementSize\":" << column.elementSize
+            << ",\"count\":" << column.count
+            << ",\"capacity\":" << column.capacity
+            << ",\"bytes\":" << column.bytes << "}";
+      }
+      out << "]}";
+    }
+    out << "]}";
+  }
+
+ private:
+  static uint32_t stableID(ComponentID componentID) {
+    return ComponentIDGenerator::getComponentInfo(componentID).stableID;
+  }
+};
+
+// Estimated heap usage of a node based std::unordered_map/set: the bucket array
+// plus one node per element holding the value and the next pointer
+template <typename HashContainer>
+size_t approximateHashContainerBytes(const HashContainer &container) {
+  return container.bucket_count() * sizeof(void *) +
+         container.size() *
+             (sizeof(typename HashContainer::value_type) + sizeof(void *));
+}
+
+}  // namespace ecs
@@ -4,69 +4,121 @@
 
 #include <cassert>
 #include <chrono>
+#include <exception>
+#include <format>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Engine.hpp"
+#include "engine/profiler/AllocationTracker.hpp"
+#include "engine/profiler/Profiler.hpp"
 
 namespace engine {
 
-Engine::Engine() : rlmCore(), myRegister() {}
+Engine::Engine(const EngineConfig &config)
+    : config(config),
+      rlmCore(
+          rlm::CoreConfig{
+              .headless = config.headless,
+              .width = config.width,
+              .height = config.height}),
+      myRegister(), timestep(config.tickRate, MAX_TICKS_PER_FRAME) {
+  myRegister.setFrameResource(&frameArena);
+  if (!config.captureOutput.empty() && !config.headless) {
+    throw std::runtime_error("frame capture needs a headless engine");
+  }
+  if (!config.traceOutput.empty() && !profiler::isProfilerEnabled()) {
+    throw std::runtime_error("traces need a build with ENGINE_PROFILER");
+  }
+  if (config.assertNoAllocationsAfter != 0 &&
+      !profiler::isAllocationTrackerEnabled()) {
+    throw std::runtime_error(
+        "allocation checks need a build with ENGINE_ALLOCATION_TRACKER");
+  }
+}
 
 void Engine::run() {
-  auto currentTime = std::chrono::high_resolution_clock::now();
-  auto lastTime = std::chrono::high_resolution_clock::now();
+  spdlog::debug("Engine: Starting the engine");
+  PROFILE_THREAD("Main");
 
-  component::UniformBufferObject myGlobalUbo;
+  if (config.pipelined) {
+    runPipelined();
+  } else {
+    runSingleThreaded();
+  }
 
-  spdlog::debug("Engine: Starting the engine");
+  rlmCore.waitForDevice();
+
+  if (!config.traceOutput.empty()) {
+    profiler::exportChromeTrace(config.traceOutput);
+    spdlog::info("Engine: Wrote trace to {}", config.traceOutput);
+  }
+  if (!config.captureOutput.empty()) {
+    writeCapture(config.captureOutput);
+    spdlog::info("Engine: Wrote frame to {}", config.captureOutput);
+  }
+}
+
+std::chrono::nanoseconds Engine::nextFrameDuration(
+    std::chrono::high_resolution_clock::time_point &currentTime) {
+  auto newTime = std::chrono::high_resolution_clock::now();
+  auto frameDuration = newTime - currentTime;
+  currentTime = newTime;
+  if (config.headless) {
+    return timestep.getTickDuration();
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(frameDuration);
+}
+
+void Engine::writeCapture(const std::string &path) {
+  std::vector<uint8_t> pixels;
+  readFrame(pixels);
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open " + path);
+  }
+  file << "P6\n" << config.width << " " << config.height << "\n255\n";
+  // PPM has no alpha channel
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    file.write(reinterpret_cast<const char *>(&pixels[i]), 3);
+  }
+  if (!file) {
+    throw std::runtime_error("failed to write " + path);
+  }
+}
+
+void Engine::runSingleThreaded() {
+  auto currentTime = std::chrono::high_resolution_clock::now();
+  auto lastTime = std::chrono::high_resolution_clock::now();
 
   int frameCount = 0;
-  while (!rlmCore.shouldClose()) {
+  uint64_t renderedFrames = 0;
+  while (!rlmCore.shouldClose() && !reachedFrameLimit(renderedFrames)) {
     spdlog::debug("Engine: Loop start");
-    auto newTime = std::chrono::high_resolution_clock::now();
+    auto frameDuration = nextFrameDuration(currentTime);
     float frameTime =
         std::chrono::duration<float, std::chrono::seconds::period>(
-            newTime - currentTime)
+            frameDuration)
             .count();
     float elapsed = std::chrono::duration<float, std::chrono::seconds::period>(
-                        newTime - lastTime)
+                        currentTime - lastTime)
                         .count();
-    currentTime = newTime;
 
     frameCount++;
 
-    // spdlog::debug("Engine: Calculating actions");
-    myGlobalUbo.model = glm::rotate(
-        glm::mat4(1.0f),
-        frameTime * glm::radians(90.0f),
-        glm::vec3(0.0f, 0.0f, 1.0f));
-    myGlobalUbo.view = glm::lookAt(
-        glm::vec3(2.0f, 2.0f, 2.0f),
-        glm::vec3(0.0f, 0.0f, 0.0f),
-        glm::vec3(0.0f, 0.0f, 1.0f));
-    myGlobalUbo.proj =
-        glm::perspective(glm::radians(45.0f), 1200.0f / 800.0f, 0.1f, 10.0f);
-    myGlobalUbo.proj[1][1] *= -1;
-
-    rlmCore.updateGlobalUbo(myGlobalUbo);
-
     // spdlog::debug("Engine: Updating system");
-    for (auto &system : systems) {
-      system->update(myRegister, elapsed);
-    }
-
-    // spdlog::debug("Engine: beginning frame operations");
-    rlmCore.beginFrameOperations();
-
-    // spdlog::debug("Engine: Updating rendering");
-    renderingSystem->update(myRegister, elapsed);
-
-    // spdlog::debug("Engine: Ending frame operations");
-    rlmCore.endFrameOperations();
+    simulate(frameDuration);
+    collectFrame(framePacket, frameTime);
+    renderFrame(framePacket);
+    renderedFrames++;
 
     if (elapsed >= 1.0f) {
       float fps = frameCount / elapsed;
@@ -76,7 +128,207 @@ void Engine::run() {
       lastTime = currentTime;
     }
   }
+}
 
-  rlmCore.waitForDevice();
+void Engine::runPipelined() {
+  // GLFW and presenting stay on the calling thread, the simulation moves to a
+  // worker that fills packets until the render side stops taking them. Swap
+  // chain recreation only ever happens on the render side, the worker just
+  // waits for free packets in the meantime.
+  frameQueue.reset();
+  std::exception_ptr simulationError;
+  std::thread simulation([&]() {
+    PROFILE_THREAD("Simulation");
+    try {
+      auto currentTime = std::chrono::high_resolution_clock::now();
+      while (true) {
+        FramePacket *packet;
+        {
+          PROFILE_ZONE("FrameQueue::acquireFree");
+          packet = frameQueue.acquireFree();
+        }
+        if (packet == nullptr) {
+          break;
+        }
+        auto frameDuration = nextFrameDuration(currentTime);
+        simulate(frameDuration);
+        collectFrame(
+            *packet,
+            std::chrono::duration<float, std::chrono::seconds::period>(
+                frameDuration)
+                .count());
+        frameQueue.submit(packet);
+      }
+    } catch (...) {
+      simulationError = std::current_exception();
+      frameQueue.close();
+    }
+  });
+
+  auto stopSimulation = [&]() {
+    frameQueue.close();
+    simulation.join();
+  };
+
+  try {
+    auto lastTime = std::chrono::high_resolution_clock::now();
+    int frameCount = 0;
+    uint64_t renderedFrames = 0;
+    while (!rlmCore.shouldClose() && !reachedFrameLimit(renderedFrames)) {
+      FramePacket *packet;
+      {
+        PROFILE_ZONE("FrameQueue::acquireReady");
+        packet = frameQueue.acquireReady();
+      }
+      if (packet == nullptr) {
+        break;
+      }
+      renderFrame(*packet);
+      frameQueue.release(packet);
+      renderedFrames++;
+
+      frameCount++;
+      auto currentTime = std::chrono::high_resolution_clock::now();
+      float elapsed =
+          std::chrono::duration<float, std::chrono::seconds::period>(
+              currentTime - lastTime)
+              .count();
+      if (elapsed >= 1.0f) {
+        float fps = frameCount / elapsed;
+        std::cout << "FPS: " << fps << std::endl;
+
+        frameCount = 0;
+        lastTime = currentTime;
+      }
+    }
+  } catch (...) {
+    stopSimulation();
+    throw;
+  }
+
+  stopSimulation();
+  if (simulationError) {
+    std::rethrow_exception(simulationError);
+  }
+}
+
+void Engine::simulate(std::chrono::nanoseconds frameDuration) {
+  PROFILE_ZONE("Engine::simulate");
+  auto start = std::chrono::steady_clock::now();
+  frameArena.beginFrame();
+  // The structural change counters cover every tick of the frame
+  myRegister.newFrame();
+  int ticks = timestep.advance(frameDuration);
+  for (int i = 0; i < ticks; i++) {
+    tick();
+  }
+  {
+    PROFILE_ZONE("Register::maintain");
+    myRegister.maintain(MAINTENANCE_BUDGET);
+  }
+  {
+    PROFILE_ZONE("TransformInterpolator::interpolate");
+    interpolator.interpolate(timestep.getAlpha());
+  }
+  simulateMilliseconds = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+}
+
+void Engine::tick() {
+  PROFILE_ZONE("Engine::tick");
+  eventBus.swap();
+  for (auto &system : systems) {
+    PROFILE_ZONE(system->getName());
+    system->update(myRegister, timestep.getTickSeconds());
+  }
+  {
+    PROFILE_ZONE("Register::flushObservers");
+    myRegister.flushObservers();
+  }
+  PROFILE_ZONE("TransformInterpolator::capture");
+  interpolator.capture(myRegister);
+}
+void Engine::collectFrame(FramePacket &packet, float frameTime) {
+  PROFILE_ZONE("Engine::collectFrame");
+  packet.clear();
+  packet.tick = timestep.getTick();
+  packet.frameTime = frameTime;
+  packet.simulateMilliseconds = simulateMilliseconds;
+  renderingSystem->collect(myRegister, packet);
+}
+
+void Engine::renderFrame(const FramePacket &packet) {
+  PROFILE_ZONE("Engine::renderFrame");
+  auto start = std::chrono::steady_clock::now();
+  // spdlog::debug("Engine: Calculating actions");
+  globalUbo.view = glm::lookAt(
+      glm::vec3(2.0f, 2.0f, 2.0f),
+      glm::vec3(0.0f, 0.0f, 0.0f),
+      glm::vec3(0.0f, 0.0f, 1.0f));
+  VkExtent2D extent = getRenderer().getExtent();
+  globalUbo.proj = glm::perspective(
+      glm::radians(45.0f),
+      static_cast<float>(extent.width) / static_cast<float>(extent.height),
+      0.1f,
+      10.0f);
+  globalUbo.proj[1][1] *= -1;
+
+  rlmCore.updateGlobalUbo(globalUbo);
+
+  // spdlog::debug("Engine: beginning frame operations");
+  rlmCore.beginFrameOperations();
+  // The fence beginFrame waited on retired the models this slot drew last
+  framesInFlightModels[getRenderer().getFrameIndex()].assign(
+      packet.keepAlive.begin(), packet.keepAlive.end());
+  auto recordStart = std::chrono::steady_clock::now();
+
+  // spdlog::debug("Engine: Updating rendering");
+  renderingSystem->draw(packet);
+  auto submitStart = std::chrono::steady_clock::now();
+
+  // spdlog::debug("Engine: Ending frame operations");
+  rlmCore.endFrameOperations();
+  auto end = std::chrono::steady_clock::now();
+
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+  frameStats.frame++;
+  frameStats.frameMilliseconds = packet.frameTime * 1000.0;
+  frameStats.simulateMilliseconds = packet.simulateMilliseconds;
+  frameStats.renderMilliseconds = Milliseconds(end - start).count();
+  frameStats.waitMilliseconds = Milliseconds(recordStart - start).count();
+  frameStats.recordMilliseconds =
+      Milliseconds(submitStart - recordStart).count();
+  frameStats.submitMilliseconds = Milliseconds(end - submitStart).count();
+  const rlm::GpuProfiler &gpuProfiler = getRenderer().getGpuProfiler();
+  frameStats.gpuScopes.assign(
+      gpuProfiler.getResults().begin(), gpuProfiler.getResults().end());
+  frameStats.gpuFrame = gpuProfiler.getResultFrame();
+  if (profiler::isAllocationTrackerEnabled()) {
+    trackAllocations();
+  }
+  if (frameCallback) {
+    frameCallback(frameStats);
+  }
+}
+
+void Engine::trackAllocations() {
+  frameStats.allocations =
+      profiler::takeAllocations(frameStats.allocationSites);
+  if (config.assertNoAllocationsAfter == 0 ||
+      frameStats.frame <= config.assertNoAllocationsAfter ||
+      frameStats.allocations.count == 0) {
+    return;
+  }
+  std::string message = std::format(
+      "frame {} made {} heap allocations ({} bytes):",
+      frameStats.frame,
+      frameStats.allocations.count,
+      frameStats.allocations.bytes);
+  for (const profiler::AllocationSite &site : frameStats.allocationSites) {
+    message += std::format(
+        "\n  {}: {} allocations, {} bytes", site.zone, site.count, site.bytes);
+  }
+  throw std::runtime_error(message);
 }
 }  // namespace engine
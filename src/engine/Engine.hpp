@@ -1,24 +1,43 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "ecs/entity.hpp"
 #include "ecs/register.hpp"
+#include "engine/EngineConfig.hpp"
+#include "engine/FixedTimestep.hpp"
+#include "engine/FramePacket.hpp"
+#include "engine/FrameQueue.hpp"
+#include "engine/TransformInterpolator.hpp"
 #include "engine/component/UniformBufferObjectComponent.hpp"
+#include "engine/event/EventBus.hpp"
+#include "engine/memory/FrameArena.hpp"
+#include "engine/profiler/FrameStats.hpp"
+#include "engine/system/RenderSystem.hpp"
 #include "engine/system/System.hpp"
 #include "rlm/core.hpp"
 
 namespace engine {
 class Engine {
  public:
-  Engine();
+  /// @throws std::runtime_error if captureOutput is set without headless
+  explicit Engine(const EngineConfig &config = {});
 
   void run();
 
+  const EngineConfig &getConfig() const { return config; }
+
   rlm::Device &getDevice() { return rlmCore.getDevice(); }
 
+  ecs::EntityID createEntity() { return myRegister.createEntity(); }
+
   template <typename Component>
   ecs::EntityID createEntity(Component component) {
     return myRegister.createEntity(component);
@@ -29,25 +48,135 @@ class Engine {
     return myRegister.addComponent<Component>(component, entity);
   }
 
-  void
-  setRenderingSystem(std::shared_ptr<engine::system::System> renderingSystem) {
+  template <typename Component>
+  ecs::SharedHandle<Component> addSharedValue(Component value) {
+    return myRegister.addSharedValue<Component>(std::move(value));
+  }
+
+  template <typename Component>
+  void setShared(ecs::EntityID entity, ecs::SharedHandle<Component> handle) {
+    myRegister.setShared<Component>(entity, handle);
+  }
+
+  void setRenderingSystem(
+      std::shared_ptr<engine::system::RenderSystem> renderingSystem) {
     this->renderingSystem = renderingSystem;
   }
 
   rlm::Renderer &getRenderer() { return rlmCore.getRenderer(); }
 
+  /// Call from the thread that runs the engine, as the frame callback is
+  /// @throws std::runtime_error when headless
+  void resizeWindow(uint32_t width, uint32_t height) {
+    rlmCore.resizeWindow(width, height);
+  }
+
   rlm::SimpleRenderSystem &getSimpleRenderSystem() {
     return rlmCore.getSimpleRenderSystem();
   }
 
+  /// Recycled at the start of every frame, the register hands it out as its
+  /// frame resource. Belongs to the thread that runs the systems.
+  memory::FrameArena &getFrameArena() { return frameArena; }
+
+  // Systems keep a reference to talk to each other without structural
+  // changes, events emitted in a frame are read in the next one
+  event::EventBus &getEventBus() { return eventBus; }
+
+  /// Systems run at tickRate ticks per second whatever the frame rate, with
+  /// 1 / tickRate as their delta time
+  /// @param maxTicksPerFrame Ticks a slow frame may run to catch up
+  void
+  setTickRate(double tickRate, int maxTicksPerFrame = MAX_TICKS_PER_FRAME) {
+    timestep = FixedTimestep(tickRate, maxTicksPerFrame);
+  }
+
+  const FixedTimestep &getTimestep() const { return timestep; }
+
+  /// Transforms blended between the last two ticks for the frame being drawn
+  const TransformInterpolator &getInterpolator() const { return interpolator; }
+
+  /// CPU and GPU timings of the last rendered frame. Updated by the render
+  /// side, so only read it from the thread that called run.
+  const profiler::FrameStats &getFrameStats() const { return frameStats; }
+
+  /// Called on the render side with the stats of every frame right after it
+  /// was submitted
+  void setFrameCallback(
+      std::function<void(const profiler::FrameStats &)> callback) {
+    frameCallback = std::move(callback);
+  }
+
+  /// Copies the last rendered frame as RGBA8 rows, top row first
+  /// @throws std::runtime_error if the engine isn't headless
+  void readFrame(std::vector<uint8_t> &pixels) {
+    getRenderer().readFrame(pixels);
+  }
+
   void addSystem(std::unique_ptr<system::System> system) {
     systems.push_back(std::move(system));
   }
 
  private:
-  std::shared_ptr<engine::system::System> renderingSystem;
+  // Time the register gets every frame to free empty archetypes and shrink
+  // oversized columns
+  static constexpr std::chrono::microseconds MAINTENANCE_BUDGET{100};
+  static constexpr int MAX_TICKS_PER_FRAME = 5;
+  // Frames the simulation may run ahead of the render thread when pipelined
+  static constexpr size_t PIPELINE_DEPTH = 2;
+
+  void runSingleThreaded();
+  void runPipelined();
+
+  // Real time since the last frame, or exactly one tick when headless
+  std::chrono::nanoseconds nextFrameDuration(
+      std::chrono::high_resolution_clock::time_point &currentTime);
+
+  bool reachedFrameLimit(uint64_t frames) const {
+    return config.frameLimit != 0 && frames >= config.frameLimit;
+  }
+
+  // Writes the last frame as a binary PPM
+  void writeCapture(const std::string &path);
+
+  // Runs the ticks the frame time is worth and interpolates for the frame
+  void simulate(std::chrono::nanoseconds frameDuration);
+
+  // Runs one fixed step of every system and captures its transforms
+  void tick();
+
+  // Fills the packet with what the render side needs, simulation side. The
+  // packet is the render side's snapshot of the frame.
+  void collectFrame(FramePacket &packet, float frameTime);
+
+  // Records, submits and presents the packet, render side
+  void renderFrame(const FramePacket &packet);
+
+  // Collects the allocations of the frame into the stats and enforces
+  // assertNoAllocationsAfter
+  void trackAllocations();
+
+  EngineConfig config;
+  std::shared_ptr<engine::system::RenderSystem> renderingSystem;
   std::vector<std::unique_ptr<system::System>> systems;
   rlm::Core rlmCore;
+  // Models of the frames the GPU may still be drawing, by frame index.
+  // Declared after rlmCore so they are released while the device exists.
+  std::array<
+      std::vector<std::shared_ptr<rlm::Model>>,
+      rlm::Renderer::MAX_FRAMES_IN_FLIGHT>
+      framesInFlightModels;
+  memory::FrameArena frameArena;
   ecs::Register myRegister;
+  event::EventBus eventBus;
+  FixedTimestep timestep;
+  TransformInterpolator interpolator;
+  // Written by the simulation side, handed over in the frame packet
+  double simulateMilliseconds = 0.0;
+  profiler::FrameStats frameStats;
+  std::function<void(const profiler::FrameStats &)> frameCallback;
+  FramePacket framePacket;
+  FrameQueue frameQueue{PIPELINE_DEPTH};
+  component::UniformBufferObject globalUbo;
 };
 }  // namespace engine
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "rlm/core.hpp"
+
+namespace engine {
+
+/// Everything the engine needs to know before it creates the renderer
+struct EngineConfig {
+  /// Renders into offscreen images instead of a window. Every frame then
+  /// advances the simulation by exactly one tick, so runs are deterministic
+  /// and go as fast as the GPU allows.
+  bool headless = false;
+  uint32_t width = rlm::WIDTH;
+  uint32_t height = rlm::HEIGHT;
+  /// Frames to render before run returns, 0 to run until the window closes
+  uint64_t frameLimit = 0;
+  /// Simulates the next frame on a worker thread while the calling thread
+  /// renders the previous one, see Engine::run
+  bool pipelined = false;
+  double tickRate = 60.0;
+  /// Chrome trace of the profiler zones written when run returns. Needs a
+  /// build with ENGINE_PROFILER.
+  std::string traceOutput;
+  /// PPM of the last frame written when run returns, headless only
+  std::string captureOutput;
+  /// Every frame after this one has to be free of heap allocations, run
+  /// throws at the first one that isn't. 0 turns the check off. Needs a build
+  /// with ENGINE_ALLOCATION_TRACKER.
+  uint64_t assertNoAllocationsAfter = 0;
+};
+
+}  // namespace engine
@@ -0,0 +1,38 @@
+#include "engine/FixedTimestep.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace engine {
+
+FixedTimestep::FixedTimestep(double tickRate, int maxTicksPerFrame)
+    : maxTicksPerFrame(maxTicksPerFrame) {
+  if (!(tickRate > 0.0) || maxTicksPerFrame < 1) {
+    throw std::runtime_error(
+        "fixed timestep needs a positive tick rate and catch up limit");
+  }
+  tickDuration = std::chrono::nanoseconds(
+      static_cast<int64_t>(std::llround(1e9 / tickRate)));
+  tickSeconds = std::chrono::duration<float>(tickDuration).count();
+}
+
+int FixedTimestep::advance(std::chrono::nanoseconds frameTime) {
+  accumulator += frameTime;
+  auto ticks = accumulator / tickDuration;
+  if (ticks > maxTicksPerFrame) {
+    droppedTime += (ticks - maxTicksPerFrame) * tickDuration;
+    ticks = maxTicksPerFrame;
+  }
+  accumulator -= ticks * tickDuration;
+  // Whatever the limit dropped, only the part of a tick stays
+  accumulator %= tickDuration;
+  tick += ticks;
+  return static_cast<int>(ticks);
+}
+
+float FixedTimestep::getAlpha() const {
+  return static_cast<float>(
+      static_cast<double>(accumulator.count()) / tickDuration.count());
+}
+
+}  // namespace engine
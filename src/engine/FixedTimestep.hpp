@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace engine {
+
+/// Accumulates real frame time and tells the loop how many fixed ticks to run.
+/// Time is kept in whole nanoseconds so a run fed the same frame times always
+/// ticks the same way.
+class FixedTimestep {
+ public:
+  /// @param tickRate Ticks per second
+  /// @param maxTicksPerFrame Catch up limit, time beyond it is dropped so a
+  /// slow frame doesn't snowball into ever longer ones
+  /// @throws std::runtime_error if tickRate <= 0 or maxTicksPerFrame < 1
+  FixedTimestep(double tickRate, int maxTicksPerFrame);
+
+  /// Adds the frame time
+  /// @return The number of ticks to run this frame
+  int advance(std::chrono::nanoseconds frameTime);
+
+  /// Delta time every tick hands to the systems
+  float getTickSeconds() const { return tickSeconds; }
+
+  std::chrono::nanoseconds getTickDuration() const { return tickDuration; }
+
+  /// How far the leftover time got into the next tick, in [0, 1). Rendering
+  /// blends the last two ticks with it.
+  float getAlpha() const;
+
+  /// Ticks run since the start
+  uint64_t getTick() const { return tick; }
+
+  /// Time dropped by the catch up limit since the start
+  std::chrono::nanoseconds getDroppedTime() const { return droppedTime; }
+
+ private:
+  std::chrono::nanoseconds tickDuration;
+  float tickSeconds;
+  int maxTicksPerFrame;
+  std::chrono::nanoseconds accumulator{0};
+  std::chrono::nanoseconds droppedTime{0};
+  uint64_t tick = 0;
+};
+
+}  // namespace engine
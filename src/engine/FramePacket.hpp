@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace rlm {
+class Model;
+}  // namespace rlm
+
+namespace engine {
+
+/// Everything the render side needs to draw one frame, collected on the
+/// simulation side so drawing never reads the register. It is the render
+/// thread's snapshot of the frame: only the drawn models and their matrices
+/// are copied, not whole columns. Packets are reused, collecting clears them
+/// but keeps their capacity.
+struct FramePacket {
+  /// Last simulation tick that went into the packet
+  uint64_t tick = 0;
+  /// Seconds since the packet before, the render side animates with it
+  float frameTime = 0.0f;
+  /// CPU time the simulation side spent on the frame
+  double simulateMilliseconds = 0.0;
+  /// Models to draw, kept alive by keepAlive
+  std::vector<rlm::Model *> models;
+  /// Interpolated model matrix of every draw, modelMatrices[i] places
+  /// models[i]. Identity for entities without a transform.
+  std::vector<glm::mat4> modelMatrices;
+  /// One reference per run of equal models, so the register can destroy a
+  /// model while the packet is queued or its frame is still on the GPU
+  std::vector<std::shared_ptr<rlm::Model>> keepAlive;
+
+  void clear() {
+    keepAlive.clear();
+    modelMatrices.clear();
+    models.clear();
+  }
+};
+
+}  // namespace engine
@@ -0,0 +1,75 @@
+#include "engine/FrameQueue.hpp"
+
+#include <stdexcept>
+
+namespace engine {
+
+FrameQueue::FrameQueue(size_t capacity)
+    : packets(capacity), readyPackets(capacity) {
+  if (capacity == 0) {
+    throw std::runtime_error("frame queue needs at least one packet");
+  }
+  reset();
+}
+
+FramePacket *FrameQueue::acquireFree() {
+  std::unique_lock lock(mutex);
+  freeAvailable.wait(lock, [&]() { return closed || !freePackets.empty(); });
+  if (closed) {
+    return nullptr;
+  }
+  FramePacket *packet = freePackets.back();
+  freePackets.pop_back();
+  return packet;
+}
+
+void FrameQueue::submit(FramePacket *packet) {
+  {
+    std::lock_guard lock(mutex);
+    readyPackets[(readyFirst + readyCount) % readyPackets.size()] = packet;
+    readyCount++;
+  }
+  readyAvailable.notify_one();
+}
+
+FramePacket *FrameQueue::acquireReady() {
+  std::unique_lock lock(mutex);
+  readyAvailable.wait(lock, [&]() { return closed || readyCount > 0; });
+  if (readyCount == 0) {
+    return nullptr;
+  }
+  FramePacket *packet = readyPackets[readyFirst];
+  readyFirst = (readyFirst + 1) % readyPackets.size();
+  readyCount--;
+  return packet;
+}
+
+void FrameQueue::release(FramePacket *packet) {
+  {
+    std::lock_guard lock(mutex);
+    freePackets.push_back(packet);
+  }
+  freeAvailable.notify_one();
+}
+
+void FrameQueue::close() {
+  {
+    std::lock_guard lock(mutex);
+    closed = true;
+  }
+  freeAvailable.notify_all();
+  readyAvailable.notify_all();
+}
+
+void FrameQueue::reset() {
+  std::lock_guard lock(mutex);
+  readyFirst = 0;
+  readyCount = 0;
+  freePackets.clear();
+  for (FramePacket &packet : packets) {
+    freePackets.push_back(&packet);
+  }
+  closed = false;
+}
+
+}  // namespace engine
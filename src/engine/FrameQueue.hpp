@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "engine/FramePacket.hpp"
+
+namespace engine {
+
+/// Bounded queue of frame packets between the simulation thread and the
+/// render thread. It owns a fixed pool of packets that travel from the free
+/// list to the ready list and back, so the simulation blocks once it is
+/// capacity frames ahead and nothing is allocated per frame.
+class FrameQueue {
+ public:
+  /// @throws std::runtime_error if capacity is 0
+  explicit FrameQueue(size_t capacity);
+
+  FrameQueue(const FrameQueue &) = delete;
+  FrameQueue &operator=(const FrameQueue &) = delete;
+
+  /// Blocks until a packet is free
+  /// @return nullptr once the queue is closed
+  FramePacket *acquireFree();
+
+  /// Hands a filled packet to the render side
+  void submit(FramePacket *packet);
+
+  /// Blocks until a packet is ready, packets come out in submit order
+  /// @return nullptr once the queue is closed and drained
+  FramePacket *acquireReady();
+
+  /// Gives a drawn packet back to the simulation side
+  void release(FramePacket *packet);
+
+  /// Wakes up both sides, after this acquireFree returns nullptr and
+  /// acquireReady returns what is left before returning nullptr
+  void close();
+
+  /// Puts every packet back in the free list and opens the queue again. Only
+  /// call it while neither side uses the queue.
+  void reset();
+
+ private:
+  std::vector<FramePacket> packets;
+  std::mutex mutex;
+  std::condition_variable freeAvailable;
+  std::condition_variable readyAvailable;
+  std::vector<FramePacket *> freePackets;
+  // Ring of capacity slots, a deque would allocate blocks as it moves along
+  std::vector<FramePacket *> readyPackets;
+  size_t readyFirst = 0;
+  size_t readyCount = 0;
+  bool closed = false;
+};
+
+}  // namespace engine
@@ -0,0 +1,68 @@
+#include "engine/TransformInterpolator.hpp"
+
+#include <utility>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "engine/math/TransformKernels.hpp"
+
+namespace engine {
+
+void TransformInterpolator::capture(ecs::Register &register_) {
+  std::swap(previous, current);
+  // Only the slots the older capture set need resetting
+  for (ecs::EntityID entity : current.entities) {
+    current.rows[ecs::Entity::getId(entity)] = NONE;
+  }
+  current.entities.clear();
+  current.transforms.clear();
+
+  register_.each<const component::TransformComponent>(
+      [&](ecs::EntityID entity, const component::TransformComponent &t) {
+        size_t slot = ecs::Entity::getId(entity);
+        if (slot >= current.rows.size()) {
+          current.rows.resize(slot + 1, NONE);
+        }
+        current.rows[slot] = static_cast<uint32_t>(current.entities.size());
+        current.entities.push_back(entity);
+        current.transforms.push_back(t);
+      });
+}
+
+void TransformInterpolator::interpolate(float alpha) {
+  transforms.resize(current.transforms.size());
+  for (size_t row = 0; row < current.entities.size(); row++) {
+    ecs::EntityID entity = current.entities[row];
+    const component::TransformComponent &newest = current.transforms[row];
+    size_t slot = ecs::Entity::getId(entity);
+    uint32_t oldRow =
+        slot < previous.rows.size() ? previous.rows[slot] : NONE;
+    // The slot can belong to an older generation of the id
+    if (oldRow == NONE || previous.entities[oldRow] != entity) {
+      transforms[row] = newest;
+      continue;
+    }
+    const component::TransformComponent &oldest = previous.transforms[oldRow];
+    component::TransformComponent &blended = transforms[row];
+    blended.position = glm::mix(oldest.position, newest.position, alpha);
+    blended.rotation = glm::slerp(oldest.rotation, newest.rotation, alpha);
+    blended.scale = glm::mix(oldest.scale, newest.scale, alpha);
+  }
+
+  modelMatrices.resize(transforms.size());
+  math::computeModelMatrices(
+      transforms.data(), modelMatrices.data(), transforms.size());
+}
+
+glm::mat4 TransformInterpolator::getModelMatrix(ecs::EntityID entity) const {
+  size_t slot = ecs::Entity::getId(entity);
+  uint32_t row = slot < current.rows.size() ? current.rows[slot] : NONE;
+  // A capture not yet interpolated has rows without matrices
+  if (row == NONE || row >= modelMatrices.size() ||
+      current.entities[row] != entity) {
+    return glm::mat4(1.0f);
+  }
+  return modelMatrices[row];
+}
+
+}  // namespace engine
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ecs/entity.hpp"
+#include "ecs/register.hpp"
+#include "engine/component/TransformComponent.hpp"
+
+namespace engine {
+
+/// Keeps the transforms of the last two simulation ticks and blends them for
+/// frames that fall between ticks. Runs on the simulation side between ticks,
+/// the render side only sees its matrices through the frame packet.
+class TransformInterpolator {
+ public:
+  /// Call after every tick, the captured state becomes the newest and the one
+  /// before it the oldest
+  void capture(ecs::Register &register_);
+
+  /// Blends every entity of the newest tick with its state in the tick before.
+  /// Entities that didn't exist a tick ago are taken as they are.
+  /// @param alpha 0 for the older tick, 1 for the newest
+  void interpolate(float alpha);
+
+  /// Entities of the interpolated transforms, in the same order
+  const std::vector<ecs::EntityID> &getEntities() const {
+    return current.entities;
+  }
+
+  const std::vector<component::TransformComponent> &getTransforms() const {
+    return transforms;
+  }
+
+  /// Model matrices of the interpolated transforms, computed by the batch
+  /// kernel. The only place the engine builds model matrices, so this is the
+  /// array the render side uploads.
+  const std::vector<glm::mat4> &getModelMatrices() const {
+    return modelMatrices;
+  }
+
+  /// Model matrix of one entity, identity for entities without a transform
+  /// in the newest tick
+  glm::mat4 getModelMatrix(ecs::EntityID entity) const;
+
+ private:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  struct State {
+    std::vector<ecs::EntityID> entities;
+    std::vector<component::TransformComponent> transforms;
+    // Row of every entity indexed by ecs::Entity::getId
+    std::vector<uint32_t> rows;
+  };
+
+  State previous;
+  State current;
+  std::vector<component::TransformComponent> transforms;
+  std::vector<glm::mat4> modelMatrices;
+};
+
+}  // namespace engine
@@ -0,0 +1,34 @@
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "BenchmarkReport.hpp"
+
+namespace engine::benchmark {
+
+void BenchmarkReport::add(std::string name, double value, std::string unit) {
+  metrics.push_back({std::move(name), value, std::move(unit)});
+}
+
+void BenchmarkReport::writeJson(const std::string &path) const {
+  std::ofstream file(path);
+  if (!file) {
+    throw std::runtime_error("failed to open " + path);
+  }
+  file << "{\n  \"metrics\": {";
+  for (size_t i = 0; i < metrics.size(); i++) {
+    file << std::format(
+        "{}\n    \"{}\": {{\"value\": {}, \"unit\": \"{}\"}}",
+        i == 0 ? "" : ",",
+        metrics[i].name,
+        metrics[i].value,
+        metrics[i].unit);
+  }
+  file << "\n  }\n}\n";
+  if (!file) {
+    throw std::runtime_error("failed to write " + path);
+  }
+}
+
+}  // namespace engine::benchmark
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace engine::benchmark {
+
+/// Numbers a benchmark measured, kept next to what it prints so tools can
+/// compare runs without parsing the text
+class BenchmarkReport {
+ public:
+  /// @param name Unique within the report, '/' separates its parts and it may
+  /// not contain '.' or '"'
+  /// @param unit Lower values are better for every metric
+  void add(std::string name, double value, std::string unit);
+
+  /// Writes {"metrics": {name: {"value": ..., "unit": ...}, ...}}
+  /// @throws std::runtime_error if the file can't be written
+  void writeJson(const std::string &path) const;
+
+ private:
+  struct Metric {
+    std::string name;
+    double value;
+    std::string unit;
+  };
+
+  std::vector<Metric> metrics;
+};
+
+}  // namespace engine::benchmark
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iostream>
+
+#include "engine/profiler/Profiler.hpp"
+
+#include "ProfilerBenchmark.hpp"
+
+namespace engine::benchmark {
+
+namespace {
+
+constexpr int REPETITIONS = 7;
+// A few laps of the ring, so the numbers include wrapping around it
+constexpr size_t ZONES = 4 * profiler::ZONES_PER_THREAD;
+constexpr double BUDGET_NANOSECONDS = 50.0;
+// What a zone may add to its two clock reads where those alone take most of
+// BUDGET_NANOSECONDS, as reading the time stamp counter does in some VMs. No
+// zone gets cheaper than its clock reads, so there the budget is theirs plus
+// this. Writing the record measures 2 to 8 ns, the rest is room for noise.
+constexpr double BOOKKEEPING_BUDGET_NANOSECONDS = 15.0;
+
+struct Timings {
+  double zone = INFINITY;
+  double clockReads = INFINITY;
+};
+
+template <typename Function> double nanosecondsPerRun(Function &&function) {
+  auto start = std::chrono::high_resolution_clock::now();
+  for (size_t run = 0; run < ZONES; run++) {
+    function();
+    // Keeps the compiler from merging or hoisting the runs
+    asm volatile("" ::: "memory");
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         static_cast<double>(ZONES);
+}
+
+// Fastest of a few runs of ZONES empty zones, and of ZONES pairs of clock
+// reads taken in turn with them so both see the same machine. The zone is
+// constructed directly so the benchmark measures it in builds without
+// ENGINE_PROFILER too.
+Timings bestTimings() {
+  auto zone = [] { profiler::Zone benchmarkZone("ProfilerBenchmark"); };
+  auto clockReads = [] {
+    int64_t start = profiler::readClock();
+    asm volatile("" ::: "memory");
+    int64_t end = profiler::readClock();
+    asm volatile("" ::"r"(start), "r"(end));
+  };
+  Timings best;
+  for (int i = 0; i < REPETITIONS; i++) {
+    // Alternates which goes first, so neither always gets the warmer cache
+    double zoneTime = 0.0;
+    double clockTime = 0.0;
+    if (i % 2 == 0) {
+      zoneTime = nanosecondsPerRun(zone);
+      clockTime = nanosecondsPerRun(clockReads);
+    } else {
+      clockTime = nanosecondsPerRun(clockReads);
+      zoneTime = nanosecondsPerRun(zone);
+    }
+    best.zone = std::min(best.zone, zoneTime);
+    best.clockReads = std::min(best.clockReads, clockTime);
+  }
+  return best;
+}
+
+}  // namespace
+
+bool runProfilerBenchmark(BenchmarkReport &report) {
+  bool wasEnabled = profiler::isEnabled();
+  profiler::setEnabled(true);
+  Timings recording = bestTimings();
+  profiler::setEnabled(false);
+  double disabled = bestTimings().zone;
+  profiler::setEnabled(wasEnabled);
+
+  double bookkeeping = recording.zone - recording.clockReads;
+  bool withinBudget = recording.zone <= BUDGET_NANOSECONDS ||
+                      bookkeeping <= BOOKKEEPING_BUDGET_NANOSECONDS;
+  std::cout << std::format(
+      "Profiler benchmark, {} empty zones, budget {:.0f} ns per zone or "
+      "{:.0f} ns on top of the clock reads\n"
+      "recording {:6.1f} ns  clock reads {:6.1f} ns  bookkeeping {:6.1f} ns  "
+      "disabled {:6.1f} ns  {}\n",
+      ZONES,
+      BUDGET_NANOSECONDS,
+      BOOKKEEPING_BUDGET_NANOSECONDS,
+      recording.zone,
+      recording.clockReads,
+      bookkeeping,
+      disabled,
+      withinBudget ? "within budget" : "OVER BUDGET");
+  report.add("profiler/zone", recording.zone, "ns");
+  report.add("profiler/clock-reads", recording.clockReads, "ns");
+  report.add("profiler/disabled-zone", disabled, "ns");
+  return withinBudget;
+}
+
+}  // namespace engine::benchmark
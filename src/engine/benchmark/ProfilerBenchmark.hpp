@@ -0,0 +1,14 @@
+#pragma once
+
+#include "BenchmarkReport.hpp"
+
+namespace engine::benchmark {
+
+/// Times empty profiler zones, recording and switched off at runtime, and
+/// prints nanoseconds per zone against the 50 ns budget. Where the two clock
+/// reads of a zone alone take most of that, the zone is held to what it adds
+/// on top of them.
+/// @return false if a recording zone is over the budget
+bool runProfilerBenchmark(BenchmarkReport &report);
+
+}  // namespace engine::benchmark
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ecs/register.hpp"
+#include "engine/component/TransformComponent.hpp"
+
+#include "SnapshotBenchmark.hpp"
+
+namespace engine::benchmark {
+
+namespace {
+
+using component::TransformComponent;
+
+constexpr int REPETITIONS = 7;
+constexpr size_t SNAPSHOT_FRAMES = 8;
+
+// Part of the entities a frame of gameplay writes to
+constexpr double CHANGED_FRACTION = 0.01;
+
+void changeEntities(
+    ecs::Register &register_,
+    const std::vector<ecs::EntityID> &entities,
+    std::mt19937 &generator) {
+  size_t changed = std::max<size_t>(
+      1, static_cast<size_t>(entities.size() * CHANGED_FRACTION));
+  std::uniform_int_distribution<size_t> pick(0, entities.size() - 1);
+  for (size_t i = 0; i < changed; i++) {
+    register_.get<TransformComponent>(entities[pick(generator)]).position +=
+        glm::vec3(1.0f);
+  }
+}
+
+template <typename Function> double microseconds(Function &&function) {
+  auto start = std::chrono::high_resolution_clock::now();
+  function();
+  auto end = std::chrono::high_resolution_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+}  // namespace
+
+void runSnapshotBenchmark(BenchmarkReport &report) {
+  std::cout << std::format(
+      "Snapshot benchmark, {} frame ring, {:.0f}% of entities change per "
+      "frame\n",
+      SNAPSHOT_FRAMES,
+      CHANGED_FRACTION * 100.0);
+
+  for (size_t count : {1024, 16384, 262144}) {
+    ecs::Register register_;
+    register_.setSnapshotFrames(SNAPSHOT_FRAMES);
+    std::mt19937 generator(42);
+
+    std::vector<ecs::EntityID> entities;
+    entities.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      TransformComponent transform;
+      entities.push_back(register_.createEntity(transform));
+    }
+
+    // The first lap of the ring copies everything
+    double fullTime = INFINITY;
+    for (size_t i = 0; i < SNAPSHOT_FRAMES; i++) {
+      changeEntities(register_, entities, generator);
+      fullTime = std::min(
+          fullTime, microseconds([&]() { register_.snapshot(); }));
+    }
+
+    double snapshotTime = INFINITY;
+    double restoreTime = INFINITY;
+    for (int i = 0; i < REPETITIONS; i++) {
+      changeEntities(register_, entities, generator);
+      uint64_t frame = 0;
+      snapshotTime = std::min(
+          snapshotTime,
+          microseconds([&]() { frame = register_.snapshot(); }));
+      changeEntities(register_, entities, generator);
+      restoreTime = std::min(
+          restoreTime, microseconds([&]() { register_.restore(frame); }));
+    }
+
+    std::cout << std::format(
+        "{:>8} entities  full {:9.1f} us  snapshot {:9.1f} us  restore "
+        "{:9.1f} us\n",
+        count,
+        fullTime,
+        snapshotTime,
+        restoreTime);
+    report.add(std::format("snapshots/{}/full", count), fullTime, "us");
+    report.add(
+        std::format("snapshots/{}/snapshot", count), snapshotTime, "us");
+    report.add(std::format("snapshots/{}/restore", count), restoreTime, "us");
+  }
+}
+
+}  // namespace engine::benchmark
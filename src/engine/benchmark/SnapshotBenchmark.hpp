@@ -0,0 +1,12 @@
+#pragma once
+
+#include "BenchmarkReport.hpp"
+
+namespace engine::benchmark {
+
+/// Times taking a world snapshot and rolling back to it for a few entity counts
+/// while a small part of the entities changes every frame, and prints
+/// microseconds per call
+void runSnapshotBenchmark(BenchmarkReport &report);
+
+}  // namespace engine::benchmark
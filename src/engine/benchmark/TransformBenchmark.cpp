@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "engine/component/TransformComponent.hpp"
+#include "engine/math/TransformKernels.hpp"
+
+#include "TransformBenchmark.hpp"
+
+namespace engine::benchmark {
+
+namespace {
+
+using component::TransformComponent;
+
+constexpr int REPETITIONS = 7;
+
+std::vector<TransformComponent> makeTransforms(size_t count) {
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+
+  std::vector<TransformComponent> transforms(count);
+  for (auto &transform : transforms) {
+    transform.position = glm::vec3(
+        distribution(generator),
+        distribution(generator),
+        distribution(generator));
+    transform.rotation = glm::normalize(glm::quat(
+        distribution(generator),
+        distribution(generator),
+        distribution(generator),
+        distribution(generator)));
+    transform.scale = glm::vec3(
+        distribution(generator),
+        distribution(generator),
+        distribution(generator));
+  }
+  return transforms;
+}
+
+// Runs the function a few times and keeps the fastest run so that scheduler
+// noise doesn't end up in the numbers
+template <typename Function>
+double bestNanosecondsPerMatrix(size_t count, Function &&function) {
+  double best = INFINITY;
+  for (int i = 0; i < REPETITIONS; i++) {
+    auto start = std::chrono::high_resolution_clock::now();
+    function();
+    auto end = std::chrono::high_resolution_clock::now();
+    double nanoseconds =
+        std::chrono::duration<double, std::nano>(end - start).count();
+    best = std::min(best, nanoseconds / static_cast<double>(count));
+  }
+  return best;
+}
+
+float maxError(
+    const std::vector<glm::mat4> &matrices,
+    const std::vector<glm::mat4> &reference) {
+  float error = 0.0f;
+  for (size_t i = 0; i < matrices.size(); i++) {
+    for (int column = 0; column < 4; column++) {
+      for (int row = 0; row < 4; row++) {
+        error = std::max(
+            error,
+            std::fabs(matrices[i][column][row] - reference[i][column][row]));
+      }
+    }
+  }
+  return error;
+}
+
+}  // namespace
+
+void runTransformBenchmark(BenchmarkReport &report) {
+  const math::TransformKernel kernels[] = {
+      math::TransformKernel::Scalar,
+      math::TransformKernel::SSE,
+      math::TransformKernel::AVX2};
+
+  std::cout << std::format(
+      "Transform benchmark, active kernel: {}\n",
+      math::getTransformKernelName(math::getActiveTransformKernel()));
+
+  for (size_t count : {1024, 16384, 262144}) {
+    auto transforms = makeTransforms(count);
+    std::vector<glm::mat4> reference(count);
+    std::vector<glm::mat4> matrices(count);
+
+    double glmTime = bestNanosecondsPerMatrix(count, [&]() {
+      math::computeModelMatricesGlm(
+          transforms.data(), reference.data(), count);
+    });
+    std::cout << std::format(
+        "{:>8} entities  {:<7} {:8.3f} ns/matrix\n", count, "glm", glmTime);
+    report.add(std::format("transforms/{}/glm", count), glmTime, "ns/matrix");
+
+    for (auto kernel : kernels) {
+      if (!math::isTransformKernelSupported(kernel)) {
+        continue;
+      }
+      double kernelTime = bestNanosecondsPerMatrix(count, [&]() {
+        math::computeModelMatrices(
+            transforms.data(), matrices.data(), count, kernel);
+      });
+      std::cout << std::format(
+          "{:>8} entities  {:<7} {:8.3f} ns/matrix  {:5.2f}x  max error {}\n",
+          count,
+          math::getTransformKernelName(kernel),
+          kernelTime,
+          glmTime / kernelTime,
+          maxError(matrices, reference));
+      report.add(
+          std::format(
+              "transforms/{}/{}",
+              count,
+              math::getTransformKernelName(kernel)),
+          kernelTime,
+          "ns/matrix");
+    }
+  }
+}
+
+}  // namespace engine::benchmark
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "BenchmarkReport.hpp"
+
+namespace engine::benchmark {
+
+/// Times every transform kernel the CPU supports against the scalar glm path
+/// for a few entity counts and prints nanoseconds per matrix
+void runTransformBenchmark(BenchmarkReport &report);
+
+}  // namespace engine::benchmark
@@ -6,7 +6,9 @@
 
 namespace engine::component {
 
+// Shared so frames still in flight keep the model alive after its entity or
+// shared value is gone
 struct ModelComponent {
-  std::unique_ptr<rlm::Model> model;
+  std::shared_ptr<rlm::Model> model;
 };
 }  // namespace engine::component
@@ -3,8 +3,8 @@
 #include <glm/ext/matrix_float4x4.hpp>
 
 namespace engine::component {
+// Camera of the frame, the model matrix of every draw is a push constant
 struct UniformBufferObject {
-  glm::mat4 model = glm::mat4(1.0f);
   glm::mat4 view = glm::mat4(1.0f);
   glm::mat4 proj = glm::mat4(1.0f);
 };
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#include "engine/event/EventBus.hpp"
+
+namespace engine::event {
+
+EventArena::EventArena(size_t capacity, std::pmr::memory_resource *upstream)
+    : upstream(upstream) {
+  for (Slot &slot : slots) {
+    slot.capacity = capacity;
+    if (capacity > 0) {
+      slot.buffer = static_cast<std::byte *>(
+          upstream->allocate(capacity, alignof(std::max_align_t)));
+    }
+  }
+}
+
+EventArena::~EventArena() {
+  for (Slot &slot : slots) {
+    releaseOverflow(slot);
+    if (slot.buffer != nullptr) {
+      upstream->deallocate(
+          slot.buffer, slot.capacity, alignof(std::max_align_t));
+    }
+  }
+}
+
+void EventArena::beginFrame() {
+  current = (current + 1) % FRAMES;
+  Slot &slot = slots[current];
+  if (slot.overflow.load(std::memory_order_relaxed) != nullptr) {
+    // Sized for the whole frame that overflowed, rounded up so a frame
+    // slightly busier than that doesn't overflow again
+    size_t capacity = std::bit_ceil(
+        slot.capacity + slot.overflowBytes.load(std::memory_order_relaxed));
+    releaseOverflow(slot);
+    if (slot.buffer != nullptr) {
+      upstream->deallocate(
+          slot.buffer, slot.capacity, alignof(std::max_align_t));
+    }
+    slot.buffer = static_cast<std::byte *>(
+        upstream->allocate(capacity, alignof(std::max_align_t)));
+    slot.capacity = capacity;
+  }
+  slot.used.store(0, std::memory_order_relaxed);
+  slot.overflowBytes.store(0, std::memory_order_relaxed);
+}
+
+void *EventArena::do_allocate(size_t bytes, size_t alignment) {
+  Slot &slot = slots[current];
+  if (slot.buffer == nullptr) {
+    return allocateOverflow(slot, bytes, alignment);
+  }
+  auto base = reinterpret_cast<uintptr_t>(slot.buffer);
+  size_t used = slot.used.load(std::memory_order_relaxed);
+  size_t offset = 0;
+  do {
+    offset = used + (alignment - (base + used) % alignment) % alignment;
+    if (offset > slot.capacity || bytes > slot.capacity - offset) {
+      return allocateOverflow(slot, bytes, alignment);
+    }
+  } while (!slot.used.compare_exchange_weak(
+      used, offset + bytes, std::memory_order_relaxed));
+  return slot.buffer + offset;
+}
+
+void *EventArena::allocateOverflow(
+    Slot &slot,
+    size_t bytes,
+    size_t alignment) {
+  // One block per allocation, segments double so a frame only takes a few
+  alignment = std::max(alignment, alignof(Overflow));
+  size_t header = (sizeof(Overflow) + alignment - 1) / alignment * alignment;
+  size_t size = header + bytes;
+  auto *block = static_cast<Overflow *>(upstream->allocate(size, alignment));
+  *block = Overflow{slot.overflow.load(std::memory_order_relaxed), size,
+                    alignment};
+  while (!slot.overflow.compare_exchange_weak(
+      block->next, block, std::memory_order_relaxed)) {
+  }
+  slot.overflowBytes.fetch_add(bytes, std::memory_order_relaxed);
+  return reinterpret_cast<std::byte *>(block) + header;
+}
+
+void EventArena::releaseOverflow(Slot &slot) {
+  Overflow *block = slot.overflow.exchange(nullptr, std::memory_order_relaxed);
+  while (block != nullptr) {
+    Overflow *next = block->next;
+    upstream->deallocate(block, block->size, block->alignment);
+    block = next;
+  }
+}
+
+void EventBus::swap() {
+  // The buffers the channels write next held the frame before last, whose
+  // segments the arena recycles now. Last frame's stay readable.
+  arena.beginFrame();
+  for (auto &channel : channels) {
+    if (channel != nullptr) {
+      channel->swap();
+    }
+  }
+}
+
+uint32_t EventBus::nextEventTypeID() {
+  // Only runs during static initialization, which is single threaded
+  static uint32_t nextID = 0;
+  return nextID++;
+}
+
+}  // namespace engine::event
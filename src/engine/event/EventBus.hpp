@@ -0,0 +1,329 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace engine::event {
+
+/// Arena the channels take their segments from, so the memory of a frame's
+/// events is recycled two frames later without anything being freed. Each of
+/// the FRAMES slots is one block that beginFrame hands out from the start
+/// again, and writers take their segments with a compare and swap on its
+/// offset, so emitting never locks. A frame that outgrows its block takes
+/// extra blocks from upstream, which then has to be thread safe, and the next
+/// time the slot comes around its block is reallocated to fit them all.
+class EventArena : public std::pmr::memory_resource {
+ public:
+  // Frames whose segments are alive at once, the one being written and the
+  // one being read
+  static constexpr size_t FRAMES = 2;
+
+  /// @param capacity Initial size of the block of each slot
+  EventArena(size_t capacity, std::pmr::memory_resource *upstream);
+  ~EventArena() override;
+
+  EventArena(const EventArena &) = delete;
+  EventArena &operator=(const EventArena &) = delete;
+
+  /// Recycles the segments of the frame before last. Must not run while
+  /// anyone emits.
+  void beginFrame();
+
+ private:
+  // Extra upstream block of a frame, the header sits at its start
+  struct Overflow {
+    Overflow *next;
+    size_t size;
+    size_t alignment;
+  };
+
+  struct Slot {
+    std::byte *buffer = nullptr;
+    size_t capacity = 0;
+    std::atomic<size_t> used = 0;
+    std::atomic<Overflow *> overflow = nullptr;
+    // Bytes the overflow blocks handed out, the block grows by this much
+    std::atomic<size_t> overflowBytes = 0;
+  };
+
+  void *do_allocate(size_t bytes, size_t alignment) override;
+
+  // Memory comes back all at once when the slot is recycled
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  void *allocateOverflow(Slot &slot, size_t bytes, size_t alignment);
+
+  void releaseOverflow(Slot &slot);
+
+  std::pmr::memory_resource *upstream;
+  std::array<Slot, FRAMES> slots;
+  // Only changes in beginFrame, while nobody emits
+  size_t current = 0;
+};
+
+/// Untyped part of a channel so the bus can swap every channel at the frame
+/// boundary
+class EventChannelBase {
+ public:
+  virtual ~EventChannelBase() = default;
+
+  /// Makes the events written this frame the readable ones and recycles the
+  /// storage of the frame before. Must not run while anyone emits.
+  virtual void swap() = 0;
+};
+
+/// Events of one type. Any number of threads emit into the frame being written
+/// without locks, everyone reads the events of the previous frame after swap.
+/// The storage is a list of segments that double in size, so emitting never
+/// moves events. The segments come from a frame arena and are dropped without
+/// deallocating when their buffer is written again, the arena has to keep a
+/// frame's memory until the swap after next, like EventArena does. Once the
+/// arena fits the busiest frame, nothing allocates.
+template <typename Event> class EventChannel : public EventChannelBase {
+  // The segments are reused without running destructors
+  static_assert(
+      std::is_trivially_copyable_v<Event> &&
+          std::is_trivially_destructible_v<Event>,
+      "events have to be trivially copyable");
+
+ public:
+  explicit EventChannel(std::pmr::memory_resource *arena)
+      : buffers{FrameBuffer(arena), FrameBuffer(arena)} {}
+
+  EventChannel(const EventChannel &) = delete;
+  EventChannel &operator=(const EventChannel &) = delete;
+
+  /// Safe to call from several threads at once
+  /// @throws std::runtime_error if the frame ran out of segments
+  void emit(const Event &event) { buffers[writing].push(event); }
+
+  void swap() override {
+    writing ^= 1;
+    buffers[writing].reset();
+    buffers[writing ^ 1].waitForWriters();
+  }
+
+  /// Number of events emitted last frame
+  size_t size() const { return buffers[writing ^ 1].size(); }
+
+  bool empty() const { return size() == 0; }
+
+  /// Calls function with every event emitted last frame, events of a single
+  /// writer keep their order
+  template <typename Function> void each(Function &&function) const {
+    buffers[writing ^ 1].each(function);
+  }
+
+ private:
+  // The first segment holds FIRST_SEGMENT_EVENTS, every next one twice the
+  // previous, which covers about four billion events per frame
+  static constexpr size_t FIRST_SEGMENT_EVENTS = 64;
+  static constexpr size_t MAX_SEGMENTS = 26;
+
+  class FrameBuffer {
+   public:
+    explicit FrameBuffer(std::pmr::memory_resource *arena) : arena(arena) {}
+
+    // The index is only taken once its segment exists, so if getting the
+    // segment throws, writeIndex and committed stay in step and the swap
+    // doesn't wait for an event that never comes
+    void push(const Event &event) {
+      size_t index = writeIndex.load(std::memory_order_relaxed);
+      Event *events = nullptr;
+      do {
+        events = getSegment(segmentOf(index));
+      } while (!writeIndex.compare_exchange_weak(
+          index, index + 1, std::memory_order_relaxed));
+      events[index - segmentStart(segmentOf(index))] = event;
+      committed.fetch_add(1, std::memory_order_release);
+    }
+
+    // Writers that got an index before the swap may still be copying their
+    // event, reading has to wait for them
+    void waitForWriters() {
+      size_t count = writeIndex.load(std::memory_order_relaxed);
+      while (committed.load(std::memory_order_acquire) < count) {
+        std::this_thread::yield();
+      }
+      readCount = count;
+    }
+
+    // The arena recycles the memory of the segments
+    void reset() {
+      for (auto &segment : segments) {
+        segment.store(nullptr, std::memory_order_relaxed);
+      }
+      writeIndex.store(0, std::memory_order_relaxed);
+      committed.store(0, std::memory_order_relaxed);
+      readCount = 0;
+    }
+
+    size_t size() const { return readCount; }
+
+    template <typename Function> void each(Function &function) const {
+      size_t index = 0;
+      for (size_t segment = 0; index < readCount; segment++) {
+        const Event *events = segments[segment].load(std::memory_order_relaxed);
+        size_t end = std::min(readCount, segmentStart(segment + 1));
+        for (; index < end; index++) {
+          function(events[index - segmentStart(segment)]);
+        }
+      }
+    }
+
+   private:
+    static size_t segmentOf(size_t index) {
+      return std::bit_width(index / FIRST_SEGMENT_EVENTS + 1) - 1;
+    }
+
+    static size_t segmentStart(size_t segment) {
+      return FIRST_SEGMENT_EVENTS * ((size_t{1} << segment) - 1);
+    }
+
+    static size_t segmentEvents(size_t segment) {
+      return FIRST_SEGMENT_EVENTS << segment;
+    }
+
+    // Writers that hit the same missing segment race to install theirs, the
+    // allocations of the losers stay unused in the arena until it recycles
+    // the frame
+    Event *getSegment(size_t segment) {
+      if (segment >= MAX_SEGMENTS) {
+        throw std::runtime_error("too many events in one frame");
+      }
+      Event *events = segments[segment].load(std::memory_order_acquire);
+      if (events != nullptr) {
+        return events;
+      }
+      events = static_cast<Event *>(arena->allocate(
+          segmentEvents(segment) * sizeof(Event), alignof(Event)));
+      Event *expected = nullptr;
+      if (!segments[segment].compare_exchange_strong(
+              expected,
+              events,
+              std::memory_order_acq_rel,
+              std::memory_order_acquire)) {
+        return expected;
+      }
+      return events;
+    }
+
+    std::pmr::memory_resource *arena;
+    std::array<std::atomic<Event *>, MAX_SEGMENTS> segments{};
+    // Kept on separate cache lines, every writer touches both
+    alignas(64) std::atomic<size_t> writeIndex = 0;
+    alignas(64) std::atomic<size_t> committed = 0;
+    size_t readCount = 0;
+  };
+
+  std::array<FrameBuffer, 2> buffers;
+  // Index of the buffer emit writes to, the other one is read
+  unsigned writing = 0;
+};
+
+/// One channel per event type. Channels are created on first use by channel,
+/// which isn't thread safe, so create them while setting up and hand the
+/// channels or the bus to worker threads afterwards. The events of every
+/// channel live in the arena of the bus.
+class EventBus {
+ public:
+  static constexpr size_t DEFAULT_ARENA_CAPACITY = 64 * 1024;
+
+  /// @param capacity Initial size of each frame block of the arena
+  /// @param upstream Where the arena and the channels get their memory
+  explicit EventBus(
+      size_t capacity = DEFAULT_ARENA_CAPACITY,
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+      : arena(capacity, upstream), upstream(upstream), channels(upstream) {}
+
+  template <typename Event> EventChannel<Event> &channel() {
+    uint32_t typeID = eventTypeID<Event>;
+    if (typeID >= channels.size()) {
+      channels.resize(typeID + 1);
+    }
+    if (channels[typeID] == nullptr) {
+      std::pmr::polymorphic_allocator<EventChannel<Event>> allocator(upstream);
+      channels[typeID] = ChannelPtr(
+          allocator.template new_object<EventChannel<Event>>(&arena),
+          ChannelDeleter{upstream, &destroyChannel<Event>});
+    }
+    return static_cast<EventChannel<Event> &>(*channels[typeID]);
+  }
+
+  /// Safe to call from several threads once the channel exists
+  /// @throws std::runtime_error if no channel was created for the event
+  template <typename Event> void emit(const Event &event) {
+    findChannel<Event>().emit(event);
+  }
+
+  /// Calls function with every event of the type emitted last frame
+  template <typename Event, typename Function>
+  void each(Function &&function) const {
+    uint32_t typeID = eventTypeID<Event>;
+    if (typeID < channels.size() && channels[typeID] != nullptr) {
+      static_cast<const EventChannel<Event> &>(*channels[typeID])
+          .each(function);
+    }
+  }
+
+  /// Called by the engine at the start of every frame, before the systems run.
+  /// Must not run while anyone emits.
+  void swap();
+
+ private:
+  template <typename Event> EventChannel<Event> &findChannel() {
+    uint32_t typeID = eventTypeID<Event>;
+    if (typeID >= channels.size() || channels[typeID] == nullptr) {
+      throw std::runtime_error("event has no channel on the bus");
+    }
+    return static_cast<EventChannel<Event> &>(*channels[typeID]);
+  }
+
+  static uint32_t nextEventTypeID();
+
+  // Channels are made with new_object of a polymorphic_allocator on upstream,
+  // deleting one needs its event type back for the size
+  struct ChannelDeleter {
+    std::pmr::memory_resource *resource = nullptr;
+    void (*destroy)(std::pmr::memory_resource *, EventChannelBase *) = nullptr;
+
+    void operator()(EventChannelBase *channel) const {
+      destroy(resource, channel);
+    }
+  };
+
+  using ChannelPtr = std::unique_ptr<EventChannelBase, ChannelDeleter>;
+
+  template <typename Event>
+  static void destroyChannel(
+      std::pmr::memory_resource *resource,
+      EventChannelBase *channel) {
+    std::pmr::polymorphic_allocator<EventChannel<Event>>(resource)
+        .delete_object(static_cast<EventChannel<Event> *>(channel));
+  }
+
+  // Assigned during static initialization like component ids
+  template <typename Event>
+  inline static const uint32_t eventTypeID = nextEventTypeID();
+
+  EventArena arena;
+  std::pmr::memory_resource *upstream;
+  std::pmr::vector<ChannelPtr> channels;
+};
+
+}  // namespace engine::event
@@ -0,0 +1,339 @@
+#include <cstddef>
+#include <stdexcept>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TETCIPP_X86_KERNELS 1
+#else
+#define TETCIPP_X86_KERNELS 0
+#endif
+
+#include "engine/component/TransformComponent.hpp"
+
+#include "TransformKernels.hpp"
+
+namespace engine::math {
+
+namespace {
+
+using component::TransformComponent;
+
+// The vector kernels read the transforms with a fixed float stride, so the
+// component has to stay a tightly packed bag of floats
+static_assert(sizeof(TransformComponent) % sizeof(float) == 0);
+constexpr int TRANSFORM_STRIDE = sizeof(TransformComponent) / sizeof(float);
+
+void computeScalar(
+    const TransformComponent *transforms,
+    glm::mat4 *matrices,
+    size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const TransformComponent &transform = transforms[i];
+    const glm::quat &q = transform.rotation;
+    const glm::vec3 &s = transform.scale;
+
+    float x2 = q.x + q.x;
+    float y2 = q.y + q.y;
+    float z2 = q.z + q.z;
+    float xx = q.x * x2;
+    float yy = q.y * y2;
+    float zz = q.z * z2;
+    float xy = q.x * y2;
+    float xz = q.x * z2;
+    float yz = q.y * z2;
+    float wx = q.w * x2;
+    float wy = q.w * y2;
+    float wz = q.w * z2;
+
+    glm::mat4 &m = matrices[i];
+    m[0] = glm::vec4(
+        (1.0f - (yy + zz)) * s.x, (xy + wz) * s.x, (xz - wy) * s.x, 0.0f);
+    m[1] = glm::vec4(
+        (xy - wz) * s.y, (1.0f - (xx + zz)) * s.y, (yz + wx) * s.y, 0.0f);
+    m[2] = glm::vec4(
+        (xz + wy) * s.z, (yz - wx) * s.z, (1.0f - (xx + yy)) * s.z, 0.0f);
+    m[3] = glm::vec4(transform.position, 1.0f);
+  }
+}
+
+#if TETCIPP_X86_KERNELS
+
+// Processes 4 transforms at a time. Every register holds one matrix element
+// for 4 entities, so the 16 element registers are transposed in groups of 4
+// to get back to 4 column major matrices.
+void computeSSE(
+    const TransformComponent *transforms,
+    glm::mat4 *matrices,
+    size_t count) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 zero = _mm_setzero_ps();
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const TransformComponent *t = transforms + i;
+    __m128 qx = _mm_set_ps(
+        t[3].rotation.x, t[2].rotation.x, t[1].rotation.x, t[0].rotation.x);
+    __m128 qy = _mm_set_ps(
+        t[3].rotation.y, t[2].rotation.y, t[1].rotation.y, t[0].rotation.y);
+    __m128 qz = _mm_set_ps(
+        t[3].rotation.z, t[2].rotation.z, t[1].rotation.z, t[0].rotation.z);
+    __m128 qw = _mm_set_ps(
+        t[3].rotation.w, t[2].rotation.w, t[1].rotation.w, t[0].rotation.w);
+    __m128 sx =
+        _mm_set_ps(t[3].scale.x, t[2].scale.x, t[1].scale.x, t[0].scale.x);
+    __m128 sy =
+        _mm_set_ps(t[3].scale.y, t[2].scale.y, t[1].scale.y, t[0].scale.y);
+    __m128 sz =
+        _mm_set_ps(t[3].scale.z, t[2].scale.z, t[1].scale.z, t[0].scale.z);
+
+    __m128 x2 = _mm_add_ps(qx, qx);
+    __m128 y2 = _mm_add_ps(qy, qy);
+    __m128 z2 = _mm_add_ps(qz, qz);
+    __m128 xx = _mm_mul_ps(qx, x2);
+    __m128 yy = _mm_mul_ps(qy, y2);
+    __m128 zz = _mm_mul_ps(qz, z2);
+    __m128 xy = _mm_mul_ps(qx, y2);
+    __m128 xz = _mm_mul_ps(qx, z2);
+    __m128 yz = _mm_mul_ps(qy, z2);
+    __m128 wx = _mm_mul_ps(qw, x2);
+    __m128 wy = _mm_mul_ps(qw, y2);
+    __m128 wz = _mm_mul_ps(qw, z2);
+
+    __m128 c0[4] = {
+        _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), sx),
+        _mm_mul_ps(_mm_add_ps(xy, wz), sx),
+        _mm_mul_ps(_mm_sub_ps(xz, wy), sx),
+        zero};
+    __m128 c1[4] = {
+        _mm_mul_ps(_mm_sub_ps(xy, wz), sy),
+        _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), sy),
+        _mm_mul_ps(_mm_add_ps(yz, wx), sy),
+        zero};
+    __m128 c2[4] = {
+        _mm_mul_ps(_mm_add_ps(xz, wy), sz),
+        _mm_mul_ps(_mm_sub_ps(yz, wx), sz),
+        _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), sz),
+        zero};
+    __m128 c3[4] = {
+        _mm_set_ps(
+            t[3].position.x, t[2].position.x, t[1].position.x, t[0].position.x),
+        _mm_set_ps(
+            t[3].position.y, t[2].position.y, t[1].position.y, t[0].position.y),
+        _mm_set_ps(
+            t[3].position.z, t[2].position.z, t[1].position.z, t[0].position.z),
+        one};
+
+    __m128 *columns[4] = {c0, c1, c2, c3};
+    for (int column = 0; column < 4; column++) {
+      __m128 *c = columns[column];
+      _MM_TRANSPOSE4_PS(c[0], c[1], c[2], c[3]);
+      for (int entity = 0; entity < 4; entity++) {
+        _mm_storeu_ps(&matrices[i + entity][column][0], c[entity]);
+      }
+    }
+  }
+
+  computeScalar(transforms + i, matrices + i, count - i);
+}
+
+__attribute__((target("avx2"))) inline void transpose8x8(__m256 *rows) {
+  __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+  __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+  __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+  __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+  __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+  __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+  __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+  __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+  rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+  rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+  rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+  rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+  rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+  rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+  rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+  rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// Processes 8 transforms at a time. The fields are gathered straight out of
+// the component column and the 16 matrix element registers are written back
+// as two 8x8 transposes, one for each half of the 8 matrices.
+__attribute__((target("avx2"))) void computeAVX2(
+    const TransformComponent *transforms,
+    glm::mat4 *matrices,
+    size_t count) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256i offsets = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+      _mm256_set1_epi32(TRANSFORM_STRIDE));
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const TransformComponent &t = transforms[i];
+    __m256 qx = _mm256_i32gather_ps(&t.rotation.x, offsets, 4);
+    __m256 qy = _mm256_i32gather_ps(&t.rotation.y, offsets, 4);
+    __m256 qz = _mm256_i32gather_ps(&t.rotation.z, offsets, 4);
+    __m256 qw = _mm256_i32gather_ps(&t.rotation.w, offsets, 4);
+    __m256 sx = _mm256_i32gather_ps(&t.scale.x, offsets, 4);
+    __m256 sy = _mm256_i32gather_ps(&t.scale.y, offsets, 4);
+    __m256 sz = _mm256_i32gather_ps(&t.scale.z, offsets, 4);
+
+    __m256 x2 = _mm256_add_ps(qx, qx);
+    __m256 y2 = _mm256_add_ps(qy, qy);
+    __m256 z2 = _mm256_add_ps(qz, qz);
+    __m256 xx = _mm256_mul_ps(qx, x2);
+    __m256 yy = _mm256_mul_ps(qy, y2);
+    __m256 zz = _mm256_mul_ps(qz, z2);
+    __m256 xy = _mm256_mul_ps(qx, y2);
+    __m256 xz = _mm256_mul_ps(qx, z2);
+    __m256 yz = _mm256_mul_ps(qy, z2);
+    __m256 wx = _mm256_mul_ps(qw, x2);
+    __m256 wy = _mm256_mul_ps(qw, y2);
+    __m256 wz = _mm256_mul_ps(qw, z2);
+
+    // Elements 0-7 are the first two columns, 8-15 the last two
+    __m256 low[8] = {
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(yy, zz)), sx),
+        _mm256_mul_ps(_mm256_add_ps(xy, wz), sx),
+        _mm256_mul_ps(_mm256_sub_ps(xz, wy), sx),
+        zero,
+        _mm256_mul_ps(_mm256_sub_ps(xy, wz), sy),
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, zz)), sy),
+        _mm256_mul_ps(_mm256_add_ps(yz, wx), sy),
+        zero};
+    __m256 high[8] = {
+        _mm256_mul_ps(_mm256_add_ps(xz, wy), sz),
+        _mm256_mul_ps(_mm256_sub_ps(yz, wx), sz),
+        _mm256_mul_ps(_mm256_sub_ps(one, _mm256_add_ps(xx, yy)), sz),
+        zero,
+        _mm256_i32gather_ps(&t.position.x, offsets, 4),
+        _mm256_i32gather_ps(&t.position.y, offsets, 4),
+        _mm256_i32gather_ps(&t.position.z, offsets, 4),
+        one};
+
+    transpose8x8(low);
+    transpose8x8(high);
+    for (int entity = 0; entity < 8; entity++) {
+      float *matrix = &matrices[i + entity][0][0];
+      _mm256_storeu_ps(matrix, low[entity]);
+      _mm256_storeu_ps(matrix + 8, high[entity]);
+    }
+  }
+
+  computeScalar(transforms + i, matrices + i, count - i);
+}
+
+#endif
+
+using KernelFunction =
+    void (*)(const TransformComponent *, glm::mat4 *, size_t);
+
+KernelFunction getKernelFunction(TransformKernel kernel) {
+  switch (kernel) {
+#if TETCIPP_X86_KERNELS
+  case TransformKernel::AVX2:
+    return &computeAVX2;
+  case TransformKernel::SSE:
+    return &computeSSE;
+#endif
+  default:
+    return &computeScalar;
+  }
+}
+
+TransformKernel detectTransformKernel() {
+#if TETCIPP_X86_KERNELS
+  // Runs during static initialization, so the feature bits aren't guaranteed to
+  // be filled in yet
+  __builtin_cpu_init();
+#endif
+  if (isTransformKernelSupported(TransformKernel::AVX2)) {
+    return TransformKernel::AVX2;
+  }
+  if (isTransformKernelSupported(TransformKernel::SSE)) {
+    return TransformKernel::SSE;
+  }
+  return TransformKernel::Scalar;
+}
+
+const TransformKernel activeKernel = detectTransformKernel();
+const KernelFunction activeKernelFunction = getKernelFunction(activeKernel);
+
+}  // namespace
+
+void computeModelMatrices(
+    const component::TransformComponent *transforms,
+    glm::mat4 *matrices,
+    size_t count) {
+  activeKernelFunction(transforms, matrices, count);
+}
+
+void computeModelMatrices(
+    const component::TransformComponent *transforms,
+    glm::mat4 *matrices,
+    size_t count,
+    TransformKernel kernel) {
+  if (!isTransformKernelSupported(kernel)) {
+    throw std::runtime_error("transform kernel is not supported by this CPU");
+  }
+  getKernelFunction(kernel)(transforms, matrices, count);
+}
+
+void computeModelMatricesGlm(
+    const component::TransformComponent *transforms,
+    glm::mat4 *matrices,
+    size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const TransformComponent &transform = transforms[i];
+    matrices[i] = glm::translate(glm::mat4(1.0f), transform.position) *
+                  glm::mat4_cast(transform.rotation) *
+                  glm::scale(glm::mat4(1.0f), transform.scale);
+  }
+}
+
+bool isTransformKernelSupported(TransformKernel kernel) {
+  switch (kernel) {
+  case TransformKernel::Scalar:
+    return true;
+#if TETCIPP_X86_KERNELS
+  case TransformKernel::SSE:
+    return __builtin_cpu_supports("sse2");
+  case TransformKernel::AVX2:
+    return __builtin_cpu_supports("avx2");
+#endif
+  default:
+    return false;
+  }
+}
+
+TransformKernel getActiveTransformKernel() { return activeKernel; }
+
+const char *getTransformKernelName(TransformKernel kernel) {
+  switch (kernel) {
+  case TransformKernel::Scalar:
+    return "scalar";
+  case TransformKernel::SSE:
+    return "sse";
+  case TransformKernel::AVX2:
+    return "avx2";
+  }
+  return "unknown";
+}
+
+}  // namespace engine::math
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "engine/component/TransformComponent.hpp"
+
+namespace engine::math {
+
+enum class TransformKernel { Scalar, SSE, AVX2 };
+
+/// Builds translation * rotation * scale model matrices for a contiguous run of
+/// transforms. The kernel is picked once based on the features the CPU reports
+/// at runtime and falls back to the scalar version everywhere else.
+/// @param transforms Input transforms, rotations are expected to be unit
+/// quaternions
+/// @param matrices Output array with room for at least count matrices
+void computeModelMatrices(
+    const component::TransformComponent *transforms,
+    glm::mat4 *matrices,
+    size_t count);
+
+/// Same as computeModelMatrices but forces a specific kernel, mostly useful for
+/// benchmarking and validating the kernels against each other
+/// @throws std::runtime_error if the CPU doesn't support the kernel
+void computeModelMatrices(
+    const component::TransformComponent *transforms,
+    glm::mat4 *matrices,
+    size_t count,
+    TransformKernel kernel);
+
+/// Reference path that composes the matrices one by one using glm
+void computeModelMatricesGlm(
+    const component::TransformComponent *transforms,
+    glm::mat4 *matrices,
+    size_t count);
+
+bool isTransformKernelSupported(TransformKernel kernel);
+
+/// @return The kernel computeModelMatrices dispatches to on this machine
+TransformKernel getActiveTransformKernel();
+
+const char *getTransformKernelName(TransformKernel kernel);
+
+}  // namespace engine::math
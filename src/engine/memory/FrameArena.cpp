@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+#include "FrameArena.hpp"
+
+namespace engine::memory {
+
+FrameArena::FrameArena(
+    size_t capacity,
+    std::pmr::memory_resource *upstream)
+    : upstream(upstream) {
+  for (Slot &slot : slots) {
+    slot.capacity = capacity;
+    if (capacity > 0) {
+      slot.buffer = static_cast<std::byte *>(
+          upstream->allocate(capacity, alignof(std::max_align_t)));
+    }
+  }
+}
+
+FrameArena::~FrameArena() {
+  for (Slot &slot : slots) {
+    releaseOverflow(slot);
+    if (slot.buffer != nullptr) {
+      upstream->deallocate(
+          slot.buffer, slot.capacity, alignof(std::max_align_t));
+    }
+  }
+}
+
+void FrameArena::beginFrame() {
+  current = (current + 1) % FRAMES;
+  Slot &slot = slots[current];
+  if (slot.overflow != nullptr) {
+    // Sized for the whole frame that overflowed, rounded up so a frame
+    // slightly busier than that doesn't overflow again
+    size_t capacity = std::bit_ceil(slot.capacity + slot.overflowBytes);
+    releaseOverflow(slot);
+    if (slot.buffer != nullptr) {
+      upstream->deallocate(
+          slot.buffer, slot.capacity, alignof(std::max_align_t));
+    }
+    slot.buffer = static_cast<std::byte *>(
+        upstream->allocate(capacity, alignof(std::max_align_t)));
+    slot.capacity = capacity;
+  }
+  slot.used = 0;
+  slot.overflowCount = 0;
+  slot.overflowBytes = 0;
+}
+
+size_t FrameArena::getUsed() const {
+  const Slot &slot = slots[current];
+  return slot.used + slot.overflowBytes;
+}
+
+void *FrameArena::bump(
+    std::byte *buffer,
+    size_t capacity,
+    size_t &used,
+    size_t bytes,
+    size_t alignment) {
+  if (buffer == nullptr) {
+    return nullptr;
+  }
+  auto address = reinterpret_cast<uintptr_t>(buffer) + used;
+  size_t padding = (alignment - address % alignment) % alignment;
+  if (padding + bytes > capacity - used) {
+    return nullptr;
+  }
+  used += padding + bytes;
+  return buffer + (used - bytes);
+}
+
+void *FrameArena::do_allocate(size_t bytes, size_t alignment) {
+  Slot &slot = slots[current];
+  void *pointer = bump(slot.buffer, slot.capacity, slot.used, bytes, alignment);
+  if (pointer != nullptr) {
+    return pointer;
+  }
+  return allocateOverflow(slot, bytes, alignment);
+}
+
+void *FrameArena::allocateOverflow(
+    Slot &slot,
+    size_t bytes,
+    size_t alignment) {
+  // Later overflows of the frame try the newest block first
+  Overflow *block = slot.overflow;
+  if (block != nullptr) {
+    void *pointer = bump(
+        reinterpret_cast<std::byte *>(block),
+        block->size,
+        block->used,
+        bytes,
+        alignment);
+    if (pointer != nullptr) {
+      slot.overflowBytes += bytes;
+      return pointer;
+    }
+  }
+
+  // At least as large as the slot's block, a frame that overflows once
+  // usually keeps going
+  size_t size = std::max(
+      sizeof(Overflow) + alignment + bytes, std::max<size_t>(slot.capacity, 1));
+  block = static_cast<Overflow *>(
+      upstream->allocate(size, alignof(std::max_align_t)));
+  *block = Overflow{slot.overflow, size, sizeof(Overflow)};
+  slot.overflow = block;
+  slot.overflowCount++;
+  slot.overflowBytes += bytes;
+  return bump(
+      reinterpret_cast<std::byte *>(block),
+      block->size,
+      block->used,
+      bytes,
+      alignment);
+}
+
+void FrameArena::releaseOverflow(Slot &slot) {
+  while (slot.overflow != nullptr) {
+    Overflow *next = slot.overflow->next;
+    upstream->deallocate(
+        slot.overflow, slot.overflow->size, alignof(std::max_align_t));
+    slot.overflow = next;
+  }
+}
+
+}  // namespace engine::memory
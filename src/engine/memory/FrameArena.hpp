@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+
+namespace engine::memory {
+
+/// Bump allocator for memory that only lives for a frame. Each of the FRAMES
+/// slots is one block that beginFrame hands out from the start again, so
+/// whatever a frame allocated stays valid while the next frame runs and is
+/// dropped without running deallocate. A frame that needs more than its block
+/// takes extra blocks from upstream, and the next time the slot comes around
+/// its block is reallocated to fit them all. Once every slot has seen the
+/// busiest frame, frames allocate nothing from upstream.
+///
+/// Not thread safe, it belongs to the thread that runs the simulation.
+class FrameArena : public std::pmr::memory_resource {
+ public:
+  // Frames whose allocations are alive at once, the one being built and the
+  // one before it
+  static constexpr size_t FRAMES = 2;
+  static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+  /// @param capacity Initial size of the block of each slot
+  explicit FrameArena(
+      size_t capacity = DEFAULT_CAPACITY,
+      std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+  ~FrameArena() override;
+
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  /// Moves to the next slot and recycles it. Everything allocated FRAMES
+  /// frames ago becomes invalid.
+  void beginFrame();
+
+  /// Bytes handed out this frame, overflow blocks included
+  size_t getUsed() const;
+
+  /// Size of the block of the current slot
+  size_t getCapacity() const { return slots[current].capacity; }
+
+  /// Upstream allocations the current frame needed beyond its block
+  size_t getOverflowCount() const { return slots[current].overflowCount; }
+
+ private:
+  // Extra upstream block of a frame, the header sits at its start
+  struct Overflow {
+    Overflow *next;
+    size_t size;
+    size_t used;
+  };
+
+  struct Slot {
+    std::byte *buffer = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    Overflow *overflow = nullptr;
+    size_t overflowCount = 0;
+    // Bytes the overflow blocks handed out, the block grows by this much
+    size_t overflowBytes = 0;
+  };
+
+  void *do_allocate(size_t bytes, size_t alignment) override;
+
+  // Memory comes back all at once when the slot is recycled
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(
+      const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  // Bumps the offset of a block of the given size
+  // @return nullptr if the allocation doesn't fit
+  static void *bump(
+      std::byte *buffer,
+      size_t capacity,
+      size_t &used,
+      size_t bytes,
+      size_t alignment);
+
+  void *allocateOverflow(Slot &slot, size_t bytes, size_t alignment);
+
+  void releaseOverflow(Slot &slot);
+
+  std::pmr::memory_resource *upstream;
+  std::array<Slot, FRAMES> slots;
+  size_t current = 0;
+};
+
+}  // namespace engine::memory
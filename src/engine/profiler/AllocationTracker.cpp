@@ -0,0 +1,392 @@
+#include "engine/profiler/AllocationTracker.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace engine::profiler {
+
+namespace detail {
+constinit thread_local const char *currentZone = nullptr;
+}  // namespace detail
+
+namespace {
+
+// Counters of one zone. Zones are keyed by the address of their name, which
+// is a string literal or a name that outlives the profiler.
+struct SiteCounter {
+  std::atomic<const char *> zone = nullptr;
+  std::atomic<uint64_t> count = 0;
+  std::atomic<uint64_t> bytes = 0;
+};
+
+// Open addressing over a fixed table, operator new can't allocate to grow it.
+// Zones past the table's capacity share OVERFLOW_ZONE.
+constexpr size_t SITE_SLOTS = 1024;
+constexpr const char *OVERFLOW_ZONE = "<other zones>";
+
+// Constant initialized, so allocations made by static initializers before
+// main are counted too
+constinit std::array<SiteCounter, SITE_SLOTS> siteCounters{};
+constinit SiteCounter overflowSite{};
+constinit std::atomic<uint64_t> frees = 0;
+
+// Set while takeAllocations fills its vector
+constinit thread_local bool suspended = false;
+
+SiteCounter &findSite(const char *zone) {
+  auto hash = reinterpret_cast<uintptr_t>(zone) * 0x9E3779B97F4A7C15ull;
+  size_t start = static_cast<size_t>(hash >> 32) % SITE_SLOTS;
+  for (size_t probe = 0; probe < SITE_SLOTS; probe++) {
+    SiteCounter &site = siteCounters[(start + probe) % SITE_SLOTS];
+    const char *current = site.zone.load(std::memory_order_acquire);
+    if (current == zone) {
+      return site;
+    }
+    if (current == nullptr &&
+        site.zone.compare_exchange_strong(
+            current, zone, std::memory_order_acq_rel)) {
+      return site;
+    }
+    // Another thread may have claimed the slot for the same zone
+    if (current == zone) {
+      return site;
+    }
+  }
+  return overflowSite;
+}
+
+}  // namespace
+
+bool isAllocationTrackerEnabled() {
+#ifdef ENGINE_ALLOCATION_TRACKER
+  return true;
+#else
+  return false;
+#endif
+}
+
+AllocationCounts takeAllocations(std::vector<AllocationSite> &sites) {
+  suspended = true;
+  sites.clear();
+  AllocationCounts counts;
+  auto take = [&](SiteCounter &site, const char *zone) {
+    uint64_t count = site.count.exchange(0, std::memory_order_relaxed);
+    uint64_t bytes = site.bytes.exchange(0, std::memory_order_relaxed);
+    if (count > 0) {
+      sites.push_back({zone, count, bytes});
+      counts.count += count;
+      counts.bytes += bytes;
+    }
+  };
+  for (SiteCounter &site : siteCounters) {
+    const char *zone = site.zone.load(std::memory_order_acquire);
+    if (zone != nullptr) {
+      take(site, zone);
+    }
+  }
+  take(overflowSite, OVERFLOW_ZONE);
+  counts.frees = frees.exchange(0, std::memory_order_relaxed);
+  std::sort(
+      sites.begin(),
+      sites.end(),
+      [](const AllocationSite &a, const AllocationSite &b) {
+        return a.count > b.count;
+      });
+  suspended = false;
+  return counts;
+}
+
+namespace detail {
+
+void recordAllocation(size_t bytes) {
+  if (suspended) {
+    return;
+  }
+  SiteCounter &site =
+      findSite(currentZone != nullptr ? currentZone : NO_ZONE);
+  site.count.fetch_add(1, std::memory_order_relaxed);
+  site.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void recordFree() {
+  if (!suspended) {
+    frees.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace detail
+
+}  // namespace engine::profiler
+
+// Replacements of every global allocation function. On glibc the C allocation
+// functions are replaced as well and forward to glibc's own entry points, so
+// memory the C libraries and the Vulkan driver take from malloc is counted.
+// Elsewhere only operator new and delete are, malloc goes uncounted.
+#ifdef ENGINE_ALLOCATION_TRACKER
+
+#if defined(__GLIBC__)
+#define TETCIPP_TRACK_MALLOC 1
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *pointer);
+}
+#else
+#define TETCIPP_TRACK_MALLOC 0
+#endif
+
+namespace {
+
+// Untracked allocations, operator new records its own so that it doesn't
+// count twice through the replaced malloc
+void *rawAllocate(size_t size) {
+#if TETCIPP_TRACK_MALLOC
+  return __libc_malloc(size);
+#else
+  return std::malloc(size);
+#endif
+}
+
+void *rawAllocate(size_t size, size_t alignment) {
+#if TETCIPP_TRACK_MALLOC
+  return __libc_memalign(alignment, size);
+#else
+  // aligned_alloc wants a multiple of the alignment
+  size_t rounded = (size + alignment - 1) / alignment * alignment;
+  return std::aligned_alloc(alignment, rounded);
+#endif
+}
+
+void rawFree(void *pointer) {
+#if TETCIPP_TRACK_MALLOC
+  __libc_free(pointer);
+#else
+  std::free(pointer);
+#endif
+}
+
+void *trackedAllocate(size_t size) {
+  void *pointer = rawAllocate(size == 0 ? 1 : size);
+  if (pointer != nullptr) {
+    engine::profiler::detail::recordAllocation(size);
+  }
+  return pointer;
+}
+
+void *trackedAllocate(size_t size, std::align_val_t alignment) {
+  void *pointer =
+      rawAllocate(std::max<size_t>(size, 1), static_cast<size_t>(alignment));
+  if (pointer != nullptr) {
+    engine::profiler::detail::recordAllocation(size);
+  }
+  return pointer;
+}
+
+void trackedFree(void *pointer) {
+  if (pointer != nullptr) {
+    engine::profiler::detail::recordFree();
+    rawFree(pointer);
+  }
+}
+
+// Calls the new handler until the allocation succeeds, like the operator new
+// of the standard library does
+// @return nullptr once no handler is installed
+template <typename... Alignment>
+void *allocateOrHandle(size_t size, Alignment... alignment) {
+  while (true) {
+    void *pointer = trackedAllocate(size, alignment...);
+    if (pointer != nullptr) {
+      return pointer;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      return nullptr;
+    }
+    handler();
+  }
+}
+
+// The nothrow forms behave as if they called the throwing ones, a handler
+// that throws bad_alloc ends them with nullptr
+template <typename... Alignment>
+void *allocateOrNull(size_t size, Alignment... alignment) noexcept {
+  try {
+    return allocateOrHandle(size, alignment...);
+  } catch (const std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+}  // namespace
+
+#if TETCIPP_TRACK_MALLOC
+
+extern "C" {
+
+void *malloc(size_t size) noexcept {
+  void *pointer = __libc_malloc(size);
+  if (pointer != nullptr) {
+    engine::profiler::detail::recordAllocation(size);
+  }
+  return pointer;
+}
+
+void *calloc(size_t count, size_t size) noexcept {
+  void *pointer = __libc_calloc(count, size);
+  if (pointer != nullptr) {
+    engine::profiler::detail::recordAllocation(count * size);
+  }
+  return pointer;
+}
+
+// Counts as freeing the old block and allocating the new one, even when the
+// block grows in place
+void *realloc(void *pointer, size_t size) noexcept {
+  void *resized = __libc_realloc(pointer, size);
+  if (pointer != nullptr && (resized != nullptr || size == 0)) {
+    engine::profiler::detail::recordFree();
+  }
+  if (resized != nullptr) {
+    engine::profiler::detail::recordAllocation(size);
+  }
+  return resized;
+}
+
+void *memalign(size_t alignment, size_t size) noexcept {
+  void *pointer = __libc_memalign(alignment, size);
+  if (pointer != nullptr) {
+    engine::profiler::detail::recordAllocation(size);
+  }
+  return pointer;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept {
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void **result, size_t alignment, size_t size) noexcept {
+  if (alignment % sizeof(void *) != 0 ||
+      (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+  void *pointer = memalign(alignment, size);
+  if (pointer == nullptr) {
+    return ENOMEM;
+  }
+  *result = pointer;
+  return 0;
+}
+
+void free(void *pointer) noexcept {
+  if (pointer != nullptr) {
+    engine::profiler::detail::recordFree();
+    __libc_free(pointer);
+  }
+}
+
+}  // extern "C"
+
+#endif
+
+void *operator new(size_t size) {
+  void *pointer = allocateOrHandle(size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return allocateOrNull(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return allocateOrNull(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+  void *pointer = allocateOrHandle(size, alignment);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void *operator new(
+    size_t size,
+    std::align_val_t alignment,
+    const std::nothrow_t &) noexcept {
+  return allocateOrNull(size, alignment);
+}
+
+void *operator new[](
+    size_t size,
+    std::align_val_t alignment,
+    const std::nothrow_t &) noexcept {
+  return allocateOrNull(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept { trackedFree(pointer); }
+
+void operator delete[](void *pointer) noexcept { trackedFree(pointer); }
+
+void operator delete(void *pointer, size_t) noexcept { trackedFree(pointer); }
+
+void operator delete[](void *pointer, size_t) noexcept {
+  trackedFree(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept {
+  trackedFree(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept {
+  trackedFree(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+  trackedFree(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+  trackedFree(pointer);
+}
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept {
+  trackedFree(pointer);
+}
+
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept {
+  trackedFree(pointer);
+}
+
+void operator delete(
+    void *pointer,
+    std::align_val_t,
+    const std::nothrow_t &) noexcept {
+  trackedFree(pointer);
+}
+
+void operator delete[](
+    void *pointer,
+    std::align_val_t,
+    const std::nothrow_t &) noexcept {
+  trackedFree(pointer);
+}
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine::profiler {
+
+/// Heap allocations made inside one profiler zone
+struct AllocationSite {
+  /// Innermost zone open when the allocations were made, NO_ZONE outside of
+  /// every zone
+  const char *zone;
+  uint64_t count;
+  uint64_t bytes;
+};
+
+struct AllocationCounts {
+  uint64_t count = 0;
+  uint64_t bytes = 0;
+  uint64_t frees = 0;
+};
+
+/// Zone of allocations made while no zone was open
+inline constexpr const char *NO_ZONE = "<no zone>";
+
+/// True if the build replaced the global operator new and delete, which it
+/// does with ENGINE_ALLOCATION_TRACKER. Everything else here reports nothing
+/// otherwise. On glibc malloc, calloc, realloc, free and the aligned
+/// variants are replaced too, on other C libraries memory taken from them
+/// directly isn't counted.
+bool isAllocationTrackerEnabled();
+
+/// Moves what every thread allocated since the last call into sites, one
+/// entry per zone, most allocations first. Memory the call needs for sites
+/// isn't counted.
+/// @return The totals over all zones
+AllocationCounts takeAllocations(std::vector<AllocationSite> &sites);
+
+namespace detail {
+/// Innermost open zone of the thread, maintained by Zone when the tracker is
+/// compiled in
+extern constinit thread_local const char *currentZone;
+
+void recordAllocation(size_t bytes);
+
+void recordFree();
+}  // namespace detail
+
+/// Attributes the allocations of the calling thread to a zone until it is
+/// destroyed. PROFILE_ZONE opens one whenever the build has the tracker, with
+/// or without ENGINE_PROFILER.
+/// @param name Has to outlive the tracker, usually a string literal
+class AllocationZone {
+ public:
+  explicit AllocationZone(const char *name)
+      : previousZone(detail::currentZone) {
+    detail::currentZone = name;
+  }
+
+  ~AllocationZone() { detail::currentZone = previousZone; }
+
+  AllocationZone(const AllocationZone &) = delete;
+  AllocationZone &operator=(const AllocationZone &) = delete;
+
+ private:
+  const char *previousZone;
+};
+
+}  // namespace engine::profiler
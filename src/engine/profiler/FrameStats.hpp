@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "engine/profiler/AllocationTracker.hpp"
+
+namespace engine::profiler {
+
+/// A named span of one frame in milliseconds
+struct ScopeTiming {
+  const char *name;
+  double milliseconds;
+};
+
+/// CPU and GPU timings of the last rendered frame
+struct FrameStats {
+  uint64_t frame = 0;
+  /// Wall time since the frame before
+  double frameMilliseconds = 0.0;
+  /// Fixed ticks, maintenance and interpolation of the simulation
+  double simulateMilliseconds = 0.0;
+  /// Recording, submitting and presenting on the CPU, the sum of the three
+  /// parts below
+  double renderMilliseconds = 0.0;
+  /// Waiting for the frame's fence and acquiring the image
+  double waitMilliseconds = 0.0;
+  /// Recording the command buffer
+  double recordMilliseconds = 0.0;
+  /// Submitting and presenting
+  double submitMilliseconds = 0.0;
+  /// GPU scopes of the newest frame whose fence signaled, which lags the CPU
+  /// timings by the frames in flight
+  std::vector<ScopeTiming> gpuScopes;
+  /// Frame the GPU scopes belong to, 0 while none were read back yet
+  uint64_t gpuFrame = 0;
+  /// Heap allocations of every thread since the frame before, only counted
+  /// in builds with ENGINE_ALLOCATION_TRACKER
+  AllocationCounts allocations;
+  /// The same allocations by profiler zone, most allocations first
+  std::vector<AllocationSite> allocationSites;
+};
+
+}  // namespace engine::profiler
@@ -0,0 +1,178 @@
+#include "engine/profiler/Profiler.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace engine::profiler {
+
+namespace detail {
+std::atomic<bool> enabled = true;
+
+constinit thread_local ThreadBuffer *threadBuffer = nullptr;
+}  // namespace detail
+
+namespace {
+
+using detail::ThreadBuffer;
+using detail::ZoneRecord;
+using detail::threadBuffer;
+
+// Buffers outlive their threads so zones of finished threads still export
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+// A pair of readings of both clocks to convert timestamps to nanoseconds
+struct ClockSample {
+  int64_t clock;
+  std::chrono::steady_clock::time_point steady;
+};
+
+ClockSample sampleClocks() {
+  return {readClock(), std::chrono::steady_clock::now()};
+}
+
+// Taken during static initialization, exports measure the clock rate against
+// it
+const ClockSample startSample = sampleClocks();
+
+Registry &getRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+ThreadBuffer &getThreadBuffer() {
+  if (threadBuffer == nullptr) [[unlikely]] {
+    return detail::createThreadBuffer();
+  }
+  return *threadBuffer;
+}
+
+void writeEscaped(std::ofstream &file, const char *text) {
+  for (; *text != '\0'; text++) {
+    if (*text == '"' || *text == '\\') {
+      file << '\\';
+    }
+    file << *text;
+  }
+}
+
+}  // namespace
+
+ThreadBuffer &detail::createThreadBuffer() {
+  Registry &registry = getRegistry();
+  std::lock_guard lock(registry.mutex);
+  auto &buffer =
+      registry.buffers.emplace_back(std::make_unique<ThreadBuffer>());
+  buffer->threadID = static_cast<uint32_t>(registry.buffers.size());
+  threadBuffer = buffer.get();
+  return *buffer;
+}
+
+void setEnabled(bool enabled) {
+  detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool isEnabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+void setThreadName(const char *name) {
+  getThreadBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+bool isProfilerEnabled() {
+#ifdef ENGINE_PROFILER
+  return true;
+#else
+  return false;
+#endif
+}
+
+void exportChromeTrace(const std::string &path) {
+  std::ofstream file(path);
+  if (!file) {
+    throw std::runtime_error("failed to open trace file " + path);
+  }
+
+  ClockSample endSample = sampleClocks();
+  double nanosecondsPerTick =
+      std::chrono::duration<double, std::nano>(
+          endSample.steady - startSample.steady)
+          .count() /
+      std::max<int64_t>(endSample.clock - startSample.clock, 1);
+
+  Registry &registry = getRegistry();
+  std::lock_guard lock(registry.mutex);
+  int64_t origin = INT64_MAX;
+  struct Copy {
+    const char *name;
+    int64_t start;
+    int64_t end;
+  };
+  std::vector<std::vector<Copy>> threadZones;
+  for (auto &buffer : registry.buffers) {
+    auto &zones = threadZones.emplace_back();
+    uint64_t written = buffer->written.load(std::memory_order_acquire);
+    uint64_t first =
+        written > ZONES_PER_THREAD ? written - ZONES_PER_THREAD : 0;
+    for (uint64_t i = first; i < written; i++) {
+      const ZoneRecord &zone = buffer->zones[i % ZONES_PER_THREAD];
+      zones.push_back(
+          {zone.name.load(std::memory_order_relaxed),
+           zone.start.load(std::memory_order_relaxed),
+           zone.end.load(std::memory_order_relaxed)});
+    }
+    // The thread kept going while we copied, whatever it wrapped over since
+    // may be a mix of two zones. The zone it is writing right now counts too.
+    uint64_t rewritten = buffer->written.load(std::memory_order_acquire) + 1;
+    uint64_t overwritten = rewritten > ZONES_PER_THREAD + first
+                               ? rewritten - ZONES_PER_THREAD - first
+                               : 0;
+    zones.erase(
+        zones.begin(),
+        zones.begin() + std::min<uint64_t>(overwritten, zones.size()));
+    for (const Copy &zone : zones) {
+      origin = std::min(origin, zone.start);
+    }
+  }
+
+  file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  for (size_t thread = 0; thread < threadZones.size(); thread++) {
+    uint32_t threadID = registry.buffers[thread]->threadID;
+    const char *name =
+        registry.buffers[thread]->name.load(std::memory_order_relaxed);
+    if (name != nullptr) {
+      file << (first ? "" : ",")
+           << std::format(
+                  "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                  "\"tid\":{},\"args\":{{\"name\":\"",
+                  threadID);
+      writeEscaped(file, name);
+      file << "\"}}";
+      first = false;
+    }
+    for (const Copy &zone : threadZones[thread]) {
+      file << (first ? "" : ",") << "{\"name\":\"";
+      writeEscaped(file, zone.name);
+      // Chrome traces count in microseconds
+      file << std::format(
+          "\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+          threadID,
+          (zone.start - origin) * nanosecondsPerTick / 1000.0,
+          (zone.end - zone.start) * nanosecondsPerTick / 1000.0);
+      first = false;
+    }
+  }
+  file << "]}\n";
+  if (!file) {
+    throw std::runtime_error("failed to write trace file " + path);
+  }
+}
+
+}  // namespace engine::profiler
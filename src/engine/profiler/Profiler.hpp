@@ -0,0 +1,153 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "engine/profiler/AllocationTracker.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TETCIPP_PROFILER_TSC 1
+#else
+#define TETCIPP_PROFILER_TSC 0
+#endif
+
+namespace engine::profiler {
+
+/// Zones a thread keeps before the oldest ones get overwritten
+inline constexpr size_t ZONES_PER_THREAD = 1 << 16;
+
+/// Timestamp of the profiler clock, the unit and zero point are arbitrary.
+/// The time stamp counter on x86 since reading the steady clock alone takes
+/// most of the per zone budget, the export converts both to nanoseconds.
+inline int64_t readClock() {
+#if TETCIPP_PROFILER_TSC
+  return static_cast<int64_t>(__rdtsc());
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+/// Turns recording on or off at runtime, zones cost a single load while off
+void setEnabled(bool enabled);
+
+bool isEnabled();
+
+/// Name of the calling thread in the exported trace, the pointer has to stay
+/// valid until the last export
+void setThreadName(const char *name);
+
+/// True if the build records zones, which it does with ENGINE_PROFILER
+bool isProfilerEnabled();
+
+/// Writes the zones every thread still has in its ring as Chrome trace event
+/// JSON, which chrome://tracing and Perfetto open. Safe to call while other
+/// threads keep recording, zones overwritten during the export are left out.
+/// @throws std::runtime_error if the file can't be written
+void exportChromeTrace(const std::string &path);
+
+namespace detail {
+extern std::atomic<bool> enabled;
+
+// Fields are relaxed atomics so the exporter can read a ring while its thread
+// writes it. On x86 and ARM they compile to plain loads and stores.
+struct ZoneRecord {
+  std::atomic<const char *> name;
+  std::atomic<int64_t> start;
+  std::atomic<int64_t> end;
+};
+
+struct ThreadBuffer {
+  std::array<ZoneRecord, ZONES_PER_THREAD> zones;
+  // Zones written so far, zone i lives at i % ZONES_PER_THREAD
+  std::atomic<uint64_t> written = 0;
+  std::atomic<const char *> name = nullptr;
+  uint32_t threadID;
+};
+
+// Ring of the calling thread, null until its first zone. Constant
+// initialized, so reading it skips the guard a dynamically initialized
+// thread_local would check on every zone.
+extern constinit thread_local ThreadBuffer *threadBuffer;
+
+// Registers a ring for the calling thread, the slow path of its first zone
+ThreadBuffer &createThreadBuffer();
+}  // namespace detail
+
+/// Appends a finished zone to the ring of the calling thread. Only the owning
+/// thread writes its ring, so this takes no lock. Inline since the two clock
+/// reads leave little of the per zone budget for a call.
+/// @param name Has to outlive the profiler, usually a string literal
+/// @param start Timestamp from readClock
+inline void recordZone(const char *name, int64_t start, int64_t end) {
+  detail::ThreadBuffer *buffer = detail::threadBuffer;
+  if (buffer == nullptr) [[unlikely]] {
+    buffer = &detail::createThreadBuffer();
+  }
+  uint64_t index = buffer->written.load(std::memory_order_relaxed);
+  detail::ZoneRecord &zone = buffer->zones[index % ZONES_PER_THREAD];
+  zone.name.store(name, std::memory_order_relaxed);
+  zone.start.store(start, std::memory_order_relaxed);
+  zone.end.store(end, std::memory_order_relaxed);
+  buffer->written.store(index + 1, std::memory_order_release);
+}
+
+/// Records the time between construction and destruction under the name
+class Zone {
+ public:
+  explicit Zone(const char *name)
+      :
+#ifdef ENGINE_ALLOCATION_TRACKER
+        allocationZone(name),
+#endif
+        name(name),
+        start(
+            detail::enabled.load(std::memory_order_relaxed) ? readClock()
+                                                             : -1) {
+  }
+
+  ~Zone() {
+    if (start >= 0) {
+      recordZone(name, start, readClock());
+    }
+  }
+
+  Zone(const Zone &) = delete;
+  Zone &operator=(const Zone &) = delete;
+
+ private:
+#ifdef ENGINE_ALLOCATION_TRACKER
+  // Allocations are attributed to the innermost zone
+  AllocationZone allocationZone;
+#endif
+  const char *name;
+  int64_t start;
+};
+
+}  // namespace engine::profiler
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+// Zones compile to nothing unless the build defines ENGINE_PROFILER. With
+// ENGINE_ALLOCATION_TRACKER alone they still name the allocations they make.
+#if defined(ENGINE_PROFILER)
+#define PROFILE_ZONE(name)                                                    \
+  ::engine::profiler::Zone PROFILER_CONCAT(profilerZone, __LINE__)(name)
+#elif defined(ENGINE_ALLOCATION_TRACKER)
+#define PROFILE_ZONE(name)                                                    \
+  ::engine::profiler::AllocationZone PROFILER_CONCAT(profilerZone, __LINE__)( \
+      name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
+#ifdef ENGINE_PROFILER
+#define PROFILE_THREAD(name) ::engine::profiler::setThreadName(name)
+#else
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,241 @@
+#include "engine/spatial/UniformGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace engine::spatial {
+
+UniformGrid::UniformGrid(
+    glm::vec2 origin, float cellSize, uint32_t width, uint32_t height)
+    : origin(origin), cellSize(cellSize), inverseCellSize(1.0f / cellSize),
+      width(width), height(height) {
+  if (width == 0 || height == 0 || !(cellSize > 0.0f)) {
+    throw std::runtime_error("uniform grid needs cells with a positive size");
+  }
+  size_t cellCount = static_cast<size_t>(width) * height;
+  cellStarts.assign(cellCount, 0);
+  cellCounts.assign(cellCount, 0);
+  sortedStarts.assign(cellCount, 0);
+}
+
+bool UniformGrid::update(ecs::EntityID entity, glm::vec2 position) {
+  uint32_t cell = cellIndex(cellCoordinates(position));
+  size_t id = ecs::Entity::getId(entity);
+  if (id >= slots.size()) {
+    slots.resize(id + 1);
+  }
+  Slot &slot = slots[id];
+
+  if (slot.entity != entity) {
+    // The id was reused, only one generation of it can be alive
+    if (slot.entity != NO_ENTITY) {
+      detach(slot);
+      liveCount--;
+    }
+    slot.entity = entity;
+    slot.cell = cell;
+    addPending(slot, entity, position);
+    liveCount++;
+    return true;
+  }
+
+  if (slot.pending) {
+    pending[slot.index].position = position;
+    bool moved = slot.cell != cell;
+    slot.cell = cell;
+    return moved;
+  }
+  if (slot.cell == cell) {
+    items[slot.index].position = position;
+    return false;
+  }
+  detach(slot);
+  slot.cell = cell;
+  addPending(slot, entity, position);
+  return true;
+}
+
+void UniformGrid::remove(ecs::EntityID entity) {
+  size_t id = ecs::Entity::getId(entity);
+  if (id >= slots.size() || slots[id].entity != entity) {
+    return;
+  }
+  detach(slots[id]);
+  slots[id].entity = NO_ENTITY;
+  liveCount--;
+}
+
+bool UniformGrid::contains(ecs::EntityID entity) const {
+  return findSlot(entity) != nullptr;
+}
+
+void UniformGrid::flush() {
+  if (pending.empty()) {
+    return;
+  }
+
+  // Counting sort. sortedStarts first counts the pending items of every
+  // cell, then turns into where the cells start.
+  std::fill(sortedStarts.begin(), sortedStarts.end(), 0);
+  for (const Item &item : pending) {
+    sortedStarts[slots[ecs::Entity::getId(item.entity)].cell]++;
+  }
+  uint32_t total = 0;
+  for (size_t cell = 0; cell < cellCounts.size(); cell++) {
+    uint32_t itemCount = cellCounts[cell] + sortedStarts[cell];
+    sortedStarts[cell] = total;
+    total += itemCount;
+  }
+  sortedItems.resize(total);
+
+  // The items a cell kept come first, cellStarts becomes the cursor for the
+  // pending items that follow them
+  for (size_t cell = 0; cell < cellCounts.size(); cell++) {
+    uint32_t to = sortedStarts[cell];
+    uint32_t end = cellStarts[cell] + cellCounts[cell];
+    for (uint32_t from = cellStarts[cell]; from < end; from++, to++) {
+      sortedItems[to] = items[from];
+      slots[ecs::Entity::getId(items[from].entity)].index = to;
+    }
+    cellStarts[cell] = to;
+  }
+  for (const Item &item : pending) {
+    Slot &slot = slots[ecs::Entity::getId(item.entity)];
+    slot.index = cellStarts[slot.cell]++;
+    slot.pending = false;
+    sortedItems[slot.index] = item;
+    cellCounts[slot.cell]++;
+  }
+  pending.clear();
+
+  std::swap(items, sortedItems);
+  std::swap(cellStarts, sortedStarts);
+}
+
+void UniformGrid::queryRange(
+    glm::vec2 min, glm::vec2 max, std::vector<ecs::EntityID> &out) const {
+  glm::ivec2 minCell = cellCoordinates(min);
+  glm::ivec2 maxCell = cellCoordinates(max);
+  for (int y = minCell.y; y <= maxCell.y; y++) {
+    for (int x = minCell.x; x <= maxCell.x; x++) {
+      visitCell(x, y, [&](const Item &item) {
+        if (item.position.x >= min.x && item.position.y >= min.y &&
+            item.position.x <= max.x && item.position.y <= max.y) {
+          out.push_back(item.entity);
+        }
+      });
+    }
+  }
+}
+
+void UniformGrid::queryRadius(
+    glm::vec2 center, float radius, std::vector<ecs::EntityID> &out) const {
+  float radiusSquared = radius * radius;
+  glm::ivec2 minCell = cellCoordinates(center - radius);
+  glm::ivec2 maxCell = cellCoordinates(center + radius);
+  for (int y = minCell.y; y <= maxCell.y; y++) {
+    for (int x = minCell.x; x <= maxCell.x; x++) {
+      visitCell(x, y, [&](const Item &item) {
+        glm::vec2 offset = item.position - center;
+        if (glm::dot(offset, offset) <= radiusSquared) {
+          out.push_back(item.entity);
+        }
+      });
+    }
+  }
+}
+
+bool UniformGrid::findNearest(
+    glm::vec2 point, float maxDistance, ecs::EntityID &nearest) const {
+  glm::ivec2 center = cellCoordinates(point);
+  float bestSquared = maxDistance * maxDistance;
+  bool found = false;
+
+  auto visitItem = [&](const Item &item) {
+    glm::vec2 offset = item.position - point;
+    float distanceSquared = glm::dot(offset, offset);
+    if (distanceSquared <= bestSquared) {
+      bestSquared = distanceSquared;
+      nearest = item.entity;
+      found = true;
+    }
+  };
+
+  int maxRing = static_cast<int>(std::max(width, height));
+  for (int ring = 0; ring <= maxRing; ring++) {
+    // Cells of this ring and beyond are at least ring - 1 cells away, plus
+    // whatever part of the center cell the point doesn't cover
+    float ringDistance = static_cast<float>(std::max(ring - 1, 0)) * cellSize;
+    if (ringDistance * ringDistance > bestSquared) {
+      break;
+    }
+    glm::ivec2 min = center - ring;
+    glm::ivec2 max = center + ring;
+    for (int y = min.y; y <= max.y; y++) {
+      bool edgeRow = y == min.y || y == max.y;
+      for (int x = min.x; x <= max.x; x += edgeRow ? 1 : max.x - min.x) {
+        if (x >= 0 && y >= 0 && x < static_cast<int>(width) &&
+            y < static_cast<int>(height)) {
+          visitCell(x, y, visitItem);
+        }
+        if (min.x == max.x) {
+          break;
+        }
+      }
+    }
+  }
+  return found;
+}
+
+glm::ivec2 UniformGrid::cellCoordinates(glm::vec2 position) const {
+  glm::vec2 cell = glm::floor((position - origin) * inverseCellSize);
+  // Clamping in float first keeps far away positions from overflowing int
+  return glm::ivec2(
+      std::clamp(cell.x, 0.0f, static_cast<float>(width - 1)),
+      std::clamp(cell.y, 0.0f, static_cast<float>(height - 1)));
+}
+
+const UniformGrid::Slot *UniformGrid::findSlot(ecs::EntityID entity) const {
+  size_t id = ecs::Entity::getId(entity);
+  // The slot can belong to another generation of the id
+  if (id >= slots.size() || slots[id].entity != entity) {
+    return nullptr;
+  }
+  return &slots[id];
+}
+
+void UniformGrid::addPending(
+    Slot &slot, ecs::EntityID entity, glm::vec2 position) {
+  slot.pending = true;
+  slot.index = static_cast<uint32_t>(pending.size());
+  pending.push_back({entity, position});
+}
+
+void UniformGrid::detach(Slot &slot) {
+  // Fills the hole with the last item of the cell or the pending list
+  std::vector<Item> &list = slot.pending ? pending : items;
+  uint32_t last = slot.pending
+                      ? static_cast<uint32_t>(pending.size()) - 1
+                      : cellStarts[slot.cell] + cellCounts[slot.cell] - 1;
+  if (slot.index != last) {
+    list[slot.index] = list[last];
+    slots[ecs::Entity::getId(list[slot.index].entity)].index = slot.index;
+  }
+  if (slot.pending) {
+    pending.pop_back();
+  } else {
+    cellCounts[slot.cell]--;
+  }
+}
+
+template <typename Visitor>
+void UniformGrid::visitCell(int x, int y, Visitor &&visitor) const {
+  uint32_t cell = cellIndex({x, y});
+  const Item *begin = items.data() + cellStarts[cell];
+  for (const Item *item = begin; item != begin + cellCounts[cell]; item++) {
+    visitor(*item);
+  }
+}
+
+}  // namespace engine::spatial
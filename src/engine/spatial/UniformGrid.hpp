@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ecs/entity.hpp"
+
+namespace engine::spatial {
+
+/// Uniform grid over the xy plane that buckets entities by the cell their
+/// position falls in. The entities of a cell are one contiguous range of a
+/// single item array, sorted by cell with a counting sort, so a query reads
+/// its cells front to back. Positions outside the grid are clamped to the
+/// border cells.
+///
+/// Moves inside a cell and removals take effect right away. Entities that
+/// are new or changed cells wait until flush sorts them in, one pass over
+/// every entity that only runs when there is something to sort in.
+class UniformGrid {
+ public:
+  /// @param origin Corner of cell (0, 0)
+  /// @param cellSize Side length of a cell, pick it close to the usual query
+  /// radius
+  /// @throws std::runtime_error if the grid has no cells or cellSize <= 0
+  UniformGrid(
+      glm::vec2 origin, float cellSize, uint32_t width, uint32_t height);
+
+  /// Inserts the entity or moves it. Another generation of the id still in
+  /// the grid is dropped, only one of them can be alive.
+  /// @return true if the entity was inserted or changed cells, it is then
+  /// missing from queries until the next flush
+  bool update(ecs::EntityID entity, glm::vec2 position);
+
+  void remove(ecs::EntityID entity);
+
+  bool contains(ecs::EntityID entity) const;
+
+  size_t size() const { return liveCount; }
+
+  /// Sorts the entities update inserted or moved to another cell into their
+  /// cells. O(entities + cells), and nothing when no update is pending.
+  void flush();
+
+  /// Appends the entities inside the axis aligned box to out
+  void queryRange(
+      glm::vec2 min, glm::vec2 max, std::vector<ecs::EntityID> &out) const;
+
+  /// Appends the entities within radius of center to out
+  void queryRadius(
+      glm::vec2 center, float radius, std::vector<ecs::EntityID> &out) const;
+
+  /// Searches the cells in rings around the point until no closer entity can
+  /// exist
+  /// @return false if no entity is within maxDistance
+  bool findNearest(
+      glm::vec2 point, float maxDistance, ecs::EntityID &nearest) const;
+
+ private:
+  // Id 0 is never handed out, so it marks free slots
+  static constexpr ecs::EntityID NO_ENTITY = 0;
+
+  struct Item {
+    ecs::EntityID entity;
+    glm::vec2 position;
+  };
+
+  // Where the entity of an id lives, indexed by ecs::Entity::getId
+  struct Slot {
+    ecs::EntityID entity = NO_ENTITY;
+    uint32_t cell = 0;
+    // Index into items, or into pending until the next flush
+    uint32_t index = 0;
+    bool pending = false;
+  };
+
+  glm::ivec2 cellCoordinates(glm::vec2 position) const;
+
+  uint32_t cellIndex(glm::ivec2 coordinates) const {
+    return static_cast<uint32_t>(coordinates.y) * width + coordinates.x;
+  }
+
+  const Slot *findSlot(ecs::EntityID entity) const;
+
+  void addPending(Slot &slot, ecs::EntityID entity, glm::vec2 position);
+
+  // Takes the entity of the slot out of its cell or the pending list
+  void detach(Slot &slot);
+
+  template <typename Visitor>
+  void visitCell(int x, int y, Visitor &&visitor) const;
+
+  glm::vec2 origin;
+  float cellSize;
+  float inverseCellSize;
+  uint32_t width;
+  uint32_t height;
+
+  // Cell c holds items[cellStarts[c], cellStarts[c] + cellCounts[c]).
+  // Removals shrink the count, the range only moves on flush.
+  std::vector<uint32_t> cellStarts;
+  std::vector<uint32_t> cellCounts;
+  std::vector<Item> items;
+  // Inserted or moved to another cell since the last flush
+  std::vector<Item> pending;
+  std::vector<Slot> slots;
+  size_t liveCount = 0;
+
+  // Buffers flush sorts into, kept to reuse their memory
+  std::vector<uint32_t> sortedStarts;
+  std::vector<Item> sortedItems;
+};
+
+}  // namespace engine::spatial
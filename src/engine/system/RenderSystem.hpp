@@ -1,41 +1,92 @@
-
-
 #pragma once
 
 #include "ecs/register.hpp"
+#include "engine/FramePacket.hpp"
+#include "engine/TransformInterpolator.hpp"
 #include "engine/component/ModelComponent.hpp"
+#include "engine/profiler/Profiler.hpp"
 #include "engine/system/System.hpp"
 #include "rlm/renderer.hpp"
 #include "rlm/simple_renderer.hpp"
 #include <spdlog/spdlog.h>
 
 namespace engine::system {
+// Split in two so the engine can run the halves on different threads: collect
+// reads the register into a frame packet on the simulation side, draw records
+// the packet into the command buffer on the render side. Every draw is placed
+// by the interpolated matrix of its entity.
 class RenderSystem : public engine::system::System {
  public:
   RenderSystem(
       rlm::Renderer &rlmRenderer,
-      rlm::SimpleRenderSystem &simpleRenderSystem)
-      : rlmRenderer(rlmRenderer), simpleRenderSystem(simpleRenderSystem) {}
+      rlm::SimpleRenderSystem &simpleRenderSystem,
+      const TransformInterpolator &interpolator)
+      : rlmRenderer(rlmRenderer),
+        simpleRenderSystem(simpleRenderSystem),
+        interpolator(interpolator) {}
+
+  const char *getName() const override { return "RenderSystem::update"; }
 
   void update(ecs::Register &register_, float deltaTime) override {
-    // Iterate over entities with ModelComponent
-    auto components = register_.findArchetypes<component::ModelComponent>();
-    for (auto &compArch : components) {
-      for (auto &comp : compArch->findComponents<component::ModelComponent>()) {
-        // Render logic here
-
-        // spdlog::debug("RenderSystem: Rendering an object");
-        simpleRenderSystem.renderGameObjects(
-            rlmRenderer.getCommandBuffer(),
-            *comp.model,
-            rlmRenderer.getUboSet());
-      }
+    packet.clear();
+    collect(register_, packet);
+    draw(packet);
+  }
+
+  // Appends the model and model matrix of every enabled entity to the packet
+  void collect(ecs::Register &register_, FramePacket &framePacket) {
+    PROFILE_ZONE("RenderSystem::collect");
+    register_.each<const component::ModelComponent>(
+        [&](ecs::EntityID entity, const component::ModelComponent &comp) {
+          add(framePacket, entity, comp);
+        });
+
+    // Entities sharing a model are grouped in one archetype per model, so
+    // they only hold one reference per archetype
+    register_.each<ecs::Shared<component::ModelComponent>>(
+        [&](ecs::EntityID entity, const component::ModelComponent &comp) {
+          add(framePacket, entity, comp);
+        });
+  }
+
+  // Records the packet, has to run between beginning and ending the frame
+  void draw(const FramePacket &framePacket) {
+    PROFILE_ZONE("RenderSystem::draw");
+    rlm::GpuProfiler &gpuProfiler = rlmRenderer.getGpuProfiler();
+    bool drawScopes = gpuProfiler.hasDrawScopes();
+    VkCommandBuffer commandBuffer = rlmRenderer.getCommandBuffer();
+    for (size_t i = 0; i < framePacket.models.size(); i++) {
+      // spdlog::debug("RenderSystem: Rendering an object");
+      uint32_t scope = drawScopes
+                           ? gpuProfiler.beginScope(commandBuffer, "Draw")
+                           : rlm::GpuProfiler::NO_SCOPE;
+      simpleRenderSystem.renderGameObjects(
+          commandBuffer,
+          *framePacket.models[i],
+          rlmRenderer.getUboSet(),
+          framePacket.modelMatrices[i]);
+      gpuProfiler.endScope(commandBuffer, scope);
     }
   }
 
  private:
+  void add(
+      FramePacket &framePacket,
+      ecs::EntityID entity,
+      const component::ModelComponent &comp) {
+    framePacket.models.push_back(comp.model.get());
+    framePacket.modelMatrices.push_back(interpolator.getModelMatrix(entity));
+    if (framePacket.keepAlive.empty() ||
+        framePacket.keepAlive.back() != comp.model) {
+      framePacket.keepAlive.push_back(comp.model);
+    }
+  }
+
   rlm::Renderer &rlmRenderer;
   rlm::SimpleRenderSystem &simpleRenderSystem;
+  const TransformInterpolator &interpolator;
+  // Used by update when both halves run back to back
+  FramePacket packet;
 };
 
 }  // namespace engine::system
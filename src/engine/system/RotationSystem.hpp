@@ -1,24 +1,32 @@
 #pragma once
 
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
 #include "ecs/register.hpp"
-#include "engine/component/ModelComponent.hpp"
-#include "engine/component/UniformBufferObjectComponent.hpp"
+#include "engine/component/TransformComponent.hpp"
 #include "engine/system/System.hpp"
 
 namespace engine::system {
+// Spins every transform around the z axis at a fixed angular speed
 class RotationSystem : public engine::system::System {
  public:
-  RotationSystem() {}
+  explicit RotationSystem(float degreesPerSecond = 90.0f)
+      : radiansPerSecond(glm::radians(degreesPerSecond)) {}
+
+  const char *getName() const override { return "RotationSystem::update"; }
 
   void update(ecs::Register &register_, float deltaTime) override {
-    // Iterate over entities with ModelComponent
-    auto components = register_.findArchetypes<component::ModelComponent>();
-    for (auto &compArch : components) {
-      for (auto &comp :
-           compArch->findComponents<component::UniformBufferObject>()) {
-      }
-    }
+    glm::quat step = glm::angleAxis(
+        radiansPerSecond * deltaTime, glm::vec3(0.0f, 0.0f, 1.0f));
+    register_.each<component::TransformComponent>(
+        [&](component::TransformComponent &transform) {
+          transform.rotation = glm::normalize(step * transform.rotation);
+        });
   }
+
+ private:
+  float radiansPerSecond;
 };
 
 }  // namespace engine::system
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdexcept>
+
+#include <glm/glm.hpp>
+
+#include "ecs/register.hpp"
+#include "engine/component/TransformComponent.hpp"
+#include "engine/spatial/UniformGrid.hpp"
+#include "engine/system/System.hpp"
+
+namespace engine::system {
+// Keeps a uniform grid in sync with the xy position of every enabled entity
+// with a transform. An update only visits the transform chunks written since
+// the last one, so entities that didn't move cost nothing. Entities that lost
+// their transform or got deleted drop out when the register flushes its
+// observers. The system stays bound to the register of its first update.
+class SpatialGridSystem : public engine::system::System {
+ public:
+  SpatialGridSystem(
+      glm::vec2 origin, float cellSize, uint32_t width, uint32_t height)
+      : grid(origin, cellSize, width, height) {}
+
+  const char *getName() const override { return "SpatialGridSystem::update"; }
+
+  void update(ecs::Register &register_, float deltaTime) override {
+    if (observed == nullptr) {
+      observeRemovals(register_);
+    } else if (observed != &register_) {
+      throw std::runtime_error("spatial grid system used with two registers");
+    }
+    register_.eachChangedChunk<component::TransformComponent>(
+        sinceTick,
+        [&](ecs::Register::Archetype &archetype, size_t begin, size_t end) {
+          const auto *transforms =
+              archetype.getColumn<component::TransformComponent>()
+                  .componentData<component::TransformComponent>();
+          for (size_t row = begin; row < end; row++) {
+            if (archetype.isRowEnabled(row)) {
+              grid.update(
+                  archetype.entities[row],
+                  glm::vec2(transforms[row].position));
+            } else {
+              grid.remove(archetype.entities[row]);
+            }
+          }
+        });
+    grid.flush();
+  }
+
+  const spatial::UniformGrid &getGrid() const { return grid; }
+
+ private:
+  void observeRemovals(ecs::Register &register_) {
+    observed = &register_;
+    register_.observe<ecs::OnRemove<component::TransformComponent>>(
+        [this](
+            ecs::Register &register_,
+            const ecs::Register::ObserverBatch &batch) {
+          for (ecs::EntityID entity : batch.entities) {
+            // It may have gotten a transform again since
+            if (!register_.has<component::TransformComponent>(entity)) {
+              grid.remove(entity);
+            }
+          }
+        });
+  }
+
+  spatial::UniformGrid grid;
+  ecs::Register *observed = nullptr;
+  // Change tick of the register after the last update
+  uint32_t sinceTick = 0;
+};
+
+}  // namespace engine::system
@@ -9,5 +9,9 @@ class System {
 
   // Called every frame
   virtual void update(ecs::Register &register_, float deltaTime) = 0;
+
+  // Label of the update zone in profiler traces, has to stay valid for the
+  // whole run
+  virtual const char *getName() const { return "System::update"; }
 };
 }  // namespace engine::system
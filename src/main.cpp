@@ -1,10 +1,19 @@
 #include <spdlog/spdlog-inl.h>
 #include <vulkan/vulkan.h>
 
+#include <charconv>
+#include <cstdint>
 #include <cstdlib>
+#include <format>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
 
 #include "app/Game.hpp"
+#include "app/StressScene.hpp"
+#include "engine/EngineConfig.hpp"
 #include "spdlog/sinks/basic_file_sink.h"
 
 void init_logger() {
@@ -30,13 +39,97 @@ void init_logger() {
   }
 }
 
-int main() {
+namespace {
+
+struct Options {
+  engine::EngineConfig config;
+  // --stress swaps the game for the benchmark scene, the other stress options
+  // size it
+  bool stress = false;
+  app::StressSceneConfig stressConfig;
+};
+
+// Value after the option at argv[i], moves i onto it
+// @throws std::runtime_error naming the option if there is no value
+std::string_view takeValue(int argc, char **argv, int &i) {
+  if (i + 1 >= argc) {
+    throw std::runtime_error(std::format("{} needs a value", argv[i]));
+  }
+  return argv[++i];
+}
+
+// @throws std::runtime_error naming the option if the value isn't a whole
+// number that fits Number
+template <typename Number>
+Number takeNumber(int argc, char **argv, int &i) {
+  std::string_view option = argv[i];
+  std::string_view value = takeValue(argc, argv, i);
+  Number number{};
+  auto [end, error] =
+      std::from_chars(value.data(), value.data() + value.size(), number);
+  if (error != std::errc() || end != value.data() + value.size()) {
+    throw std::runtime_error(
+        std::format("{} expects a whole number, got \"{}\"", option, value));
+  }
+  return number;
+}
+
+// @throws std::runtime_error on unknown options and bad values
+Options parseOptions(int argc, char **argv) {
+  Options options;
+  engine::EngineConfig &config = options.config;
+  app::StressSceneConfig &stressConfig = options.stressConfig;
+  for (int i = 1; i < argc; i++) {
+    std::string_view argument = argv[i];
+    if (argument == "--stress") {
+      options.stress = true;
+    } else if (argument == "--entities") {
+      stressConfig.entityCount = takeNumber<uint32_t>(argc, argv, i);
+    } else if (argument == "--meshes") {
+      stressConfig.meshCount = takeNumber<uint32_t>(argc, argv, i);
+    } else if (argument == "--archetypes") {
+      stressConfig.archetypeCount = takeNumber<uint32_t>(argc, argv, i);
+    } else if (argument == "--churn") {
+      stressConfig.churnPerTick = takeNumber<uint32_t>(argc, argv, i);
+    } else if (argument == "--warmup") {
+      stressConfig.warmupFrames = takeNumber<uint32_t>(argc, argv, i);
+    } else if (argument == "--resize-every") {
+      stressConfig.resizeEvery = takeNumber<uint32_t>(argc, argv, i);
+    } else if (argument == "--report") {
+      stressConfig.reportOutput = takeValue(argc, argv, i);
+    } else if (argument == "--pipelined") {
+      config.pipelined = true;
+    } else if (argument == "--headless") {
+      config.headless = true;
+    } else if (argument == "--frames") {
+      config.frameLimit = takeNumber<uint64_t>(argc, argv, i);
+    } else if (argument == "--trace") {
+      config.traceOutput = takeValue(argc, argv, i);
+    } else if (argument == "--capture") {
+      config.captureOutput = takeValue(argc, argv, i);
+    } else if (argument == "--assert-no-allocations") {
+      config.assertNoAllocationsAfter = takeNumber<uint64_t>(argc, argv, i);
+    } else {
+      throw std::runtime_error(std::format("unknown option {}", argument));
+    }
+  }
+  return options;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
   // Initialize logger
   init_logger();
 
-  app::Game app;
-
   try {
+    Options options = parseOptions(argc, argv);
+    if (options.stress) {
+      app::StressScene scene(options.config, options.stressConfig);
+      scene.run();
+      return EXIT_SUCCESS;
+    }
+    app::Game app(options.config);
     app.run();
   } catch (const std::exception &e) {
     std::cerr << e.what() << std::endl;
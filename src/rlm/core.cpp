@@ -17,18 +17,25 @@
 #include "simple_renderer.hpp"
 
 namespace rlm {
-Core::Core() { init(); }
+Core::Core(const CoreConfig &config) : config(config) { init(); }
 
 Core::~Core() {}
 
 void Core::init() {
-  // initialize window
-  rlmWindow = std::make_unique<Window>(HEIGHT, WIDTH, "Window");
-  if (rlmWindow == nullptr) {
-    throw std::runtime_error("Window creation was unsuccessful");
-  }
+  if (config.headless) {
+    rlmDevice = std::make_unique<Device>();
+  } else {
+    // initialize window
+    rlmWindow = std::make_unique<Window>(
+        static_cast<int>(config.height),
+        static_cast<int>(config.width),
+        "Window");
+    if (rlmWindow == nullptr) {
+      throw std::runtime_error("Window creation was unsuccessful");
+    }
 
-  rlmDevice = std::make_unique<Device>(*rlmWindow);
+    rlmDevice = std::make_unique<Device>(*rlmWindow);
+  }
   if (rlmDevice == nullptr) {
     throw std::runtime_error("Device creation was unsuccessful");
   }
@@ -63,7 +70,13 @@ void Core::init() {
 
   bool result = DescriptorSetWriter(*uboSet).writeBuffer(0).build();
 
-  rlmRenderer = std::make_unique<Renderer>(*rlmWindow, *rlmDevice, *uboSet);
+  if (config.headless) {
+    rlmRenderer = std::make_unique<Renderer>(
+        *rlmDevice, *uboSet, VkExtent2D{config.width, config.height});
+  } else {
+    rlmRenderer =
+        std::make_unique<Renderer>(*rlmWindow, *rlmDevice, *uboSet);
+  }
   if (rlmDevice == nullptr) {
     throw std::runtime_error("Renderer creation was unsuccessful");
   }
@@ -84,7 +97,9 @@ void Core::beginFrameOperations() {
 void Core::endFrameOperations() {
   rlmRenderer->endRenderPass();
   rlmRenderer->endFrame();
-  glfwPollEvents();
+  if (!config.headless) {
+    glfwPollEvents();
+  }
 }
 
 void Core::cleanup() {}
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <stdexcept>
 
 #include "device.hpp"
 #include "engine/component/UniformBufferObjectComponent.hpp"
@@ -16,12 +17,33 @@ namespace rlm {
 const uint32_t WIDTH = 1200;
 const uint32_t HEIGHT = 900;
 
+struct CoreConfig {
+  // Renders into offscreen images without a window, surface or swap chain
+  bool headless = false;
+  uint32_t width = WIDTH;
+  uint32_t height = HEIGHT;
+};
+
 class Core {
  public:
-  Core();
+  explicit Core(const CoreConfig &config = {});
   ~Core();
 
-  bool shouldClose() { return rlmWindow->shouldClose(); }
+  // Headless cores have nothing to close, whoever drives them decides when to
+  // stop
+  bool shouldClose() {
+    return rlmWindow != nullptr && rlmWindow->shouldClose();
+  }
+
+  bool isHeadless() const { return config.headless; }
+
+  // The swap chain is recreated at the next frame that sees the new size
+  void resizeWindow(uint32_t width, uint32_t height) {
+    if (rlmWindow == nullptr) {
+      throw std::runtime_error("headless cores have no window to resize");
+    }
+    rlmWindow->setSize(static_cast<int>(width), static_cast<int>(height));
+  }
 
   void beginFrameOperations();
   void endFrameOperations();
@@ -41,6 +63,8 @@ class Core {
   }
 
  private:
+  CoreConfig config;
+  // nullptr when headless
   std::unique_ptr<Window> rlmWindow;
   std::unique_ptr<Device> rlmDevice;
   std::unique_ptr<Renderer> rlmRenderer;
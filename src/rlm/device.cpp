@@ -65,7 +65,14 @@ void DestroyDebugUtilsMessengerEXT(
   }
 }
 
-Device::Device(Window &window) : rlmWindow{window} {
+Device::Device(Window &window) : rlmWindow{&window} {
+  deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  init();
+}
+
+Device::Device() { init(); }
+
+void Device::init() {
   createInstance();
   spdlog::debug("RLMDevice: Instance created\n");
   setupDebugMessenger();
@@ -89,7 +96,9 @@ Device::~Device() {
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface, nullptr);
+  if (surface != VK_NULL_HANDLE) {
+    vkDestroySurfaceKHR(instance, surface, nullptr);
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -157,7 +166,9 @@ void Device::createInstance() {
     throw std::runtime_error("Failed to create instance!");
   }
 
-  checkGLFWHasRequiredExtensions(glfwExtensions);
+  if (!isHeadless()) {
+    checkGLFWHasRequiredExtensions(glfwExtensions);
+  }
 }
 
 void Device::setupDebugMessenger() {
@@ -175,8 +186,11 @@ void Device::setupDebugMessenger() {
 }
 
 void Device::createSurface() {
+  if (isHeadless()) {
+    return;
+  }
   auto result = glfwCreateWindowSurface(
-      instance, rlmWindow.getGLFWWindow(), nullptr, &surface);
+      instance, rlmWindow->getGLFWWindow(), nullptr, &surface);
   if (result != VK_SUCCESS) {
     throw std::runtime_error("failed to create window surface!");
   }
@@ -283,10 +297,17 @@ Device::findQueueFamilies(VkPhysicalDevice myPhysicalDevice) {
   for (auto queueFamily : queueFamilies) {
     if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
       indices.graphicsFamily = i;
+      // Nothing is presented without a surface, the present queue is just
+      // the graphics one
+      if (isHeadless()) {
+        indices.presentFamily = i;
+      }
     }
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(
-        myPhysicalDevice, i, surface, &presentSupport);
+    if (!isHeadless()) {
+      vkGetPhysicalDeviceSurfaceSupportKHR(
+          myPhysicalDevice, i, surface, &presentSupport);
+    }
     if (presentSupport) {
       indices.presentFamily = i;
     }
@@ -314,8 +335,9 @@ int Device::rateDeviceSuitability(VkPhysicalDevice myPhysicalDevice) {
   // Maximum possible size of textures affects graphics quality
   score += deviceProperties.limits.maxImageDimension2D;
 
-  // Application can't function without geometry shaders
-  if (!(deviceFeatures.geometryShader && isDeviceSuitable(myPhysicalDevice))) {
+  // No shader of the application uses geometry shaders, so they aren't
+  // required. CPU implementations like lavapipe still score above 0.
+  if (!isDeviceSuitable(myPhysicalDevice)) {
     return 0;
   }
 
@@ -333,6 +355,9 @@ bool Device::isDeviceSuitable(VkPhysicalDevice myPhysicalDevice) {
     return false;
 
   spdlog::debug("RLMDevice::isDeviceSuitable: step 3");
+  if (isHeadless()) {
+    return true;
+  }
   SwapChainSupportDetails swapChainSupport =
       querySwapChainSupport(myPhysicalDevice);
   if (swapChainSupport.formats.empty() || swapChainSupport.presentModes.empty())
@@ -447,12 +472,13 @@ void Device::checkGLFWHasRequiredExtensions(
 }
 
 std::vector<const char *> Device::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(
-      glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions;
+  if (!isHeadless()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions =
+        glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -46,6 +46,8 @@ class Device {
 
   VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
 
+  const VkPhysicalDeviceProperties &getProperties() const { return properties; }
+
   VkCommandPool getCommandPool() { return commandPool; }
 
   VkQueue getGraphicsQueue() { return graphicsQueue; }
@@ -67,8 +69,13 @@ class Device {
   void endSingleTimeCommand(VkCommandBuffer commandBuffer);
 
   explicit Device(Window &window);
+  /// Headless device without a surface, for rendering into offscreen images.
+  /// Any device with a graphics queue works, CPU implementations included.
+  Device();
   ~Device();
 
+  bool isHeadless() const { return rlmWindow == nullptr; }
+
  private:
   /// Creates the Vulkan instance used by this device.
   /// Must be called before creating any Vulkan resources.
@@ -131,11 +138,14 @@ class Device {
   SwapChainSupportDetails
   querySwapChainSupport(VkPhysicalDevice myPhysicalDevice);
 
-  Window &rlmWindow;
+  void init();
+
+  // nullptr for headless devices
+  Window *rlmWindow = nullptr;
 
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
-  VkSurfaceKHR surface;
+  VkSurfaceKHR surface = VK_NULL_HANDLE;
   VkDevice device;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
   VkPhysicalDeviceProperties properties;
@@ -146,7 +156,7 @@ class Device {
 
   const std::vector<const char *> validationLayers = {
       "VK_LAYER_KHRONOS_validation"};
-  const std::vector<const char *> deviceExtensions = {
-      VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  // Headless devices don't need the swap chain
+  std::vector<const char *> deviceExtensions;
 };
 }  // namespace rlm
@@ -0,0 +1,133 @@
+#include <vulkan/vulkan_core.h>
+
+#include <stdexcept>
+
+#include "gpu_profiler.hpp"
+
+namespace rlm {
+
+GpuProfiler::GpuProfiler(
+    Device &rlmDevice,
+    uint32_t framesInFlight,
+    uint32_t maxScopes)
+    : rlmDevice(rlmDevice), maxScopes(maxScopes), frames(framesInFlight) {
+  // Software implementations like lavapipe report timestamps the same way,
+  // only queues with no valid bits can't write them
+  const VkPhysicalDeviceProperties &properties = rlmDevice.getProperties();
+  uint32_t graphicsFamily =
+      rlmDevice.findPhysicalQueueFamilies().graphicsFamily.value();
+  uint32_t familyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(
+      rlmDevice.getPhysicalDevice(), &familyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> families(familyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(
+      rlmDevice.getPhysicalDevice(), &familyCount, families.data());
+  uint32_t validBits = families[graphicsFamily].timestampValidBits;
+  supported = validBits != 0 && properties.limits.timestampPeriod > 0.0f;
+  if (!supported) {
+    return;
+  }
+  timestampPeriod = properties.limits.timestampPeriod;
+  if (validBits < 64) {
+    timestampMask = (uint64_t{1} << validBits) - 1;
+  }
+
+  VkQueryPoolCreateInfo poolInfo{};
+  poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  poolInfo.queryCount = maxScopes * 2;
+  for (FrameQueries &frame : frames) {
+    auto result = vkCreateQueryPool(
+        rlmDevice.getDevice(), &poolInfo, nullptr, &frame.pool);
+    if (result != VK_SUCCESS) {
+      throw std::runtime_error("failed to create timestamp query pool!");
+    }
+    frame.names.reserve(maxScopes);
+  }
+  timestamps.resize(maxScopes * 2);
+  results.reserve(maxScopes);
+}
+
+GpuProfiler::~GpuProfiler() {
+  for (FrameQueries &frame : frames) {
+    if (frame.pool != VK_NULL_HANDLE) {
+      vkDestroyQueryPool(rlmDevice.getDevice(), frame.pool, nullptr);
+    }
+  }
+}
+
+void GpuProfiler::beginFrame(
+    VkCommandBuffer commandBuffer,
+    uint32_t frameIndex,
+    uint64_t frameNumber) {
+  if (!supported) {
+    return;
+  }
+  currentFrame = frameIndex;
+  FrameQueries &frame = frames[frameIndex];
+  if (!frame.names.empty()) {
+    readResults(frame);
+  }
+  frame.names.clear();
+  frame.frameNumber = frameNumber;
+  vkCmdResetQueryPool(commandBuffer, frame.pool, 0, maxScopes * 2);
+}
+
+uint32_t
+GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char *name) {
+  if (!supported) {
+    return NO_SCOPE;
+  }
+  FrameQueries &frame = frames[currentFrame];
+  if (frame.names.size() >= maxScopes) {
+    return NO_SCOPE;
+  }
+  uint32_t scope = static_cast<uint32_t>(frame.names.size());
+  frame.names.push_back(name);
+  vkCmdWriteTimestamp(
+      commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.pool, scope * 2);
+  return scope;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+  if (scope == NO_SCOPE) {
+    return;
+  }
+  vkCmdWriteTimestamp(
+      commandBuffer,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      frames[currentFrame].pool,
+      scope * 2 + 1);
+}
+
+void GpuProfiler::readResults(FrameQueries &frame) {
+  uint32_t queryCount = static_cast<uint32_t>(frame.names.size()) * 2;
+  // No wait flag, the fence already signaled. A frame that was recorded but
+  // never submitted, like one dropped for swap chain recreation, reports
+  // not ready and is skipped.
+  auto result = vkGetQueryPoolResults(
+      rlmDevice.getDevice(),
+      frame.pool,
+      0,
+      queryCount,
+      queryCount * sizeof(uint64_t),
+      timestamps.data(),
+      sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT);
+  if (result != VK_SUCCESS) {
+    return;
+  }
+
+  results.clear();
+  for (size_t scope = 0; scope < frame.names.size(); scope++) {
+    uint64_t begin = timestamps[scope * 2] & timestampMask;
+    uint64_t end = timestamps[scope * 2 + 1] & timestampMask;
+    // Counters narrower than 64 bits can wrap inside a frame
+    uint64_t ticks = (end - begin) & timestampMask;
+    results.push_back(
+        {frame.names[scope], ticks * timestampPeriod / 1'000'000.0});
+  }
+  resultFrame = frame.frameNumber;
+}
+
+}  // namespace rlm
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "device.hpp"
+#include "engine/profiler/FrameStats.hpp"
+
+namespace rlm {
+
+/// Timestamp queries around parts of a frame's command buffer. Every frame in
+/// flight has its own query pool, so a pool is only read after the fence of
+/// its frame signaled and reading never stalls. Does nothing on queues
+/// without timestamp support.
+class GpuProfiler {
+ public:
+  static constexpr uint32_t NO_SCOPE = UINT32_MAX;
+
+  /// @param maxScopes Scopes one frame can record, the rest are ignored
+  /// @throws std::runtime_error if a query pool can't be created
+  GpuProfiler(Device &rlmDevice, uint32_t framesInFlight, uint32_t maxScopes);
+  ~GpuProfiler();
+
+  GpuProfiler(const GpuProfiler &) = delete;
+  GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+  bool isSupported() const { return supported; }
+
+  /// Reads the scopes the frame recorded last time around and resets its
+  /// pool. Call after waiting on the frame's fence, with the command buffer
+  /// just begun and outside a render pass.
+  /// @param frameNumber Counts every frame, tags the scopes recorded next
+  void beginFrame(
+      VkCommandBuffer commandBuffer,
+      uint32_t frameIndex,
+      uint64_t frameNumber);
+
+  /// @param name Has to outlive the profiler, usually a string literal
+  /// @return The scope to end, NO_SCOPE if the frame is out of scopes
+  uint32_t beginScope(VkCommandBuffer commandBuffer, const char *name);
+
+  void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+  /// Also time every draw batch, not only the render pass
+  void setDrawScopes(bool enabled) { drawScopes = enabled; }
+
+  bool hasDrawScopes() const { return supported && drawScopes; }
+
+  /// Scopes of the newest frame that finished on the GPU
+  const std::vector<engine::profiler::ScopeTiming> &getResults() const {
+    return results;
+  }
+
+  /// Frame number the results belong to, 0 before the first read back
+  uint64_t getResultFrame() const { return resultFrame; }
+
+ private:
+  struct FrameQueries {
+    VkQueryPool pool = VK_NULL_HANDLE;
+    std::vector<const char *> names;
+    uint64_t frameNumber = 0;
+  };
+
+  void readResults(FrameQueries &frame);
+
+  Device &rlmDevice;
+  bool supported = false;
+  bool drawScopes = false;
+  uint32_t maxScopes;
+  // Nanoseconds per timestamp tick
+  double timestampPeriod = 1.0;
+  uint64_t timestampMask = ~uint64_t{0};
+
+  std::vector<FrameQueries> frames;
+  uint32_t currentFrame = 0;
+  std::vector<uint64_t> timestamps;
+  std::vector<engine::profiler::ScopeTiming> results;
+  uint64_t resultFrame = 0;
+};
+
+}  // namespace rlm
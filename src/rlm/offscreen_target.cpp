@@ -0,0 +1,205 @@
+#include <spdlog/spdlog.h>
+#include <vulkan/vulkan_core.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "offscreen_target.hpp"
+
+namespace rlm {
+
+OffscreenTarget::OffscreenTarget(
+    Device &rlmDevice,
+    VkExtent2D extent,
+    uint32_t imageCount)
+    : rlmDevice{rlmDevice}, extent{extent}, images(imageCount),
+      imageMemories(imageCount), imageViews(imageCount) {
+  createImages();
+  spdlog::debug("OffscreenTarget: Created {} images", imageCount);
+  createRenderPass();
+  createFramebuffers();
+  createReadbackBuffer();
+}
+
+OffscreenTarget::~OffscreenTarget() {
+  VkDevice device = rlmDevice.getDevice();
+  vkDestroyBuffer(device, readbackBuffer, nullptr);
+  vkFreeMemory(device, readbackMemory, nullptr);
+  for (auto framebuffer : framebuffers) {
+    vkDestroyFramebuffer(device, framebuffer, nullptr);
+  }
+  vkDestroyRenderPass(device, renderPass, nullptr);
+  for (size_t i = 0; i < images.size(); i++) {
+    vkDestroyImageView(device, imageViews[i], nullptr);
+    vkDestroyImage(device, images[i], nullptr);
+    vkFreeMemory(device, imageMemories[i], nullptr);
+  }
+}
+
+void OffscreenTarget::createImages() {
+  VkDevice device = rlmDevice.getDevice();
+  for (size_t i = 0; i < images.size(); i++) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = FORMAT;
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    // Rendered to, then copied out by readPixels
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                      VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &images[i]) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create offscreen image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, images[i], &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = rlmDevice.findMemoryType(
+        memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    auto result =
+        vkAllocateMemory(device, &allocInfo, nullptr, &imageMemories[i]);
+    if (result != VK_SUCCESS) {
+      throw std::runtime_error("failed to allocate offscreen image memory!");
+    }
+    vkBindImageMemory(device, images[i], imageMemories[i], 0);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = images[i];
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = FORMAT;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+    result = vkCreateImageView(device, &viewInfo, nullptr, &imageViews[i]);
+    if (result != VK_SUCCESS) {
+      throw std::runtime_error("failed to create offscreen image view!");
+    }
+  }
+}
+
+void OffscreenTarget::createRenderPass() {
+  // Same as the swap chain render pass so pipelines work with either, except
+  // that the image ends up ready to be copied instead of presented
+  VkSubpassDependency dependency{};
+  dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependency.dstSubpass = 0;
+  dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependency.srcAccessMask = 0;
+  dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+  VkAttachmentDescription colorAttachment{};
+  colorAttachment.format = FORMAT;
+  colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+  colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+  VkAttachmentReference colorAttachmentRef{};
+  colorAttachmentRef.attachment = 0;
+  colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+  VkSubpassDescription subpass{};
+  subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass.colorAttachmentCount = 1;
+  subpass.pColorAttachments = &colorAttachmentRef;
+
+  VkRenderPassCreateInfo renderPassInfo{};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  renderPassInfo.attachmentCount = 1;
+  renderPassInfo.pAttachments = &colorAttachment;
+  renderPassInfo.subpassCount = 1;
+  renderPassInfo.pSubpasses = &subpass;
+  renderPassInfo.dependencyCount = 1;
+  renderPassInfo.pDependencies = &dependency;
+
+  auto result = vkCreateRenderPass(
+      rlmDevice.getDevice(), &renderPassInfo, nullptr, &renderPass);
+  if (result != VK_SUCCESS) {
+    throw std::runtime_error("failed to create offscreen render pass!");
+  }
+}
+
+void OffscreenTarget::createFramebuffers() {
+  framebuffers.resize(imageViews.size());
+  for (size_t i = 0; i < imageViews.size(); i++) {
+    VkImageView attachments[] = {imageViews[i]};
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = renderPass;
+    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.pAttachments = attachments;
+    framebufferInfo.width = extent.width;
+    framebufferInfo.height = extent.height;
+    framebufferInfo.layers = 1;
+
+    auto result = vkCreateFramebuffer(
+        rlmDevice.getDevice(), &framebufferInfo, nullptr, &framebuffers[i]);
+    if (result != VK_SUCCESS) {
+      throw std::runtime_error("failed to create offscreen framebuffer!");
+    }
+  }
+}
+
+void OffscreenTarget::createReadbackBuffer() {
+  rlmDevice.createBuffer(
+      VkDeviceSize{extent.width} * extent.height * 4,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      readbackBuffer,
+      readbackMemory);
+}
+
+void OffscreenTarget::readPixels(
+    uint32_t imageIndex,
+    std::vector<uint8_t> &pixels) {
+  // The render pass left the image in TRANSFER_SRC_OPTIMAL
+  VkCommandBuffer commandBuffer = rlmDevice.beginSingleTimeCommand();
+  VkBufferImageCopy region{};
+  region.bufferOffset = 0;
+  // 0 means tightly packed
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageOffset = {0, 0, 0};
+  region.imageExtent = {extent.width, extent.height, 1};
+  vkCmdCopyImageToBuffer(
+      commandBuffer,
+      images[imageIndex],
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      readbackBuffer,
+      1,
+      &region);
+  rlmDevice.endSingleTimeCommand(commandBuffer);
+
+  size_t size = size_t{extent.width} * extent.height * 4;
+  pixels.resize(size);
+  void *data;
+  vkMapMemory(rlmDevice.getDevice(), readbackMemory, 0, size, 0, &data);
+  std::memcpy(pixels.data(), data, size);
+  vkUnmapMemory(rlmDevice.getDevice(), readbackMemory);
+}
+
+}  // namespace rlm
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "device.hpp"
+
+namespace rlm {
+
+/// Color images the renderer draws into instead of a swap chain. Each frame in
+/// flight gets its own image, so reading one back never races the frame the
+/// GPU is working on.
+class OffscreenTarget {
+ public:
+  // Plain RGBA that every implementation supports as a color attachment and
+  // that reads back without swizzling
+  static constexpr VkFormat FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+  OffscreenTarget(Device &rlmDevice, VkExtent2D extent, uint32_t imageCount);
+  ~OffscreenTarget();
+
+  OffscreenTarget(const OffscreenTarget &) = delete;
+  OffscreenTarget &operator=(const OffscreenTarget &) = delete;
+
+  VkRenderPass getRenderPass() { return renderPass; }
+
+  VkFramebuffer getFrameBuffer(int imageIndex) {
+    return framebuffers[imageIndex];
+  }
+
+  VkExtent2D getExtent() { return extent; }
+
+  uint32_t getImageCount() { return static_cast<uint32_t>(images.size()); }
+
+  /// Copies the image into pixels as tightly packed RGBA8 rows, top row
+  /// first. The frame that rendered it has to be finished.
+  void readPixels(uint32_t imageIndex, std::vector<uint8_t> &pixels);
+
+ private:
+  void createImages();
+  void createRenderPass();
+  void createFramebuffers();
+  void createReadbackBuffer();
+
+  Device &rlmDevice;
+  VkExtent2D extent;
+
+  std::vector<VkImage> images;
+  std::vector<VkDeviceMemory> imageMemories;
+  std::vector<VkImageView> imageViews;
+  std::vector<VkFramebuffer> framebuffers;
+  VkRenderPass renderPass;
+
+  // Host visible copy of one image for readPixels
+  VkBuffer readbackBuffer;
+  VkDeviceMemory readbackMemory;
+};
+
+}  // namespace rlm
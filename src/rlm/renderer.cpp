@@ -6,6 +6,7 @@
 #include <memory>
 
 #include "device.hpp"
+#include "engine/profiler/Profiler.hpp"
 #include "renderer.hpp"
 #include "swapchain.hpp"
 #include "window.hpp"
@@ -13,12 +14,35 @@
 namespace rlm {
 
 Renderer::Renderer(Window &rlmWindow, Device &rlmDevice, DescriptorSet &uboSet)
-    : rlmWindow(rlmWindow), rlmDevice(rlmDevice), uboSet(uboSet) {
+    : rlmDevice(rlmDevice), rlmWindow(&rlmWindow), uboSet(uboSet) {
   recreateSwapChain();
   createCommandBuffers();
   spdlog::debug("Renderer: Command buffer allocated\n");
   createSyncObjects();
   spdlog::debug("Renderer: Sync Objects created\n");
+  createGpuProfiler();
+}
+
+Renderer::Renderer(Device &rlmDevice, DescriptorSet &uboSet, VkExtent2D extent)
+    : rlmDevice(rlmDevice), uboSet(uboSet) {
+  // One image per frame in flight, a frame never draws into an image the GPU
+  // may still be working on
+  offscreenTarget = std::make_unique<OffscreenTarget>(
+      rlmDevice, extent, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT));
+  spdlog::debug("Renderer: Offscreen target created\n");
+  createCommandBuffers();
+  spdlog::debug("Renderer: Command buffer allocated\n");
+  createSyncObjects();
+  spdlog::debug("Renderer: Sync Objects created\n");
+  createGpuProfiler();
+}
+
+void Renderer::createGpuProfiler() {
+  gpuProfiler = std::make_unique<GpuProfiler>(
+      rlmDevice, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT), MAX_GPU_SCOPES);
+  if (!gpuProfiler->isSupported()) {
+    spdlog::info("Renderer: Queue has no timestamps, GPU timings are off");
+  }
 }
 
 Renderer::~Renderer() {
@@ -35,9 +59,9 @@ Renderer::~Renderer() {
 }
 
 void Renderer::recreateSwapChain() {
-  auto extent = rlmWindow.getExtent();
+  auto extent = rlmWindow->getExtent();
   while (extent.width == 0 || extent.height == 0) {
-    extent = rlmWindow.getExtent();
+    extent = rlmWindow->getExtent();
     glfwWaitEvents();
   }
   vkDeviceWaitIdle(rlmDevice.getDevice());
@@ -47,7 +71,9 @@ void Renderer::recreateSwapChain() {
 void Renderer::createSyncObjects() {
   imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
   renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-  submitSempahores.resize(rlmSwapChain->getSwapChainImageCount());
+  // Nothing waits on headless submits
+  submitSempahores.resize(
+      isHeadless() ? 0 : rlmSwapChain->getSwapChainImageCount());
   inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
 
   VkSemaphoreCreateInfo semaphoreInfo{};
@@ -89,31 +115,49 @@ void Renderer::createSyncObjects() {
 }
 
 void Renderer::beginFrame() {
+  PROFILE_ZONE("Renderer::beginFrame");
   // The vkWaitForFences function takes an array of fences and waits on the host
   // for either any or all of the fences to be signaled before returning. The
   // VK_TRUE we pass here indicates that we want to wait for all fences, but in
   // the case of a single one it doesn't matter. This function also has a
   // timeout parameter that we set to the maximum value of a 64 bit unsigned
   // integer, UINT64_MAX, which effectively disables the timeout.
-  vkWaitForFences(
-      rlmDevice.getDevice(),
-      1,
-      &inFlightFences[currentFrame],
-      VK_TRUE,
-      UINT64_MAX);
+  {
+    PROFILE_ZONE("vkWaitForFences");
+    vkWaitForFences(
+        rlmDevice.getDevice(),
+        1,
+        &inFlightFences[currentFrame],
+        VK_TRUE,
+        UINT64_MAX);
+  }
+
+  if (isHeadless()) {
+    // Images belong to frames in flight, the fence just waited on guarantees
+    // the GPU is done with this one
+    currentImageIndex = currentFrame;
+    vkResetFences(rlmDevice.getDevice(), 1, &inFlightFences[currentFrame]);
+    vkResetCommandBuffer(commandBuffers[currentFrame], 0);
+    recordCommandBuffer(commandBuffers[currentFrame], currentImageIndex);
+    return;
+  }
 
   // The first two parameters of vkAcquireNextImageKHR are the logical device
   // and the swap chain from which we wish to acquire an image. The third
   // parameter specifies a timeout in nanoseconds for an image to become
   // available. Using the maximum value of a 64 bit unsigned integer means we
   // effectively disable the timeout.
-  auto result = vkAcquireNextImageKHR(
-      rlmDevice.getDevice(),
-      rlmSwapChain->getSwapChain(),
-      UINT64_MAX,
-      imageAvailableSemaphores[currentFrame],
-      VK_NULL_HANDLE,
-      &currentImageIndex);
+  VkResult result;
+  {
+    PROFILE_ZONE("vkAcquireNextImageKHR");
+    result = vkAcquireNextImageKHR(
+        rlmDevice.getDevice(),
+        rlmSwapChain->getSwapChain(),
+        UINT64_MAX,
+        imageAvailableSemaphores[currentFrame],
+        VK_NULL_HANDLE,
+        &currentImageIndex);
+  }
 
   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
     recreateSwapChain();
@@ -129,6 +173,7 @@ void Renderer::beginFrame() {
 }
 
 void Renderer::endFrame() {
+  PROFILE_ZONE("Renderer::endFrame");
   auto result = vkEndCommandBuffer(commandBuffers[currentFrame]);
   if (result != VK_SUCCESS) {
     throw std::runtime_error("failed to record command buffer!");
@@ -139,30 +184,44 @@ void Renderer::endFrame() {
   VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
   VkPipelineStageFlags waitStages[] = {
       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
-  submitInfo.pWaitSemaphores = waitSemaphores;
-  submitInfo.pWaitDstStageMask = waitStages;
-
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
 
-  VkSemaphore signalSemaphores[] = {submitSempahores[currentImageIndex]};
-  submitInfo.signalSemaphoreCount = 1;
-  submitInfo.pSignalSemaphores = signalSemaphores;
+  // Offscreen images are never acquired or presented, only the fence orders
+  // the frames
+  if (!isHeadless()) {
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &submitSempahores[currentImageIndex];
+  }
 
-  result = vkQueueSubmit(
-      rlmDevice.getGraphicsQueue(),
-      1,
-      &submitInfo,
-      inFlightFences[currentFrame]);
+  {
+    PROFILE_ZONE("vkQueueSubmit");
+    result = vkQueueSubmit(
+        rlmDevice.getGraphicsQueue(),
+        1,
+        &submitInfo,
+        inFlightFences[currentFrame]);
+  }
   if (result != VK_SUCCESS) {
     throw std::runtime_error("failed to submit draw command buffer!");
   }
+  lastImageIndex = currentImageIndex;
 
+  if (!isHeadless()) {
+    present();
+  }
+
+  currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
+void Renderer::present() {
   VkPresentInfoKHR presentInfo{};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
   presentInfo.waitSemaphoreCount = 1;
-  presentInfo.pWaitSemaphores = signalSemaphores;
+  presentInfo.pWaitSemaphores = &submitSempahores[currentImageIndex];
   // The first two parameters specify which semaphores to wait on before
   // presentation can happen, just like VkSubmitInfo. Since we want to wait on
   // the command buffer to finish execution,
@@ -178,22 +237,33 @@ void Renderer::endFrame() {
   // chain if presentation was successful. It's not necessary if you're only
   // using a single swap chain, because you can simply use the return value of
   // the present function.
-  result = vkQueuePresentKHR(rlmDevice.getPresentQueue(), &presentInfo);
+  VkResult result;
+  {
+    PROFILE_ZONE("vkQueuePresentKHR");
+    result = vkQueuePresentKHR(rlmDevice.getPresentQueue(), &presentInfo);
+  }
 
   if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
-      rlmWindow.wasWindowResized()) {
-    rlmWindow.resetWindowResizedFlag();
+      rlmWindow->wasWindowResized()) {
+    rlmWindow->resetWindowResizedFlag();
     recreateSwapChain();
   } else if (result != VK_SUCCESS) {
     throw std::runtime_error("failed to present swap chain image!");
   }
+}
 
-  currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+void Renderer::readFrame(std::vector<uint8_t> &pixels) {
+  if (!isHeadless()) {
+    throw std::runtime_error("only headless renderers can read frames back!");
+  }
+  vkDeviceWaitIdle(rlmDevice.getDevice());
+  offscreenTarget->readPixels(lastImageIndex, pixels);
 }
 
 void Renderer::recordCommandBuffer(
     VkCommandBuffer commandBuffer,
     uint32_t imageIndex) {
+  PROFILE_ZONE("Renderer::recordCommandBuffer");
   // The flags parameter specifies how we're going to use the command buffer.
   // The following values are available:
   //
@@ -215,16 +285,20 @@ void Renderer::recordCommandBuffer(
   if (result != VK_SUCCESS) {
     throw std::runtime_error("failed to begin recording command buffer!");
   }
+
+  // The fence of this frame was waited on, so its last timestamps are ready
+  frameNumber++;
+  gpuProfiler->beginFrame(commandBuffer, currentFrame, frameNumber);
 }
 
 void Renderer::beginRenderPass() {
   VkRenderPassBeginInfo renderPassInfo{};
   renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  renderPassInfo.renderPass = rlmSwapChain->getRenderPass();
+  renderPassInfo.renderPass = getRenderPass();
   // currentImageIndex is undefined for now
-  renderPassInfo.framebuffer = rlmSwapChain->getFrameBuffer(currentImageIndex);
+  renderPassInfo.framebuffer = getFrameBuffer(currentImageIndex);
 
-  auto swapChainExtent = rlmSwapChain->getExtent();
+  auto swapChainExtent = getExtent();
   renderPassInfo.renderArea.offset = {0, 0};
   renderPassInfo.renderArea.extent = swapChainExtent;
 
@@ -240,6 +314,8 @@ void Renderer::beginRenderPass() {
   // be embedded in the primary command buffer itself and no secondary command
   // buffers will be executed. -VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS:
   // The render pass commands will be executed from secondary command buffers.
+  renderPassScope =
+      gpuProfiler->beginScope(commandBuffers[currentFrame], "RenderPass");
   vkCmdBeginRenderPass(
       commandBuffers[currentFrame],
       &renderPassInfo,
@@ -261,6 +337,7 @@ void Renderer::beginRenderPass() {
 
 void Renderer::endRenderPass() {
   vkCmdEndRenderPass(commandBuffers[currentFrame]);
+  gpuProfiler->endScope(commandBuffers[currentFrame], renderPassScope);
 }
 
 void Renderer::createCommandBuffers() {
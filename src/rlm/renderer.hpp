@@ -2,9 +2,12 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
+#include "gpu_profiler.hpp"
+#include "offscreen_target.hpp"
 #include "rlm/descriptor_set/descriptor_set.hpp"
 #include "swapchain.hpp"
 #include "window.hpp"
@@ -13,8 +16,14 @@ namespace rlm {
 class Renderer {
  public:
   static const int MAX_FRAMES_IN_FLIGHT = 2;
+  // Timestamp scopes a frame can record, the render pass plus draw batches
+  static constexpr uint32_t MAX_GPU_SCOPES = 64;
 
   Renderer(Window &rlmWindow, Device &rlmDevice, DescriptorSet &uboSet);
+  /// Renders into offscreen images of the given size instead of a swap chain.
+  /// Frames are submitted without waiting on or signaling a presentation
+  /// engine, so they can be read back with readFrame.
+  Renderer(Device &rlmDevice, DescriptorSet &uboSet, VkExtent2D extent);
   ~Renderer();
 
   void beginFrame();
@@ -23,7 +32,22 @@ class Renderer {
   void beginRenderPass();
   void endRenderPass();
 
-  VkRenderPass getRenderPass() { return rlmSwapChain->getRenderPass(); }
+  VkRenderPass getRenderPass() {
+    return isHeadless() ? offscreenTarget->getRenderPass()
+                        : rlmSwapChain->getRenderPass();
+  }
+
+  VkExtent2D getExtent() {
+    return isHeadless() ? offscreenTarget->getExtent()
+                        : rlmSwapChain->getExtent();
+  }
+
+  bool isHeadless() const { return offscreenTarget != nullptr; }
+
+  /// Waits for the device and copies the last submitted frame as RGBA8 rows,
+  /// see OffscreenTarget::readPixels
+  /// @throws std::runtime_error if the renderer has a swap chain
+  void readFrame(std::vector<uint8_t> &pixels);
 
   DescriptorSet &getUboSet() { return uboSet; }
 
@@ -31,20 +55,40 @@ class Renderer {
 
   VkCommandBuffer getCommandBuffer() { return commandBuffers[currentFrame]; }
 
+  GpuProfiler &getGpuProfiler() { return *gpuProfiler; }
+
  private:
   Device &rlmDevice;
-  Window &rlmWindow;
+  // nullptr when headless
+  Window *rlmWindow = nullptr;
   DescriptorSet &uboSet;
   std::shared_ptr<SwapChain> rlmSwapChain;
+  // Replaces the swap chain when headless
+  std::unique_ptr<OffscreenTarget> offscreenTarget;
 
   std::vector<VkCommandBuffer> commandBuffers;
 
   uint32_t currentImageIndex = 0;
   uint32_t currentFrame = 0;
+  // Image of the last submitted frame, what readFrame copies
+  uint32_t lastImageIndex = 0;
+  // Frames begun since the start, tags the GPU timings
+  uint64_t frameNumber = 0;
+
+  std::unique_ptr<GpuProfiler> gpuProfiler;
+  uint32_t renderPassScope = GpuProfiler::NO_SCOPE;
 
   void recreateSwapChain();
   void createCommandBuffers();
   void createSyncObjects();
+  void createGpuProfiler();
+
+  VkFramebuffer getFrameBuffer(uint32_t imageIndex) {
+    return isHeadless() ? offscreenTarget->getFrameBuffer(imageIndex)
+                        : rlmSwapChain->getFrameBuffer(imageIndex);
+  }
+
+  void present();
 
   void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
 
@@ -58,12 +58,22 @@ void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
 void SimpleRenderSystem::renderGameObjects(
     VkCommandBuffer commandBuffer,
     Model &model,
-    DescriptorSet &descriptorSet) {
+    DescriptorSet &descriptorSet,
+    const glm::mat4 &modelMatrix) {
   rlmPipeline->bindCommandBuffer(commandBuffer);
 
   descriptorSet.bindDescriptorSets(
       commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, 0, pipelineLayout);
 
+  SimplePushConstantData push{.model = modelMatrix};
+  vkCmdPushConstants(
+      commandBuffer,
+      pipelineLayout,
+      VK_SHADER_STAGE_VERTEX_BIT,
+      0,
+      sizeof(SimplePushConstantData),
+      &push);
+
   model.bind(commandBuffer);
   model.draw(commandBuffer);
 }
@@ -72,13 +82,18 @@ void SimpleRenderSystem::createPipelineLayout(
     DescriptorSetLayout globalLayout) {
   std::vector<VkDescriptorSetLayout> layoutArray{
       globalLayout.getDescriptorSetLayout()};
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.size = sizeof(SimplePushConstantData);
+
   VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
   pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
   pipelineLayoutInfo.setLayoutCount =
       static_cast<uint32_t>(layoutArray.size());        // Optional
   pipelineLayoutInfo.pSetLayouts = layoutArray.data();  // Optional
-  pipelineLayoutInfo.pushConstantRangeCount = 0;        // Optional
-  pipelineLayoutInfo.pPushConstantRanges = nullptr;     // Optional
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
   auto result = vkCreatePipelineLayout(
       rlmDevice.getDevice(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
@@ -3,6 +3,8 @@
 #include <memory>
 #include <vulkan/vulkan_core.h>
 
+#include <glm/glm.hpp>
+
 #include "descriptor_set/descriptor_set_layout.hpp"
 #include "device.hpp"
 #include "model.hpp"
@@ -11,6 +13,11 @@
 
 namespace rlm {
 
+// Matches the push_constant block of shader.vert
+struct SimplePushConstantData {
+  glm::mat4 model{1.0f};
+};
+
 class SimpleRenderSystem {
  public:
   SimpleRenderSystem(
@@ -24,7 +31,8 @@ class SimpleRenderSystem {
   void renderGameObjects(
       VkCommandBuffer commandBuffer,
       Model &model,
-      DescriptorSet &descriptorSet);
+      DescriptorSet &descriptorSet,
+      const glm::mat4 &modelMatrix);
 
  private:
   void createPipeline(VkRenderPass renderPass);
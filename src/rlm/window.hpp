@@ -16,6 +16,11 @@ class Window {
 
   GLFWwindow *getGLFWWindow() { return window; }
 
+  // The new extent arrives through the resize callback, once GLFW applied it
+  void setSize(int width, int height) {
+    glfwSetWindowSize(window, width, height);
+  }
+
   VkExtent2D getExtent() {
     return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
   }
@@ -0,0 +1,132 @@
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace change_detection_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+struct Velocity {
+  float dx;
+  float dy;
+};
+
+using Chunk = std::pair<size_t, size_t>;
+
+// 200 entities with a Position, so four chunks of one archetype
+class ChangeDetectionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    for (int i = 0; i < 200; i++) {
+      Position position{static_cast<float>(i), 0.0f};
+      entities.push_back(register_.createEntity(position));
+    }
+    // Everything so far counts as seen
+    changedChunks();
+  }
+
+  std::vector<Chunk> changedChunks() {
+    std::vector<Chunk> chunks;
+    register_.eachChangedChunk<Position>(
+        sinceTick,
+        [&](ecs::Register::Archetype &, size_t begin, size_t end) {
+          chunks.emplace_back(begin, end);
+        });
+    return chunks;
+  }
+
+  ecs::Register register_;
+  std::vector<ecs::EntityID> entities;
+  uint32_t sinceTick = 0;
+};
+
+TEST_F(ChangeDetectionTest, TheFirstPassSeesEverything) {
+  uint32_t first = 0;
+  size_t rows = 0;
+  register_.eachChangedChunk<Position>(
+      first,
+      [&](ecs::Register::Archetype &archetype, size_t begin, size_t end) {
+        EXPECT_EQ(archetype.size(), 200u);
+        rows += end - begin;
+      });
+  EXPECT_EQ(rows, 200u);
+  EXPECT_NE(first, 0u);
+}
+
+TEST_F(ChangeDetectionTest, UntouchedChunksAreSkipped) {
+  EXPECT_TRUE(changedChunks().empty());
+
+  // Const terms don't write
+  register_.each<const Position>([](const Position &) {});
+  EXPECT_TRUE(changedChunks().empty());
+
+  // Neither do const lookups
+  EXPECT_EQ(register_.get<const Position>(entities[130]).x, 130.0f);
+  EXPECT_NE(register_.tryGet<const Position>(entities[10]), nullptr);
+  EXPECT_EQ(register_.tryGet<const Velocity>(entities[10]), nullptr);
+  EXPECT_TRUE(changedChunks().empty());
+}
+
+TEST_F(ChangeDetectionTest, WritesMarkTheirChunk) {
+  register_.get<Position>(entities[130]).x = -1.0f;
+  EXPECT_EQ(changedChunks(), (std::vector<Chunk>{{128, 192}}));
+  // Seen once
+  EXPECT_TRUE(changedChunks().empty());
+
+  register_.each<Position>([](Position &) {});
+  EXPECT_EQ(changedChunks().size(), 4u);
+}
+
+TEST_F(ChangeDetectionTest, StructuralChangesMarkTheRowsTheyTouch) {
+  // The last row fills the hole, the last chunk shrinks
+  register_.deleteEntity(entities[5]);
+  EXPECT_EQ(changedChunks(), (std::vector<Chunk>{{0, 64}}));
+
+  Position position{};
+  register_.createEntity(position);
+  EXPECT_EQ(changedChunks(), (std::vector<Chunk>{{192, 200}}));
+
+  register_.disable(entities[70]);
+  EXPECT_EQ(changedChunks(), (std::vector<Chunk>{{64, 128}}));
+  // Disabling twice changes nothing
+  register_.disable(entities[70]);
+  EXPECT_TRUE(changedChunks().empty());
+}
+
+TEST_F(ChangeDetectionTest, EntitiesMovingToAnotherArchetypeShowUpThere) {
+  register_.addComponent(Velocity{}, entities[10]);
+
+  std::vector<size_t> sizes;
+  register_.eachChangedChunk<Position>(
+      sinceTick,
+      [&](ecs::Register::Archetype &archetype, size_t begin, size_t end) {
+        sizes.push_back(archetype.size());
+        if (archetype.size() == 1) {
+          EXPECT_EQ(archetype.entities[begin], entities[10]);
+          EXPECT_EQ(end, 1u);
+        }
+      });
+  // The new archetype and the hole the entity left in the old one
+  EXPECT_EQ(sizes, (std::vector<size_t>{199, 1}));
+}
+
+TEST_F(ChangeDetectionTest, SnapshotsStillSeeWritesBetweenPasses) {
+  register_.setSnapshotFrames(2);
+  uint64_t frame = register_.snapshot();
+  register_.get<Position>(entities[0]).x = 42.0f;
+  changedChunks();
+  register_.snapshot();
+  register_.get<Position>(entities[0]).x = 43.0f;
+  changedChunks();
+
+  register_.restore(frame);
+  EXPECT_EQ(register_.get<Position>(entities[0]).x, 0.0f);
+}
+
+}  // namespace change_detection_test
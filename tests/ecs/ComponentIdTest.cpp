@@ -0,0 +1,93 @@
+#include <string_view>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace component_id_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+template <typename T> struct Box {
+  T value;
+};
+
+struct Renamed {
+  int value;
+};
+
+}  // namespace component_id_test
+
+template <>
+inline constexpr std::string_view
+    ecs::componentName<component_id_test::Renamed> = "tests.Renamed";
+
+namespace component_id_test {
+
+using Generator = ecs::ComponentIDGenerator;
+
+static_assert(
+    Generator::getStableComponentID<Position>() !=
+    Generator::getStableComponentID<Box<int>>());
+static_assert(
+    Generator::getStableComponentID<Box<int>>() !=
+    Generator::getStableComponentID<Box<float>>());
+
+// GCC and Clang spellings of the same names
+static_assert(
+    ecs::hashTypeName("Box<Box<int> >") == ecs::hashTypeName("Box<Box<int>>"));
+static_assert(
+    ecs::hashTypeName("game::{anonymous}::Position") ==
+    ecs::hashTypeName("game::(anonymous namespace)::Position"));
+static_assert(
+    ecs::hashTypeName("game::Position") != ecs::hashTypeName("game::Positio"));
+
+TEST(ComponentIdTest, StableIdsAreTheHashOfTheTypeName) {
+  const Generator::ComponentInfo &info =
+      Generator::getComponentInfo(Generator::getComponentID<Position>());
+
+  EXPECT_EQ(info.name, std::string_view("component_id_test::Position"));
+  EXPECT_EQ(info.stableID, ecs::hashTypeName(info.name));
+  EXPECT_EQ(info.stableID, Generator::getStableComponentID<Position>());
+}
+
+TEST(ComponentIdTest, ExplicitNamesReplaceTheCompilerSpelling) {
+  const Generator::ComponentInfo &info =
+      Generator::getComponentInfo(Generator::getComponentID<Renamed>());
+
+  EXPECT_EQ(info.name, std::string_view("tests.Renamed"));
+  EXPECT_EQ(info.stableID, ecs::hashTypeName("tests.Renamed"));
+  EXPECT_EQ(
+      Generator::findComponentByStableID(ecs::hashTypeName("tests.Renamed")),
+      Generator::getComponentID<Renamed>());
+}
+
+TEST(ComponentIdTest, StableIdsLeadBackToTheComponent) {
+  for (ecs::ComponentID componentID :
+       {Generator::getComponentID<Position>(),
+        Generator::getComponentID<Box<int>>(),
+        Generator::getComponentID<Box<float>>()}) {
+    EXPECT_NE(componentID, 0u);
+    const Generator::ComponentInfo &info =
+        Generator::getComponentInfo(componentID);
+    EXPECT_EQ(Generator::findComponentByStableID(info.stableID), componentID);
+  }
+  EXPECT_EQ(Generator::findComponentByStableID(ecs::hashTypeName("none")), 0u);
+}
+
+TEST(ComponentIdTest, TemplateInstancesAreDistinctComponents) {
+  ecs::Register register_;
+  Position position{1.0f, 2.0f};
+  ecs::EntityID entity = register_.createEntity(position);
+  register_.addComponent(Box<int>{3}, entity);
+  register_.addComponent(Box<float>{4.0f}, entity);
+
+  EXPECT_EQ(register_.get<Box<int>>(entity).value, 3);
+  EXPECT_EQ(register_.get<Box<float>>(entity).value, 4.0f);
+  EXPECT_EQ(register_.get<Position>(entity).y, 2.0f);
+}
+
+}  // namespace component_id_test
@@ -0,0 +1,119 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace edge_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+struct Velocity {
+  float dx;
+  float dy;
+};
+
+struct Health {
+  int points;
+};
+
+TEST(EdgeTest, AddingThenRemovingReturnsToTheSameArchetype) {
+  ecs::Register register_;
+  Position position{1.0f, 2.0f};
+  ecs::EntityID entity = register_.createEntity(position);
+  ecs::Register::Archetype *positionOnly = register_.findArchetype(entity);
+
+  register_.addComponent(Velocity{3.0f, 4.0f}, entity);
+  ecs::Register::Archetype *moving = register_.findArchetype(entity);
+  EXPECT_NE(moving, positionOnly);
+
+  register_.deleteComponent<Velocity>(entity);
+  EXPECT_EQ(register_.findArchetype(entity), positionOnly);
+  EXPECT_FALSE(register_.has<Velocity>(entity));
+  EXPECT_EQ(register_.get<Position>(entity).y, 2.0f);
+}
+
+TEST(EdgeTest, OrderOfAddsDoesNotChangeTheArchetype) {
+  ecs::Register register_;
+  Position position{0.0f, 0.0f};
+  Velocity velocity{0.0f, 0.0f};
+  ecs::EntityID first = register_.createEntity(position);
+  register_.addComponent(Velocity{}, first);
+  ecs::EntityID second = register_.createEntity(velocity);
+  register_.addComponent(Position{}, second);
+
+  EXPECT_EQ(register_.findArchetype(first), register_.findArchetype(second));
+}
+
+TEST(EdgeTest, MovesKeepTheValuesOfEveryEntity) {
+  ecs::Register register_;
+  std::vector<ecs::EntityID> entities;
+  for (int i = 0; i < 10; i++) {
+    Health health{i};
+    entities.push_back(register_.createEntity(health));
+  }
+  // Moving rows out of the middle swaps the last row into their place
+  for (int i = 0; i < 10; i += 3) {
+    register_.addComponent(Position{static_cast<float>(i), 0.0f}, entities[i]);
+  }
+
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(register_.get<Health>(entities[i]).points, i);
+    EXPECT_EQ(register_.has<Position>(entities[i]), i % 3 == 0);
+  }
+  EXPECT_EQ(register_.get<Position>(entities[9]).x, 9.0f);
+}
+
+TEST(EdgeTest, MaintainFreesEmptyArchetypesAndTheirEdges) {
+  ecs::Register register_;
+  Position position{};
+  ecs::EntityID keep = register_.createEntity(position);
+  size_t archetypesBefore = register_.stats().archetypes.size();
+
+  for (int round = 0; round < 3; round++) {
+    Position moved{static_cast<float>(round), 0.0f};
+    ecs::EntityID entity = register_.createEntity(moved);
+    register_.addComponent(Velocity{1.0f, 1.0f}, entity);
+    register_.addComponent(Health{round}, entity);
+    EXPECT_EQ(register_.get<Health>(entity).points, round);
+    register_.deleteEntity(entity);
+
+    EXPECT_EQ(register_.compact(), 2u);
+    EXPECT_EQ(register_.stats().archetypes.size(), archetypesBefore);
+    // Only the edge back to the base archetype is left, the ones to the freed
+    // archetypes went with them
+    EXPECT_EQ(register_.findArchetype(keep)->edges.size(), 1u);
+  }
+  EXPECT_TRUE(register_.isEntityAlive(keep));
+}
+
+TEST(EdgeTest, MaintainStopsAtTheBudgetAndKeepsTheRestQueued) {
+  ecs::Register register_;
+  Position position{};
+  for (int i = 0; i < 4; i++) {
+    ecs::EntityID entity = register_.createEntity(position);
+    switch (i) {
+    case 1:
+      register_.addComponent(Velocity{}, entity);
+      break;
+    case 2:
+      register_.addComponent(Health{}, entity);
+      break;
+    case 3:
+      register_.addComponent(Velocity{}, entity);
+      register_.addComponent(Health{}, entity);
+      break;
+    }
+    register_.deleteEntity(entity);
+  }
+
+  size_t freed = register_.maintain(std::chrono::nanoseconds(0));
+  EXPECT_EQ(freed, 1u);
+  EXPECT_EQ(freed + register_.compact(), 4u);
+  EXPECT_EQ(register_.stats().archetypes.size(), 1u);
+}
+
+}  // namespace edge_test
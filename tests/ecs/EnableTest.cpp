@@ -0,0 +1,141 @@
+#include <chrono>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace enable_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+struct Velocity {
+  float dx;
+  float dy;
+};
+
+TEST(EnableTest, DisabledEntitiesStayInPlaceAndAreSkipped) {
+  ecs::Register register_;
+  std::vector<ecs::EntityID> entities;
+  for (int i = 0; i < 200; i++) {
+    Position position{static_cast<float>(i), 0.0f};
+    entities.push_back(register_.createEntity(position));
+  }
+  ecs::Register::Archetype *archetype = register_.findArchetype(entities[0]);
+
+  // Rows in several 64 bit words of the enable mask
+  for (int i = 0; i < 200; i += 7) {
+    register_.disable(entities[i]);
+  }
+  EXPECT_EQ(register_.findArchetype(entities[0]), archetype);
+  EXPECT_EQ(archetype->size(), 200u);
+  EXPECT_FALSE(register_.isEnabled(entities[0]));
+  EXPECT_TRUE(register_.isEnabled(entities[1]));
+  EXPECT_EQ(register_.get<Position>(entities[7]).x, 7.0f);
+
+  size_t visited = 0;
+  register_.each<Position>([&](Position &position) {
+    EXPECT_NE(static_cast<int>(position.x) % 7, 0);
+    visited++;
+  });
+  EXPECT_EQ(visited, 200u - 29u);
+
+  register_.enable(entities[0]);
+  visited = 0;
+  register_.each<Position>([&](Position &) { visited++; });
+  EXPECT_EQ(visited, 200u - 28u);
+}
+
+TEST(EnableTest, TheBitFollowsTheEntityThroughMoves) {
+  ecs::Register register_;
+  Position position{};
+  ecs::EntityID disabled = register_.createEntity(position);
+  ecs::EntityID enabled = register_.createEntity(position);
+  register_.disable(disabled);
+
+  register_.addComponent(Velocity{}, disabled);
+  // The last row is swapped into the place of the moved one
+  EXPECT_TRUE(register_.isEnabled(enabled));
+  EXPECT_FALSE(register_.isEnabled(disabled));
+
+  register_.deleteComponent<Velocity>(disabled);
+  EXPECT_FALSE(register_.isEnabled(disabled));
+}
+
+// Random structural changes against a reference set of disabled entities
+TEST(EnableTest, RandomChangesKeepTheBitsConsistent) {
+  ecs::Register register_;
+  std::mt19937 random(3);
+  std::vector<ecs::EntityID> entities;
+  std::set<ecs::EntityID> alive;
+  std::set<ecs::EntityID> disabled;
+  for (int i = 0; i < 500; i++) {
+    Position position{static_cast<float>(i), 0.0f};
+    ecs::EntityID entity = register_.createEntity(position);
+    entities.push_back(entity);
+    alive.insert(entity);
+  }
+
+  for (int step = 0; step < 20000; step++) {
+    ecs::EntityID entity = entities[random() % entities.size()];
+    if (!alive.contains(entity)) {
+      continue;
+    }
+    switch (random() % 6) {
+    case 0:
+      register_.disable(entity);
+      disabled.insert(entity);
+      break;
+    case 1:
+      register_.enable(entity);
+      disabled.erase(entity);
+      break;
+    case 2:
+      if (!register_.has<Velocity>(entity)) {
+        register_.addComponent(Velocity{}, entity);
+      }
+      break;
+    case 3:
+      if (register_.has<Velocity>(entity)) {
+        register_.deleteComponent<Velocity>(entity);
+      }
+      break;
+    case 4:
+      if (random() % 4 == 0) {
+        register_.deleteEntity(entity);
+        alive.erase(entity);
+        disabled.erase(entity);
+        Position position{};
+        ecs::EntityID created = register_.createEntity(position);
+        entities.push_back(created);
+        alive.insert(created);
+      }
+      break;
+    case 5:
+      register_.sort<Position>(
+          register_.query<Position>(),
+          [](const Position &position) { return -position.x; });
+      break;
+    }
+    if (step % 1000 == 0) {
+      register_.maintain(std::chrono::microseconds(50));
+    }
+  }
+
+  std::set<ecs::EntityID> visited;
+  register_.each<Position>([&](ecs::EntityID entity, Position &) {
+    EXPECT_FALSE(disabled.contains(entity));
+    EXPECT_TRUE(visited.insert(entity).second);
+  });
+  EXPECT_EQ(visited.size(), alive.size() - disabled.size());
+  for (ecs::EntityID entity : alive) {
+    EXPECT_EQ(register_.isEnabled(entity), !disabled.contains(entity));
+  }
+}
+
+}  // namespace enable_test
@@ -0,0 +1,67 @@
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace entity_id_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+TEST(EntityIdTest, IdAndGenerationRoundTrip) {
+  ecs::EntityID entity = ecs::Entity::createEntity(ecs::Entity::ID_MASK, 200);
+  EXPECT_EQ(ecs::Entity::getId(entity), ecs::Entity::ID_MASK);
+  EXPECT_EQ(ecs::Entity::getGen(entity), 200u);
+
+  entity = ecs::Entity::incrementGen(entity);
+  EXPECT_EQ(ecs::Entity::getId(entity), ecs::Entity::ID_MASK);
+  EXPECT_EQ(ecs::Entity::getGen(entity), 201u);
+}
+
+// Deletes and recreates the entity of one slot 300 times
+TEST(EntityIdTest, GenerationsOfAReusedSlot) {
+  ecs::Register register_;
+  Position position{};
+  ecs::EntityID first = register_.createEntity(position);
+  ecs::EntityID entity = first;
+  for (int i = 0; i < 300; i++) {
+    register_.deleteEntity(entity);
+    entity = register_.createEntity(position);
+    ASSERT_EQ(ecs::Entity::getId(entity), ecs::Entity::getId(first));
+  }
+
+#ifdef ECS_ENTITY_64
+  // 32 bit generations keep old ids dead well past 255 reuses
+  EXPECT_EQ(ecs::Entity::getGen(entity), 300u);
+  EXPECT_FALSE(register_.isEntityAlive(first));
+#else
+  // The 8 bit generation wraps, after 256 reuses an old id is live again
+  EXPECT_EQ(ecs::Entity::getGen(entity), 300u % 256u);
+  EXPECT_TRUE(register_.isEntityAlive(
+      ecs::Entity::createEntity(ecs::Entity::getId(first), 300 % 256)));
+#endif
+  EXPECT_TRUE(register_.isEntityAlive(entity));
+  EXPECT_EQ(register_.get<Position>(entity).x, 0.0f);
+}
+
+TEST(EntityIdTest, RunningOutOfIdsThrows) {
+#ifdef ECS_ENTITY_64
+  GTEST_SKIP() << "2^32 entities don't fit in a test";
+#else
+  ecs::Register register_;
+  // Id 0 is never handed out
+  for (ecs::EntityID id = 1; id <= ecs::Entity::ID_MASK; id++) {
+    ASSERT_EQ(register_.createEntity(), id);
+  }
+  EXPECT_THROW(register_.createEntity(), std::runtime_error);
+
+  // Freed slots are still handed out again
+  register_.deleteEntity(1);
+  EXPECT_EQ(ecs::Entity::getId(register_.createEntity()), 1u);
+#endif
+}
+
+}  // namespace entity_id_test
@@ -0,0 +1,100 @@
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace lookup_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+struct Velocity {
+  float dx;
+  float dy;
+};
+
+TEST(LookupTest, LiveEntitiesResolveToTheirComponents) {
+  ecs::Register register_;
+  Position position{1.0f, 2.0f};
+  ecs::EntityID entity = register_.createEntity(position);
+  register_.addComponent(Velocity{3.0f, 4.0f}, entity);
+
+  EXPECT_TRUE(register_.has<Position>(entity));
+  EXPECT_TRUE(register_.has<Velocity>(entity));
+  EXPECT_EQ(register_.get<Velocity>(entity).dy, 4.0f);
+  ASSERT_NE(register_.tryGet<Position>(entity), nullptr);
+  EXPECT_EQ(register_.tryGet<Position>(entity)->x, 1.0f);
+
+  register_.get<Position>(entity).x = 5.0f;
+  EXPECT_EQ(register_.tryGet<Position>(entity)->x, 5.0f);
+}
+
+TEST(LookupTest, MissingComponents) {
+  ecs::Register register_;
+  Position position{};
+  ecs::EntityID entity = register_.createEntity(position);
+  ecs::EntityID empty = register_.createEntity();
+
+  EXPECT_FALSE(register_.has<Velocity>(entity));
+  EXPECT_EQ(register_.tryGet<Velocity>(entity), nullptr);
+  EXPECT_THROW(register_.get<Velocity>(entity), std::runtime_error);
+
+  EXPECT_FALSE(register_.has<Position>(empty));
+  EXPECT_EQ(register_.tryGet<Position>(empty), nullptr);
+  EXPECT_THROW(register_.get<Position>(empty), std::runtime_error);
+}
+
+TEST(LookupTest, StaleIdsDontReachTheNewOwnerOfTheSlot) {
+  ecs::Register register_;
+  Position position{1.0f, 0.0f};
+  ecs::EntityID stale = register_.createEntity(position);
+  register_.deleteEntity(stale);
+
+  EXPECT_FALSE(register_.isEntityAlive(stale));
+  EXPECT_FALSE(register_.has<Position>(stale));
+  EXPECT_EQ(register_.tryGet<Position>(stale), nullptr);
+  EXPECT_THROW(register_.get<Position>(stale), std::runtime_error);
+
+  // The freed slot is reused with the next generation
+  Position reused{2.0f, 0.0f};
+  ecs::EntityID entity = register_.createEntity(reused);
+  ASSERT_EQ(ecs::Entity::getId(entity), ecs::Entity::getId(stale));
+  ASSERT_NE(entity, stale);
+
+  EXPECT_TRUE(register_.isEntityAlive(entity));
+  EXPECT_EQ(register_.get<Position>(entity).x, 2.0f);
+  EXPECT_FALSE(register_.isEntityAlive(stale));
+  EXPECT_FALSE(register_.has<Position>(stale));
+  EXPECT_EQ(register_.tryGet<Position>(stale), nullptr);
+  EXPECT_THROW(register_.get<Position>(stale), std::runtime_error);
+}
+
+TEST(LookupTest, IdsThatWereNeverHandedOut) {
+  ecs::Register register_;
+  Position position{};
+  register_.createEntity(position);
+  ecs::EntityID unknown = ecs::Entity::createEntity(1000);
+
+  EXPECT_FALSE(register_.isEntityAlive(unknown));
+  EXPECT_FALSE(register_.has<Position>(unknown));
+  EXPECT_EQ(register_.tryGet<Position>(unknown), nullptr);
+  EXPECT_THROW(register_.get<Position>(unknown), std::runtime_error);
+}
+
+TEST(LookupTest, LookupsFollowMovedRows) {
+  ecs::Register register_;
+  Position first{1.0f, 0.0f};
+  Position second{2.0f, 0.0f};
+  ecs::EntityID moved = register_.createEntity(first);
+  ecs::EntityID swapped = register_.createEntity(second);
+
+  // The last row takes the place of the moved one
+  register_.addComponent(Velocity{}, moved);
+  EXPECT_EQ(register_.get<Position>(moved).x, 1.0f);
+  EXPECT_EQ(register_.get<Position>(swapped).x, 2.0f);
+}
+
+}  // namespace lookup_test
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace memory_resource_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+struct Velocity {
+  float dx;
+  float dy;
+};
+
+struct Mesh {
+  int id;
+
+  bool operator==(const Mesh &) const = default;
+};
+
+// Counts what goes through it and checks that everything comes back
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  explicit CountingResource(std::pmr::memory_resource *upstream)
+      : upstream(upstream) {}
+
+  size_t allocations = 0;
+  size_t outstandingBytes = 0;
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    allocations++;
+    outstandingBytes += bytes;
+    return upstream->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *pointer, size_t bytes, size_t alignment) override {
+    outstandingBytes -= bytes;
+    upstream->deallocate(pointer, bytes, alignment);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource *upstream;
+};
+
+// Anything that falls back to the default resource throws while it is set
+class NullDefaultResource {
+ public:
+  NullDefaultResource()
+      : previous(
+            std::pmr::set_default_resource(std::pmr::null_memory_resource())) {
+  }
+
+  ~NullDefaultResource() { std::pmr::set_default_resource(previous); }
+
+ private:
+  std::pmr::memory_resource *previous;
+};
+
+TEST(MemoryResourceTest, RegisterOnlyUsesItsResources) {
+  std::pmr::unsynchronized_pool_resource pool(
+      std::pmr::new_delete_resource());
+  CountingResource persistent(&pool);
+  std::pmr::monotonic_buffer_resource frame(
+      1 << 20, std::pmr::new_delete_resource());
+  {
+    NullDefaultResource nullDefault;
+    ecs::Register register_(&persistent);
+    register_.setFrameResource(&frame);
+    register_.setSnapshotFrames(4);
+    size_t added = 0;
+    register_.observe<ecs::OnAdd<Position>>(
+        [&](ecs::Register &, const ecs::Register::ObserverBatch &batch) {
+          added += batch.entities.size();
+        });
+    ecs::SharedHandle<Mesh> mesh = register_.addSharedValue(Mesh{7});
+
+    std::vector<ecs::EntityID> entities;
+    for (int i = 0; i < 1000; i++) {
+      Position position{static_cast<float>(i), 0.0f};
+      ecs::EntityID entity = register_.createEntity(position);
+      if (i % 2 == 1) {
+        register_.addComponent(Velocity{1.0f, 0.0f}, entity);
+      }
+      if (i % 3 == 0) {
+        register_.setShared(entity, mesh);
+      }
+      entities.push_back(entity);
+    }
+    register_.flushObservers();
+    EXPECT_EQ(added, 1000u);
+
+    size_t visited = 0;
+    register_.each<Position, ecs::Optional<Velocity>>(
+        [&](Position &, Velocity *) { visited++; });
+    EXPECT_EQ(visited, 1000u);
+
+    uint64_t saved = register_.snapshot();
+    for (int i = 0; i < 100; i++) {
+      register_.deleteEntity(entities[i]);
+    }
+    register_.restore(saved);
+    register_.sort<Position>(
+        *register_.findArchetype(entities[1]),
+        [](const Position &position) { return -position.x; });
+    register_.reserve<Position, Velocity>(5000);
+    register_.maintain(std::chrono::milliseconds(1));
+    EXPECT_TRUE(register_.isEntityAlive(entities[0]));
+    EXPECT_GT(persistent.allocations, 0u);
+  }
+  EXPECT_EQ(persistent.outstandingBytes, 0u);
+}
+
+TEST(MemoryResourceTest, ReservedArchetypeFillsWithoutAllocating) {
+  CountingResource counting(std::pmr::new_delete_resource());
+  ecs::Register register_(&counting);
+  register_.reserve<Position>(10000);
+  // The first entity links the archetype to the base one, the edges are the
+  // only thing not sized by reserve
+  Position first{0.0f, 0.0f};
+  register_.createEntity(first);
+  size_t before = counting.allocations;
+
+  for (int i = 1; i < 10000; i++) {
+    Position position{static_cast<float>(i), 0.0f};
+    register_.createEntity(position);
+  }
+  EXPECT_EQ(counting.allocations, before);
+}
+
+}  // namespace memory_resource_test
@@ -0,0 +1,227 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace observer_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+struct Velocity {
+  float dx;
+  float dy;
+};
+
+using Batch = ecs::Register::ObserverBatch;
+
+TEST(ObserverTest, EventsWaitForTheFlush) {
+  ecs::Register register_;
+  size_t added = 0;
+  register_.observe<ecs::OnAdd<Position>>(
+      [&](ecs::Register &, const Batch &batch) {
+        added += batch.entities.size();
+      });
+
+  Position position{};
+  register_.createEntity(position);
+  register_.createEntity(position);
+  EXPECT_EQ(added, 0u);
+
+  register_.flushObservers();
+  EXPECT_EQ(added, 2u);
+  // Nothing is delivered twice
+  register_.flushObservers();
+  EXPECT_EQ(added, 2u);
+}
+
+TEST(ObserverTest, OneBatchPerArchetype) {
+  ecs::Register register_;
+  std::vector<ecs::Register::Archetype *> archetypes;
+  size_t added = 0;
+  register_.observe<ecs::OnAdd<Position>>(
+      [&](ecs::Register &, const Batch &batch) {
+        archetypes.push_back(batch.archetype);
+        added += batch.entities.size();
+      });
+
+  Position position{};
+  Velocity velocity{};
+  for (int i = 0; i < 10; i++) {
+    ecs::EntityID entity = register_.createEntity(position);
+    if (i % 2 == 0) {
+      register_.addComponent(velocity, entity);
+    }
+  }
+  register_.flushObservers();
+
+  EXPECT_EQ(added, 10u);
+  ASSERT_EQ(archetypes.size(), 2u);
+  EXPECT_NE(archetypes[0], archetypes[1]);
+}
+
+TEST(ObserverTest, SeveralEventsOnOneEntityAreDeliveredOnce) {
+  ecs::Register register_;
+  std::vector<ecs::EntityID> updated;
+  register_.observe<ecs::OnUpdateComponent<Position>>(
+      [&](ecs::Register &, const Batch &batch) {
+        updated.insert(
+            updated.end(), batch.entities.begin(), batch.entities.end());
+      });
+
+  Position position{};
+  ecs::EntityID entity = register_.createEntity(position);
+  register_.updateComponent(Position{1.0f, 0.0f}, entity);
+  register_.updateComponent(Position{2.0f, 0.0f}, entity);
+  register_.flushObservers();
+
+  ASSERT_EQ(updated.size(), 1u);
+  EXPECT_EQ(updated[0], entity);
+}
+
+TEST(ObserverTest, WritesThroughGetAndEachAreNotUpdates) {
+  ecs::Register register_;
+  size_t updated = 0;
+  register_.observe<ecs::OnUpdateComponent<Position>>(
+      [&](ecs::Register &, const Batch &batch) {
+        updated += batch.entities.size();
+      });
+
+  Position position{};
+  ecs::EntityID entity = register_.createEntity(position);
+  register_.flushObservers();
+  ASSERT_EQ(updated, 1u);
+
+  register_.get<Position>(entity).x = 1.0f;
+  register_.each<Position>([](Position &value) { value.y = 1.0f; });
+  register_.flushObservers();
+  EXPECT_EQ(updated, 1u);
+}
+
+TEST(ObserverTest, AddsOfRemovedComponentsAreDropped) {
+  ecs::Register register_;
+  size_t added = 0;
+  register_.observe<ecs::OnAdd<Velocity>>(
+      [&](ecs::Register &, const Batch &batch) {
+        added += batch.entities.size();
+      });
+
+  Position position{};
+  ecs::EntityID kept = register_.createEntity(position);
+  ecs::EntityID removed = register_.createEntity(position);
+  register_.addComponent(Velocity{}, kept);
+  register_.addComponent(Velocity{}, removed);
+  register_.deleteComponent<Velocity>(removed);
+  register_.flushObservers();
+
+  EXPECT_EQ(added, 1u);
+}
+
+TEST(ObserverTest, RemovalsOfDeletedEntitiesHaveNoArchetype) {
+  ecs::Register register_;
+  std::vector<ecs::Register::Archetype *> archetypes;
+  size_t removed = 0;
+  register_.observe<ecs::OnRemove<Position>>(
+      [&](ecs::Register &, const Batch &batch) {
+        archetypes.push_back(batch.archetype);
+        removed += batch.entities.size();
+      });
+
+  Position position{};
+  std::vector<ecs::EntityID> entities;
+  for (int i = 0; i < 5; i++) {
+    ecs::EntityID entity = register_.createEntity(position);
+    register_.addComponent(Velocity{}, entity);
+    entities.push_back(entity);
+  }
+  register_.deleteEntity(entities[0]);
+  register_.deleteEntity(entities[1]);
+  register_.deleteComponent<Position>(entities[2]);
+  register_.flushObservers();
+
+  EXPECT_EQ(removed, 3u);
+  ASSERT_EQ(archetypes.size(), 2u);
+  // The entity that only lost Position is in its Velocity archetype now
+  bool deletedBatch = archetypes[0] == nullptr || archetypes[1] == nullptr;
+  EXPECT_TRUE(deletedBatch);
+  EXPECT_TRUE(
+      archetypes[0] == register_.findArchetype(entities[2]) ||
+      archetypes[1] == register_.findArchetype(entities[2]));
+}
+
+TEST(ObserverTest, CallbacksCanChangeTheRegister) {
+  ecs::Register register_;
+  register_.observe<ecs::OnAdd<Position>>(
+      [](ecs::Register &register_, const Batch &batch) {
+        for (ecs::EntityID entity : batch.entities) {
+          register_.addComponent(Velocity{1.0f, 1.0f}, entity);
+        }
+      });
+
+  Position position{};
+  ecs::EntityID entity = register_.createEntity(position);
+  register_.flushObservers();
+
+  EXPECT_TRUE(register_.has<Velocity>(entity));
+}
+
+TEST(ObserverTest, ObserversAddedByCallbacksWaitForTheNextFlush) {
+  ecs::Register register_;
+  size_t added = 0;
+  size_t lateAdded = 0;
+  register_.observe<ecs::OnAdd<Position>>(
+      [&](ecs::Register &register_, const Batch &batch) {
+        added += batch.entities.size();
+        // Enough registrations to reallocate the callbacks of the channel
+        for (int i = 0; i < 16; i++) {
+          register_.observe<ecs::OnAdd<Position>>(
+              [&](ecs::Register &, const Batch &batch) {
+                lateAdded += batch.entities.size();
+              });
+        }
+      });
+
+  Position position{};
+  register_.createEntity(position);
+  register_.flushObservers();
+  EXPECT_EQ(added, 1u);
+  EXPECT_EQ(lateAdded, 0u);
+
+  register_.createEntity(position);
+  register_.flushObservers();
+  EXPECT_EQ(added, 2u);
+  EXPECT_EQ(lateAdded, 16u);
+}
+
+TEST(ObserverTest, FlushesFromCallbacksRunAfterTheCurrentOne) {
+  ecs::Register register_;
+  std::vector<ecs::EntityID> added;
+  std::vector<ecs::EntityID> moving;
+  register_.observe<ecs::OnAdd<Position>>(
+      [&](ecs::Register &register_, const Batch &batch) {
+        for (ecs::EntityID entity : batch.entities) {
+          register_.addComponent(Velocity{}, entity);
+        }
+        register_.flushObservers();
+        // The batch still holds the entities of this delivery
+        added.insert(added.end(), batch.entities.begin(), batch.entities.end());
+      });
+  register_.observe<ecs::OnAdd<Velocity>>(
+      [&](ecs::Register &, const Batch &batch) {
+        moving.insert(
+            moving.end(), batch.entities.begin(), batch.entities.end());
+      });
+
+  Position position{};
+  ecs::EntityID first = register_.createEntity(position);
+  ecs::EntityID second = register_.createEntity(position);
+  register_.flushObservers();
+
+  EXPECT_EQ(added, (std::vector<ecs::EntityID>{first, second}));
+  EXPECT_EQ(moving.size(), 2u);
+}
+
+}  // namespace observer_test
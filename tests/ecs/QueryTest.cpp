@@ -0,0 +1,160 @@
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace query_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+struct Velocity {
+  float dx;
+  float dy;
+};
+
+struct Frozen {
+  bool permanent;
+};
+
+struct Tag {
+  int value;
+};
+
+class QueryTest : public ::testing::Test {
+ protected:
+  // 12 entities with Position, every second one moving and every third one
+  // frozen
+  void SetUp() override {
+    for (int i = 0; i < 12; i++) {
+      Position position{static_cast<float>(i), 0.0f};
+      ecs::EntityID entity = register_.createEntity(position);
+      if (i % 2 == 0) {
+        register_.addComponent(Velocity{1.0f, 0.0f}, entity);
+      }
+      if (i % 3 == 0) {
+        register_.addComponent(Frozen{false}, entity);
+      }
+      entities.push_back(entity);
+    }
+  }
+
+  ecs::Register register_;
+  std::vector<ecs::EntityID> entities;
+};
+
+TEST_F(QueryTest, WithMatchesEveryArchetypeHavingTheComponents) {
+  size_t visited = 0;
+  register_.each<Position, ecs::With<Velocity>>(
+      [&](Position &position, Velocity &) {
+        EXPECT_EQ(static_cast<int>(position.x) % 2, 0);
+        visited++;
+      });
+  EXPECT_EQ(visited, 6u);
+}
+
+TEST_F(QueryTest, WithoutExcludesArchetypes) {
+  size_t visited = 0;
+  register_.each<Position, ecs::Without<Frozen>>([&](Position &position) {
+    EXPECT_NE(static_cast<int>(position.x) % 3, 0);
+    visited++;
+  });
+  EXPECT_EQ(visited, 8u);
+}
+
+TEST_F(QueryTest, OptionalPassesNullForMissingComponents) {
+  size_t visited = 0;
+  size_t moving = 0;
+  register_.each<Position, ecs::Optional<Velocity>>(
+      [&](ecs::EntityID entity, Position &, Velocity *velocity) {
+        EXPECT_EQ(velocity != nullptr, register_.has<Velocity>(entity));
+        visited++;
+        moving += velocity != nullptr;
+      });
+  EXPECT_EQ(visited, 12u);
+  EXPECT_EQ(moving, 6u);
+}
+
+TEST_F(QueryTest, EachWritesThroughToTheRegister) {
+  register_.each<Velocity, Position>(
+      [](Velocity &velocity, Position &position) {
+        position.x += velocity.dx;
+      });
+  EXPECT_EQ(register_.get<Position>(entities[0]).x, 1.0f);
+  EXPECT_EQ(register_.get<Position>(entities[1]).x, 1.0f);
+  EXPECT_EQ(register_.get<Position>(entities[2]).x, 3.0f);
+}
+
+TEST_F(QueryTest, CachedQueriesFollowNewAndFreedArchetypes) {
+  ecs::Register::Query &moving = register_.query<Position, Velocity>();
+  // Position + Velocity and Position + Velocity + Frozen
+  EXPECT_EQ(moving.archetypes.size(), 2u);
+  EXPECT_EQ((&register_.query<Position, Velocity>()), &moving);
+
+  register_.addComponent(Tag{1}, entities[0]);
+  EXPECT_EQ(moving.archetypes.size(), 3u);
+
+  register_.deleteEntity(entities[0]);
+  register_.compact();
+  EXPECT_EQ(moving.archetypes.size(), 2u);
+  EXPECT_EQ(register_.findArchetypes<Velocity>().size(), 2u);
+}
+
+TEST_F(QueryTest, TermPacksInAnyOrderShareOneQueryPerRegister) {
+  ecs::Register::Query &moving = register_.query<Position, Velocity>();
+  EXPECT_EQ((&register_.query<Velocity, Position>()), &moving);
+  EXPECT_EQ((&register_.query<Position, ecs::With<Velocity>>()), &moving);
+
+  // The slot of a term pack is process wide, the query behind it is not
+  ecs::Register other;
+  Position position{0.0f, 0.0f};
+  ecs::EntityID entity = other.createEntity(position);
+  other.addComponent(Velocity{1.0f, 0.0f}, entity);
+  ecs::Register::Query &otherMoving = other.query<Position, Velocity>();
+  EXPECT_NE(&otherMoving, &moving);
+  EXPECT_EQ(otherMoving.archetypes.size(), 1u);
+  EXPECT_EQ(moving.archetypes.size(), 2u);
+}
+
+#ifndef NDEBUG
+TEST_F(QueryTest, StructuralChangesInsideEachAssert) {
+  EXPECT_DEATH(
+      register_.each<Position>([&](ecs::EntityID entity, Position &) {
+        register_.addComponent(Tag{1}, entity);
+      }),
+      "structural change inside Register::each");
+  EXPECT_DEATH(
+      register_.each<Position>(
+          [&](ecs::EntityID entity, Position &) {
+            register_.deleteEntity(entity);
+          }),
+      "structural change inside Register::each");
+}
+#endif
+
+TEST_F(QueryTest, EachAllowsWritesAndTogglesAndEndsItsScopeOnThrow) {
+  size_t visited = 0;
+  register_.each<Position>([&](ecs::EntityID entity, Position &position) {
+    position.y = 1.0f;
+    register_.disable(entity);
+    visited++;
+  });
+  EXPECT_EQ(visited, 12u);
+  for (ecs::EntityID entity : entities) {
+    register_.enable(entity);
+  }
+
+  EXPECT_THROW(
+      register_.each<Velocity>([](Velocity &) {
+        throw std::runtime_error("stop");
+      }),
+      std::runtime_error);
+  register_.addComponent(Tag{2}, entities[1]);
+  EXPECT_EQ(register_.get<Tag>(entities[1]).value, 2);
+}
+
+}  // namespace query_test
@@ -0,0 +1,119 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace shared_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+struct Mesh {
+  std::string name;
+
+  bool operator==(const Mesh &) const = default;
+};
+
+TEST(SharedTest, EqualValuesAreStoredOnce) {
+  ecs::Register register_;
+  ecs::SharedHandle<Mesh> cube = register_.addSharedValue(Mesh{"cube"});
+  ecs::SharedHandle<Mesh> sphere = register_.addSharedValue(Mesh{"sphere"});
+
+  EXPECT_NE(cube, sphere);
+  EXPECT_EQ(register_.addSharedValue(Mesh{"cube"}), cube);
+}
+
+TEST(SharedTest, EachValueGetsItsOwnArchetype) {
+  ecs::Register register_;
+  ecs::SharedHandle<Mesh> cube = register_.addSharedValue(Mesh{"cube"});
+  ecs::SharedHandle<Mesh> sphere = register_.addSharedValue(Mesh{"sphere"});
+  std::vector<ecs::EntityID> entities;
+  for (int i = 0; i < 10; i++) {
+    Position position{static_cast<float>(i), 0.0f};
+    ecs::EntityID entity = register_.createEntity(position);
+    register_.setShared(entity, i % 2 == 0 ? cube : sphere);
+    entities.push_back(entity);
+  }
+
+  EXPECT_EQ(
+      register_.findArchetype(entities[0]),
+      register_.findArchetype(entities[2]));
+  EXPECT_NE(
+      register_.findArchetype(entities[0]),
+      register_.findArchetype(entities[1]));
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(register_.get<Position>(entities[i]).x, static_cast<float>(i));
+    EXPECT_EQ(
+        register_.getShared<Mesh>(entities[i])->name,
+        i % 2 == 0 ? "cube" : "sphere");
+  }
+}
+
+TEST(SharedTest, EachPassesTheValueOfTheArchetype) {
+  ecs::Register register_;
+  ecs::SharedHandle<Mesh> cube = register_.addSharedValue(Mesh{"cube"});
+  ecs::SharedHandle<Mesh> sphere = register_.addSharedValue(Mesh{"sphere"});
+  for (int i = 0; i < 10; i++) {
+    Position position{static_cast<float>(i), 0.0f};
+    ecs::EntityID entity = register_.createEntity(position);
+    register_.setShared(entity, i % 2 == 0 ? cube : sphere);
+  }
+  // Entities with only the shared value match as well
+  register_.setShared(register_.createEntity(), cube);
+
+  size_t cubes = 0;
+  size_t visited = 0;
+  register_.each<Position, ecs::Shared<Mesh>>(
+      [&](Position &position, const Mesh &mesh) {
+        EXPECT_EQ(
+            mesh.name,
+            static_cast<int>(position.x) % 2 == 0 ? "cube" : "sphere");
+        cubes += mesh.name == "cube";
+        visited++;
+      });
+  EXPECT_EQ(visited, 10u);
+  EXPECT_EQ(cubes, 5u);
+
+  size_t withMesh = 0;
+  register_.each<ecs::Shared<Mesh>>(
+      [&](ecs::EntityID, const Mesh &) { withMesh++; });
+  EXPECT_EQ(withMesh, 11u);
+}
+
+TEST(SharedTest, ReplacingAndRemovingKeepsTheComponents) {
+  ecs::Register register_;
+  ecs::SharedHandle<Mesh> cube = register_.addSharedValue(Mesh{"cube"});
+  ecs::SharedHandle<Mesh> sphere = register_.addSharedValue(Mesh{"sphere"});
+  Position position{3.0f, 4.0f};
+  ecs::EntityID entity = register_.createEntity(position);
+  register_.setShared(entity, cube);
+
+  register_.setShared(entity, sphere);
+  EXPECT_EQ(register_.getShared<Mesh>(entity)->name, "sphere");
+  EXPECT_EQ(register_.get<Position>(entity).y, 4.0f);
+
+  register_.removeShared<Mesh>(entity);
+  EXPECT_EQ(register_.getShared<Mesh>(entity), nullptr);
+  EXPECT_EQ(register_.get<Position>(entity).x, 3.0f);
+}
+
+TEST(SharedTest, ComponentChangesKeepTheSharedValue) {
+  ecs::Register register_;
+  ecs::SharedHandle<Mesh> cube = register_.addSharedValue(Mesh{"cube"});
+  ecs::EntityID entity = register_.createEntity();
+  register_.setShared(entity, cube);
+
+  register_.addComponent(Position{7.0f, 0.0f}, entity);
+  EXPECT_EQ(register_.get<Position>(entity).x, 7.0f);
+  EXPECT_EQ(register_.getShared<Mesh>(entity)->name, "cube");
+
+  register_.deleteComponent<Position>(entity);
+  EXPECT_FALSE(register_.has<Position>(entity));
+  EXPECT_EQ(register_.getShared<Mesh>(entity)->name, "cube");
+}
+
+}  // namespace shared_test
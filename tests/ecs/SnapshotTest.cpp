@@ -0,0 +1,260 @@
+#include <chrono>
+#include <map>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace snapshot_test {
+
+struct Health {
+  int points;
+};
+
+struct Speed {
+  double value;
+};
+
+struct Name {
+  std::string text;
+};
+
+struct Sprite {
+  int frame;
+};
+
+TEST(SnapshotTest, RestoreBringsBackValuesAndEntities) {
+  ecs::Register register_;
+  register_.setSnapshotFrames(4);
+  Health health{10};
+  ecs::EntityID kept = register_.createEntity(health);
+  ecs::EntityID deleted = register_.createEntity(health);
+  register_.addComponent(Name{"deleted"}, deleted);
+  uint64_t frame = register_.snapshot();
+
+  register_.get<Health>(kept).points = 1;
+  register_.addComponent(Speed{2.0}, kept);
+  register_.deleteEntity(deleted);
+  ecs::EntityID created = register_.createEntity(health);
+  register_.restore(frame);
+
+  EXPECT_EQ(register_.get<Health>(kept).points, 10);
+  EXPECT_FALSE(register_.has<Speed>(kept));
+  ASSERT_TRUE(register_.isEntityAlive(deleted));
+  EXPECT_EQ(register_.get<Name>(deleted).text, "deleted");
+  EXPECT_FALSE(register_.isEntityAlive(created));
+
+  // Ids handed out after the restore don't reuse live ones
+  ecs::EntityID next = register_.createEntity(health);
+  EXPECT_NE(next, kept);
+  EXPECT_NE(next, deleted);
+}
+
+TEST(SnapshotTest, TheRingKeepsTheLastFrames) {
+  ecs::Register register_;
+  EXPECT_THROW(register_.snapshot(), std::runtime_error);
+
+  register_.setSnapshotFrames(4);
+  Health health{0};
+  ecs::EntityID entity = register_.createEntity(health);
+  std::vector<uint64_t> frames;
+  for (int i = 0; i < 6; i++) {
+    register_.get<Health>(entity).points = i;
+    frames.push_back(register_.snapshot());
+  }
+
+  EXPECT_FALSE(register_.hasSnapshot(frames[0]));
+  EXPECT_FALSE(register_.hasSnapshot(frames[1]));
+  EXPECT_TRUE(register_.hasSnapshot(frames[2]));
+  EXPECT_THROW(register_.restore(frames[0]), std::runtime_error);
+
+  // Frames after the restored one are gone, the world continues from it
+  register_.restore(frames[3]);
+  EXPECT_EQ(register_.get<Health>(entity).points, 3);
+  EXPECT_TRUE(register_.hasSnapshot(frames[2]));
+  EXPECT_FALSE(register_.hasSnapshot(frames[4]));
+  EXPECT_FALSE(register_.hasSnapshot(frames[5]));
+}
+
+// Only a few scattered chunks are written between the snapshots, the
+// incremental copies and restores have to bring back exactly those
+TEST(SnapshotTest, SparseWritesAreSavedAndRestored) {
+  ecs::Register register_;
+  register_.setSnapshotFrames(4);
+  std::vector<ecs::EntityID> entities;
+  for (int i = 0; i < 1000; i++) {
+    Sprite sprite{i};
+    entities.push_back(register_.createEntity(sprite));
+    if (i % 2 == 1) {
+      register_.addComponent(Health{i}, entities.back());
+    }
+  }
+  uint64_t before = register_.snapshot();
+
+  for (int i = 0; i < 1000; i++) {
+    register_.setEnabled(entities[i], i % 300 == 7);
+  }
+  register_.each<Sprite, ecs::Optional<Health>>(
+      [](Sprite &sprite, Health *health) {
+        sprite.frame += 1000;
+        if (health != nullptr) {
+          health->points = -1;
+        }
+      });
+  for (ecs::EntityID entity : entities) {
+    register_.enable(entity);
+  }
+  uint64_t after = register_.snapshot();
+
+  auto countChanged = [&] {
+    size_t changed = 0;
+    register_.each<const Sprite, ecs::Optional<const Health>>(
+        [&](const Sprite &sprite, const Health *health) {
+          changed += sprite.frame >= 1000;
+          if (health != nullptr) {
+            EXPECT_EQ(health->points == -1, sprite.frame >= 1000);
+          }
+        });
+    return changed;
+  };
+  EXPECT_EQ(countChanged(), 4u);
+
+  register_.each<Sprite>([](Sprite &sprite) { sprite.frame = 0; });
+  register_.restore(after);
+  EXPECT_EQ(countChanged(), 4u);
+
+  register_.restore(before);
+  EXPECT_EQ(countChanged(), 0u);
+}
+
+struct EntityState {
+  bool enabled;
+  std::optional<int> health;
+  std::optional<double> speed;
+  std::optional<std::string> name;
+
+  bool operator==(const EntityState &) const = default;
+};
+
+using WorldState = std::map<ecs::EntityID, EntityState>;
+
+// Reads through const terms so reading doesn't mark chunks as written
+WorldState
+readWorld(ecs::Register &register_, const std::vector<ecs::EntityID> &live) {
+  WorldState world;
+  for (ecs::EntityID entity : live) {
+    world[entity].enabled = register_.isEnabled(entity);
+  }
+  register_.each<const Health>([&](ecs::EntityID entity, const Health &health) {
+    world[entity].health = health.points;
+  });
+  register_.each<const Speed>([&](ecs::EntityID entity, const Speed &speed) {
+    world[entity].speed = speed.value;
+  });
+  register_.each<const Name>([&](ecs::EntityID entity, const Name &name) {
+    world[entity].name = name.text;
+  });
+  return world;
+}
+
+// Random changes, snapshots and restores against a copy of the world taken
+// at every snapshot
+TEST(SnapshotTest, RandomRestoresMatchTheSavedWorld) {
+  ecs::Register register_;
+  register_.setSnapshotFrames(8);
+  std::mt19937 random(3);
+  std::vector<ecs::EntityID> live;
+  std::map<uint64_t, std::pair<WorldState, std::vector<ecs::EntityID>>> saved;
+  for (int i = 0; i < 300; i++) {
+    Health health{i};
+    live.push_back(register_.createEntity(health));
+  }
+
+  size_t restores = 0;
+  for (int frame = 0; frame < 400; frame++) {
+    int steps = static_cast<int>(random() % 60);
+    for (int step = 0; step < steps; step++) {
+      int operation = static_cast<int>(random() % 9);
+      if (operation == 0 || live.empty()) {
+        Health health{static_cast<int>(random() % 1000)};
+        live.push_back(
+            random() % 3 != 0 ? register_.createEntity(health)
+                              : register_.createEntity());
+        continue;
+      }
+      size_t index = random() % live.size();
+      ecs::EntityID entity = live[index];
+      switch (operation) {
+      case 1:
+        register_.deleteEntity(entity);
+        live[index] = live.back();
+        live.pop_back();
+        break;
+      case 2:
+        if (!register_.has<Speed>(entity)) {
+          register_.addComponent(
+              Speed{static_cast<double>(random() % 100)}, entity);
+        }
+        break;
+      case 3:
+        if (register_.has<Speed>(entity)) {
+          register_.deleteComponent<Speed>(entity);
+        }
+        break;
+      case 4:
+        if (!register_.has<Name>(entity)) {
+          register_.addComponent(Name{std::string(random() % 40, 'x')}, entity);
+        } else {
+          register_.get<Name>(entity).text += "y";
+        }
+        break;
+      case 5:
+        register_.setEnabled(entity, !register_.isEnabled(entity));
+        break;
+      case 6:
+        if (Health *health = register_.tryGet<Health>(entity)) {
+          health->points++;
+        }
+        break;
+      case 7:
+        register_.each<Health>([&](Health &health) {
+          if (random() % 50 == 0) {
+            health.points--;
+          }
+        });
+        break;
+      default:
+        if (register_.has<Name>(entity)) {
+          register_.deleteComponent<Name>(entity);
+        }
+        break;
+      }
+    }
+    if (random() % 5 == 0) {
+      register_.maintain(std::chrono::microseconds(100));
+    }
+
+    uint64_t current = register_.snapshot();
+    saved[current] = {readWorld(register_, live), live};
+    if (random() % 10 != 0) {
+      continue;
+    }
+    uint64_t back = current - random() % 8;
+    if (!register_.hasSnapshot(back)) {
+      continue;
+    }
+    register_.restore(back);
+    restores++;
+    live = saved[back].second;
+    ASSERT_EQ(readWorld(register_, live), saved[back].first);
+    saved.erase(saved.upper_bound(back), saved.end());
+  }
+  EXPECT_GT(restores, 0u);
+}
+
+}  // namespace snapshot_test
@@ -0,0 +1,114 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace sort_test {
+
+struct Depth {
+  int value;
+};
+
+struct Label {
+  std::string text;
+};
+
+struct Order {
+  int created;
+};
+
+// Checks the rows are ordered by depth and that every other column and the
+// entity index moved along with them
+void expectSorted(ecs::Register &register_) {
+  int previous = INT32_MIN;
+  register_.each<Depth, Label>(
+      [&](ecs::EntityID entity, Depth &depth, Label &label) {
+        EXPECT_GE(depth.value, previous);
+        previous = depth.value;
+        EXPECT_EQ(label.text, std::to_string(depth.value));
+        EXPECT_EQ(register_.get<Depth>(entity).value, depth.value);
+      });
+}
+
+TEST(SortTest, RowsFollowTheKey) {
+  ecs::Register register_;
+  std::mt19937 random(1);
+  std::vector<ecs::EntityID> entities;
+  for (int i = 0; i < 1000; i++) {
+    Depth depth{static_cast<int>(random() % 500)};
+    ecs::EntityID entity = register_.createEntity(depth);
+    register_.addComponent(Label{std::to_string(depth.value)}, entity);
+    entities.push_back(entity);
+  }
+  auto byDepth = [](const Depth &depth) { return depth.value; };
+
+  register_.sort<Depth>(register_.query<Depth, Label>(), byDepth);
+  expectSorted(register_);
+
+  // A few changes since the last sort take the incremental path
+  for (int i = 0; i < 5; i++) {
+    ecs::EntityID entity = entities[random() % entities.size()];
+    register_.get<Depth>(entity).value = static_cast<int>(random() % 500);
+    register_.get<Label>(entity).text =
+        std::to_string(register_.get<Depth>(entity).value);
+  }
+  register_.sort<Depth>(register_.query<Depth, Label>(), byDepth);
+  expectSorted(register_);
+
+  for (ecs::EntityID entity : entities) {
+    register_.get<Depth>(entity).value = static_cast<int>(random() % 500);
+    register_.get<Label>(entity).text =
+        std::to_string(register_.get<Depth>(entity).value);
+  }
+  register_.sort<Depth>(register_.query<Depth, Label>(), byDepth);
+  expectSorted(register_);
+}
+
+TEST(SortTest, EqualKeysKeepTheirOrder) {
+  ecs::Register register_;
+  for (int i = 0; i < 100; i++) {
+    Depth depth{i % 3};
+    ecs::EntityID entity = register_.createEntity(depth);
+    register_.addComponent(Order{i}, entity);
+  }
+  ecs::Register::Archetype *archetype =
+      register_.query<Depth, Order>().archetypes[0];
+
+  register_.sort<Depth>(
+      *archetype,
+      [](const Depth &depth) { return depth.value; });
+
+  Depth previousDepth{-1};
+  int previousOrder = -1;
+  register_.each<Depth, Order>([&](Depth &depth, Order &order) {
+    if (depth.value == previousDepth.value) {
+      EXPECT_GT(order.created, previousOrder);
+    }
+    previousDepth = depth;
+    previousOrder = order.created;
+  });
+}
+
+TEST(SortTest, ArchetypesWithoutTheComponentAreLeftAlone) {
+  ecs::Register register_;
+  std::vector<ecs::EntityID> entities;
+  for (int i = 0; i < 10; i++) {
+    Order order{9 - i};
+    entities.push_back(register_.createEntity(order));
+  }
+
+  register_.sort<Depth>(
+      *register_.findArchetype(entities[0]),
+      [](const Depth &depth) { return depth.value; });
+
+  ecs::Register::Archetype *archetype = register_.findArchetype(entities[0]);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(archetype->entities[i], entities[i]);
+  }
+}
+
+}  // namespace sort_test
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+
+namespace stats_test {
+
+struct Position {
+  float x;
+  float y;
+};
+
+struct Velocity {
+  float dx;
+  float dy;
+};
+
+struct Mesh {
+  int id;
+
+  bool operator==(const Mesh &) const = default;
+};
+
+using Generator = ecs::ComponentIDGenerator;
+
+// Stats of the archetype with exactly these components
+const ecs::ArchetypeStats *findArchetype(
+    const ecs::RegisterStats &stats, std::vector<ecs::ComponentID> type) {
+  std::sort(type.begin(), type.end());
+  for (const ecs::ArchetypeStats &archetype : stats.archetypes) {
+    if (archetype.components == type) {
+      return &archetype;
+    }
+  }
+  return nullptr;
+}
+
+class StatsTest : public ::testing::Test {
+ protected:
+  // 100 reserved Position rows holding 10 entities, and 3 moving entities
+  // of which one got deleted again
+  void SetUp() override {
+    register_.reserve<Position>(100);
+    for (int i = 0; i < 10; i++) {
+      Position position{};
+      register_.createEntity(position);
+    }
+    register_.newFrame();
+    for (int i = 0; i < 3; i++) {
+      Position position{};
+      ecs::EntityID entity = register_.createEntity(position);
+      register_.addComponent(Velocity{}, entity);
+      moving.push_back(entity);
+    }
+    register_.deleteEntity(moving[0]);
+    register_.newFrame();
+  }
+
+  ecs::Register register_;
+  std::vector<ecs::EntityID> moving;
+  ecs::ComponentID position = Generator::getComponentID<Position>();
+  ecs::ComponentID velocity = Generator::getComponentID<Velocity>();
+};
+
+TEST_F(StatsTest, ArchetypesReportTheirOccupancy) {
+  ecs::RegisterStats stats = register_.stats();
+
+  // The base archetype and the two above
+  ASSERT_EQ(stats.archetypes.size(), 3u);
+  EXPECT_EQ(stats.entityCount, 12u);
+
+  const ecs::ArchetypeStats *still = findArchetype(stats, {position});
+  ASSERT_NE(still, nullptr);
+  EXPECT_EQ(still->entityCount, 10u);
+  ASSERT_EQ(still->columns.size(), 1u);
+  EXPECT_EQ(still->columns[0].component, position);
+  EXPECT_EQ(still->columns[0].elementSize, sizeof(Position));
+  EXPECT_EQ(still->columns[0].count, 10u);
+  // Mostly empty after the reserve, the kind of archetype stats should show
+  EXPECT_EQ(still->columns[0].capacity, 100u);
+  EXPECT_EQ(still->columns[0].bytes, 100 * sizeof(Position));
+  EXPECT_GE(still->bytes, still->columns[0].bytes + 10 * sizeof(ecs::EntityID));
+
+  const ecs::ArchetypeStats *moves = findArchetype(stats, {position, velocity});
+  ASSERT_NE(moves, nullptr);
+  EXPECT_EQ(moves->entityCount, 2u);
+  ASSERT_EQ(moves->columns.size(), 2u);
+  for (const ecs::ColumnStats &column : moves->columns) {
+    EXPECT_EQ(column.count, 2u);
+    EXPECT_GE(column.capacity, column.count);
+    EXPECT_EQ(column.bytes, column.capacity * column.elementSize);
+  }
+  // Only the edge back to Position, nothing was added on top of it
+  EXPECT_EQ(moves->edgeCount, 1u);
+}
+
+TEST_F(StatsTest, TotalsAddUp) {
+  ecs::RegisterStats stats = register_.stats();
+
+  size_t archetypeBytes = 0;
+  for (const ecs::ArchetypeStats &archetype : stats.archetypes) {
+    archetypeBytes += archetype.bytes;
+  }
+  EXPECT_EQ(stats.archetypeBytes, archetypeBytes);
+  EXPECT_EQ(stats.freeListSize, 1u);
+  EXPECT_GE(stats.freeListBytes, sizeof(ecs::EntityID));
+  EXPECT_GE(stats.entityIndexBytes, 13u * sizeof(ecs::EntityID));
+  EXPECT_GT(stats.edgeMapBytes, 0u);
+  EXPECT_GT(stats.lookupIndexBytes, 0u);
+  EXPECT_EQ(
+      stats.totalBytes,
+      stats.archetypeBytes + stats.entityIndexBytes + stats.edgeMapBytes +
+          stats.freeListBytes + stats.lookupIndexBytes);
+}
+
+TEST_F(StatsTest, CountersCoverTheLastFrame) {
+  ecs::RegisterStats stats = register_.stats();
+  EXPECT_EQ(stats.lastFrame.entitiesCreated, 3u);
+  EXPECT_EQ(stats.lastFrame.entitiesDeleted, 1u);
+  EXPECT_EQ(stats.lastFrame.componentsAdded, 3u);
+  EXPECT_EQ(stats.lastFrame.archetypesCreated, 1u);
+
+  register_.newFrame();
+  stats = register_.stats();
+  EXPECT_EQ(stats.lastFrame.entitiesCreated, 0u);
+  EXPECT_EQ(stats.lastFrame.archetypesCreated, 0u);
+}
+
+TEST_F(StatsTest, JsonHoldsTheSameNumbers) {
+  ecs::RegisterStats stats = register_.stats();
+  std::ostringstream out;
+  stats.writeJson(out);
+  std::string json = out.str();
+
+  EXPECT_EQ(json.front(), '{');
+  EXPECT_EQ(json.back(), '}');
+  EXPECT_NE(json.find("\"entityCount\":12,"), std::string::npos);
+  EXPECT_NE(json.find("\"archetypeCount\":3,"), std::string::npos);
+  EXPECT_NE(json.find("\"freeListSize\":1,"), std::string::npos);
+  EXPECT_NE(
+      json.find("\"totalBytes\":" + std::to_string(stats.totalBytes) + ","),
+      std::string::npos);
+  EXPECT_NE(json.find("\"entitiesCreated\":3,"), std::string::npos);
+  EXPECT_NE(
+      json.find(
+          "{\"component\":" +
+          std::to_string(Generator::getStableComponentID<Position>()) +
+          ",\"elementSize\":" + std::to_string(sizeof(Position)) +
+          ",\"count\":10,\"capacity\":100,"),
+      std::string::npos);
+  EXPECT_EQ(
+      std::count(json.begin(), json.end(), '{'),
+      std::count(json.begin(), json.end(), '}'));
+}
+
+TEST_F(StatsTest, JsonWritesStableIdsAndSharedValuesApart) {
+  register_.addSharedValue(Mesh{1});
+  ecs::SharedHandle<Mesh> mesh = register_.addSharedValue(Mesh{2});
+  register_.setShared(moving[1], mesh);
+
+  std::ostringstream out;
+  register_.stats().writeJson(out);
+  std::string json = out.str();
+
+  std::string stablePosition =
+      std::to_string(Generator::getStableComponentID<Position>());
+  std::string stableVelocity =
+      std::to_string(Generator::getStableComponentID<Velocity>());
+  std::string stableMesh =
+      std::to_string(Generator::getStableComponentID<Mesh>());
+  // The type is sorted by dense id, whichever of the two came first
+  std::string components =
+      position < velocity ? stablePosition + "," + stableVelocity
+                          : stableVelocity + "," + stablePosition;
+  EXPECT_NE(
+      json.find(
+          "{\"components\":[" + components + "],\"shared\":[{\"component\":" +
+          stableMesh + ",\"value\":1}],\"entityCount\":1,"),
+      std::string::npos);
+  EXPECT_NE(
+      json.find(
+          "{\"components\":[" + stablePosition +
+          "],\"shared\":[],\"entityCount\":10,"),
+      std::string::npos);
+  // No dense or flagged pair id leaks into the dump
+  ecs::ComponentID pair = ecs::makeSharedPair(
+      Generator::getComponentID<Mesh>(), mesh.index);
+  EXPECT_EQ(json.find(std::to_string(pair)), std::string::npos);
+}
+
+}  // namespace stats_test
@@ -0,0 +1,162 @@
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "engine/event/EventBus.hpp"
+
+namespace event_bus_test {
+
+struct LineCleared {
+  int line;
+};
+
+struct Tagged {
+  int writer;
+  int sequence;
+};
+
+// Counts the allocations that reach it, and throws while failing is set
+class TestResource : public std::pmr::memory_resource {
+ public:
+  size_t allocations = 0;
+  bool failing = false;
+
+ private:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    if (failing) {
+      throw std::bad_alloc();
+    }
+    allocations++;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *pointer, size_t bytes, size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+  }
+
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+std::vector<int> readLines(engine::event::EventBus &bus) {
+  std::vector<int> lines;
+  bus.each<LineCleared>(
+      [&](const LineCleared &event) { lines.push_back(event.line); });
+  return lines;
+}
+
+TEST(EventBusTest, EventsAreReadTheFrameAfterTheyAreEmitted) {
+  engine::event::EventBus bus;
+  bus.channel<LineCleared>();
+  EXPECT_THROW(bus.emit(Tagged{}), std::runtime_error);
+
+  bus.emit(LineCleared{1});
+  bus.emit(LineCleared{2});
+  EXPECT_TRUE(readLines(bus).empty());
+
+  bus.swap();
+  bus.emit(LineCleared{3});
+  EXPECT_EQ(readLines(bus), (std::vector<int>{1, 2}));
+
+  bus.swap();
+  EXPECT_EQ(readLines(bus), (std::vector<int>{3}));
+  bus.swap();
+  EXPECT_TRUE(readLines(bus).empty());
+}
+
+// Several writers emit while the main thread reads the frame before, every
+// event arrives once and the events of each writer keep their order
+TEST(EventBusTest, ConcurrentWritersLoseNothing) {
+  constexpr int WRITERS = 4;
+  constexpr int EVENTS = 5000;
+  engine::event::EventBus bus;
+  engine::event::EventChannel<Tagged> &channel = bus.channel<Tagged>();
+
+  for (int frame = 0; frame < 6; frame++) {
+    std::vector<std::thread> writers;
+    for (int writer = 0; writer < WRITERS; writer++) {
+      writers.emplace_back([&channel, writer] {
+        for (int sequence = 0; sequence < EVENTS; sequence++) {
+          channel.emit(Tagged{writer, sequence});
+        }
+      });
+    }
+
+    std::vector<int> next(WRITERS, 0);
+    channel.each([&](const Tagged &event) {
+      EXPECT_EQ(event.sequence, next[event.writer]);
+      next[event.writer]++;
+    });
+    for (int writer = 0; writer < WRITERS; writer++) {
+      EXPECT_EQ(next[writer], frame == 0 ? 0 : EVENTS);
+    }
+
+    for (std::thread &writer : writers) {
+      writer.join();
+    }
+    bus.swap();
+    EXPECT_EQ(channel.size(), static_cast<size_t>(WRITERS * EVENTS));
+  }
+}
+
+TEST(EventBusTest, SteadyFramesDontAllocate) {
+  TestResource upstream;
+  engine::event::EventBus bus(1024, &upstream);
+  engine::event::EventChannel<LineCleared> &channel =
+      bus.channel<LineCleared>();
+
+  auto runFrame = [&] {
+    for (int i = 0; i < 3000; i++) {
+      channel.emit(LineCleared{i});
+    }
+    bus.swap();
+    EXPECT_EQ(channel.size(), 3000u);
+  };
+  // The arena grows until both of its frames fit the events
+  for (int frame = 0; frame < 4; frame++) {
+    runFrame();
+  }
+  size_t allocations = upstream.allocations;
+  for (int frame = 0; frame < 20; frame++) {
+    runFrame();
+  }
+  EXPECT_EQ(upstream.allocations, allocations);
+}
+
+TEST(EventBusTest, ChannelsComeFromUpstream) {
+  TestResource upstream;
+  engine::event::EventBus bus(0, &upstream);
+  size_t allocations = upstream.allocations;
+  bus.channel<LineCleared>();
+  bus.channel<Tagged>();
+  EXPECT_GT(upstream.allocations, allocations);
+
+  // Creating a channel that exists allocates nothing
+  allocations = upstream.allocations;
+  bus.channel<LineCleared>();
+  EXPECT_EQ(upstream.allocations, allocations);
+}
+
+TEST(EventBusTest, FailedEmitsDontBlockTheSwap) {
+  TestResource upstream;
+  engine::event::EventBus bus(0, &upstream);
+  bus.channel<LineCleared>();
+
+  upstream.failing = true;
+  EXPECT_THROW(bus.emit(LineCleared{1}), std::bad_alloc);
+  upstream.failing = false;
+  // Would wait forever for the event if the failed emit had taken an index
+  bus.swap();
+  EXPECT_TRUE(readLines(bus).empty());
+
+  bus.emit(LineCleared{2});
+  bus.swap();
+  EXPECT_EQ(readLines(bus), (std::vector<int>{2}));
+}
+
+}  // namespace event_bus_test
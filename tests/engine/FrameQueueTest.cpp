@@ -0,0 +1,78 @@
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "engine/FrameQueue.hpp"
+
+namespace frame_queue_test {
+
+TEST(FrameQueueTest, NeedsAPacket) {
+  EXPECT_THROW(engine::FrameQueue(0), std::runtime_error);
+}
+
+// Two packets in flight on a ring of three, so the ready ring wraps around
+TEST(FrameQueueTest, PacketsComeOutInSubmitOrder) {
+  engine::FrameQueue queue(3);
+  uint64_t tick = 0;
+  for (int frame = 0; frame < 10; frame++) {
+    std::vector<engine::FramePacket *> submitted;
+    for (int i = 0; i < 2; i++) {
+      engine::FramePacket *packet = queue.acquireFree();
+      ASSERT_NE(packet, nullptr);
+      packet->tick = ++tick;
+      queue.submit(packet);
+      submitted.push_back(packet);
+    }
+    for (engine::FramePacket *expected : submitted) {
+      engine::FramePacket *packet = queue.acquireReady();
+      ASSERT_EQ(packet, expected);
+      queue.release(packet);
+    }
+  }
+}
+
+TEST(FrameQueueTest, CloseDrainsTheReadyPackets) {
+  engine::FrameQueue queue(2);
+  engine::FramePacket *first = queue.acquireFree();
+  engine::FramePacket *second = queue.acquireFree();
+  queue.submit(first);
+  queue.submit(second);
+  queue.close();
+
+  EXPECT_EQ(queue.acquireFree(), nullptr);
+  EXPECT_EQ(queue.acquireReady(), first);
+  EXPECT_EQ(queue.acquireReady(), second);
+  EXPECT_EQ(queue.acquireReady(), nullptr);
+
+  // Reset opens it again with every packet free
+  queue.reset();
+  EXPECT_NE(queue.acquireFree(), nullptr);
+  EXPECT_NE(queue.acquireFree(), nullptr);
+}
+
+TEST(FrameQueueTest, SimulationAndRenderThreads) {
+  constexpr uint64_t FRAMES = 10000;
+  engine::FrameQueue queue(2);
+  std::thread simulation([&]() {
+    for (uint64_t tick = 1; tick <= FRAMES; tick++) {
+      engine::FramePacket *packet = queue.acquireFree();
+      packet->tick = tick;
+      queue.submit(packet);
+    }
+    queue.close();
+  });
+
+  uint64_t lastTick = 0;
+  while (engine::FramePacket *packet = queue.acquireReady()) {
+    EXPECT_EQ(packet->tick, lastTick + 1);
+    lastTick = packet->tick;
+    queue.release(packet);
+  }
+  simulation.join();
+  EXPECT_EQ(lastTick, FRAMES);
+}
+
+}  // namespace frame_queue_test
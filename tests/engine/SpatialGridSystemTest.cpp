@@ -0,0 +1,112 @@
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <gtest/gtest.h>
+
+#include "ecs/register.hpp"
+#include "engine/component/TransformComponent.hpp"
+#include "engine/system/SpatialGridSystem.hpp"
+
+namespace spatial_grid_system_test {
+
+using engine::component::TransformComponent;
+using Entities = std::vector<ecs::EntityID>;
+
+// 100 entities on a line through the middle of 16 by 16 cells
+class SpatialGridSystemTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    for (int i = 0; i < 100; i++) {
+      TransformComponent transform;
+      transform.position = glm::vec3(0.1f * i, 8.5f, 0.0f);
+      entities.push_back(register_.createEntity(transform));
+    }
+    system.update(register_, 0.0f);
+  }
+
+  // What the engine does after the systems of a tick
+  void tick() {
+    register_.flushObservers();
+    system.update(register_, 0.0f);
+  }
+
+  std::vector<ecs::EntityID> near(glm::vec2 point, float radius) {
+    std::vector<ecs::EntityID> found;
+    system.getGrid().queryRadius(point, radius, found);
+    return found;
+  }
+
+  ecs::Register register_;
+  engine::system::SpatialGridSystem system{{0.0f, 0.0f}, 1.0f, 16, 16};
+  std::vector<ecs::EntityID> entities;
+};
+
+TEST_F(SpatialGridSystemTest, EveryTransformIsInTheGrid) {
+  EXPECT_EQ(system.getGrid().size(), 100u);
+  EXPECT_EQ(near({0.0f, 8.5f}, 0.05f), Entities{entities[0]});
+}
+
+TEST_F(SpatialGridSystemTest, WrittenTransformsMove) {
+  register_.get<TransformComponent>(entities[42]).position =
+      glm::vec3(12.5f, 2.5f, 0.0f);
+  tick();
+  EXPECT_EQ(near({12.5f, 2.5f}, 0.5f), Entities{entities[42]});
+  EXPECT_TRUE(near({4.2f, 8.5f}, 0.01f).empty());
+}
+
+TEST_F(SpatialGridSystemTest, UnchangedChunksAreNotRead) {
+  // A write the register doesn't see, the const view marks nothing
+  register_.each<const TransformComponent>(
+      [&](ecs::EntityID entity, const TransformComponent &transform) {
+        if (entity == entities[10]) {
+          const_cast<TransformComponent &>(transform).position.y = 1.5f;
+        }
+      });
+  tick();
+  EXPECT_EQ(near({1.0f, 8.5f}, 0.01f), Entities{entities[10]});
+}
+
+TEST_F(SpatialGridSystemTest, DeletedEntitiesAndLostTransformsDropOut) {
+  register_.deleteEntity(entities[0]);
+  register_.deleteComponent<TransformComponent>(entities[1]);
+  tick();
+
+  EXPECT_EQ(system.getGrid().size(), 98u);
+  EXPECT_FALSE(system.getGrid().contains(entities[0]));
+  EXPECT_FALSE(system.getGrid().contains(entities[1]));
+  // The entity that filled the hole of the deleted one is still found
+  EXPECT_EQ(near({9.9f, 8.5f}, 0.01f), Entities{entities[99]});
+}
+
+TEST_F(SpatialGridSystemTest, TransformsAddedBackWithinTheTickStay) {
+  register_.deleteComponent<TransformComponent>(entities[5]);
+  TransformComponent transform;
+  transform.position = glm::vec3(3.5f, 3.5f, 0.0f);
+  register_.addComponent(transform, entities[5]);
+  tick();
+
+  EXPECT_EQ(near({3.5f, 3.5f}, 0.1f), Entities{entities[5]});
+}
+
+TEST_F(SpatialGridSystemTest, DisabledEntitiesAreLeftOut) {
+  register_.disable(entities[20]);
+  tick();
+  EXPECT_FALSE(system.getGrid().contains(entities[20]));
+
+  register_.enable(entities[20]);
+  tick();
+  EXPECT_EQ(near({2.0f, 8.5f}, 0.01f), Entities{entities[20]});
+}
+
+TEST_F(SpatialGridSystemTest, NewEntitiesAreInserted) {
+  TransformComponent transform;
+  transform.position = glm::vec3(14.5f, 14.5f, 0.0f);
+  ecs::EntityID entity = register_.createEntity(transform);
+  tick();
+
+  ecs::EntityID nearest = 0;
+  ASSERT_TRUE(system.getGrid().findNearest({15.0f, 15.0f}, 2.0f, nearest));
+  EXPECT_EQ(nearest, entity);
+}
+
+}  // namespace spatial_grid_system_test
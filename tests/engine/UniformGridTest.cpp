@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <gtest/gtest.h>
+
+#include "ecs/entity.hpp"
+#include "engine/spatial/UniformGrid.hpp"
+
+namespace uniform_grid_test {
+
+using engine::spatial::UniformGrid;
+
+ecs::EntityID makeEntity(ecs::EntityID id, ecs::EntityID generation = 0) {
+  return ecs::Entity::createEntity(id, generation);
+}
+
+std::vector<ecs::EntityID> sorted(std::vector<ecs::EntityID> entities) {
+  std::sort(entities.begin(), entities.end());
+  return entities;
+}
+
+// Ten by ten cells of size one, with one entity in the middle of cells
+// (1, 1), (2, 1), (5, 5) and (9, 9)
+class UniformGridTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    grid.update(a, {1.5f, 1.5f});
+    grid.update(b, {2.5f, 1.5f});
+    grid.update(c, {5.5f, 5.5f});
+    grid.update(d, {9.5f, 9.5f});
+    grid.flush();
+  }
+
+  UniformGrid grid{{0.0f, 0.0f}, 1.0f, 10, 10};
+  ecs::EntityID a = makeEntity(1);
+  ecs::EntityID b = makeEntity(2);
+  ecs::EntityID c = makeEntity(3);
+  ecs::EntityID d = makeEntity(4);
+};
+
+TEST(UniformGridConstructionTest, NeedsCellsWithASize) {
+  EXPECT_THROW(UniformGrid({0.0f, 0.0f}, 1.0f, 0, 10), std::runtime_error);
+  EXPECT_THROW(UniformGrid({0.0f, 0.0f}, 0.0f, 10, 10), std::runtime_error);
+}
+
+TEST_F(UniformGridTest, RangeQueries) {
+  std::vector<ecs::EntityID> found;
+  grid.queryRange({1.0f, 1.0f}, {3.0f, 2.0f}, found);
+  EXPECT_EQ(sorted(found), sorted({a, b}));
+
+  // The box is checked against positions, not just cells
+  found.clear();
+  grid.queryRange({1.0f, 1.0f}, {2.6f, 1.4f}, found);
+  EXPECT_TRUE(found.empty());
+
+  found.clear();
+  grid.queryRange({-100.0f, -100.0f}, {100.0f, 100.0f}, found);
+  EXPECT_EQ(sorted(found), sorted({a, b, c, d}));
+}
+
+TEST_F(UniformGridTest, RadiusQueries) {
+  std::vector<ecs::EntityID> found;
+  grid.queryRadius({2.0f, 1.5f}, 0.6f, found);
+  EXPECT_EQ(sorted(found), sorted({a, b}));
+
+  found.clear();
+  grid.queryRadius({5.5f, 6.5f}, 0.99f, found);
+  EXPECT_TRUE(found.empty());
+  grid.queryRadius({5.5f, 6.5f}, 1.0f, found);
+  EXPECT_EQ(found, std::vector<ecs::EntityID>{c});
+}
+
+TEST_F(UniformGridTest, NearestNeighbours) {
+  ecs::EntityID nearest = 0;
+  ASSERT_TRUE(grid.findNearest({2.2f, 1.5f}, 10.0f, nearest));
+  EXPECT_EQ(nearest, b);
+
+  // Across several empty rings of cells
+  ASSERT_TRUE(grid.findNearest({2.0f, 8.0f}, 10.0f, nearest));
+  EXPECT_EQ(nearest, c);
+
+  EXPECT_FALSE(grid.findNearest({5.5f, 2.0f}, 1.0f, nearest));
+}
+
+TEST_F(UniformGridTest, PositionsOutsideAreClampedToTheBorder) {
+  ecs::EntityID far = makeEntity(5);
+  grid.update(far, {-50.0f, 4.5f});
+  grid.flush();
+
+  std::vector<ecs::EntityID> found;
+  grid.queryRange({-60.0f, 4.0f}, {0.5f, 5.0f}, found);
+  EXPECT_EQ(found, std::vector<ecs::EntityID>{far});
+}
+
+TEST_F(UniformGridTest, MovesWithinACellAreVisibleRightAway) {
+  EXPECT_FALSE(grid.update(c, {5.9f, 5.1f}));
+
+  ecs::EntityID nearest = 0;
+  ASSERT_TRUE(grid.findNearest({6.5f, 5.0f}, 1.0f, nearest));
+  EXPECT_EQ(nearest, c);
+}
+
+TEST_F(UniformGridTest, NewAndMovedEntitiesWaitForTheFlush) {
+  ecs::EntityID e = makeEntity(5);
+  EXPECT_TRUE(grid.update(e, {7.5f, 7.5f}));
+  EXPECT_TRUE(grid.update(a, {7.6f, 7.5f}));
+  EXPECT_TRUE(grid.contains(e));
+  EXPECT_EQ(grid.size(), 5u);
+
+  std::vector<ecs::EntityID> found;
+  grid.queryRadius({7.5f, 7.5f}, 1.0f, found);
+  EXPECT_TRUE(found.empty());
+
+  grid.flush();
+  grid.queryRadius({7.5f, 7.5f}, 1.0f, found);
+  EXPECT_EQ(sorted(found), sorted({a, e}));
+  found.clear();
+  grid.queryRadius({1.5f, 1.5f}, 0.5f, found);
+  EXPECT_TRUE(found.empty());
+}
+
+TEST_F(UniformGridTest, RemovedEntitiesLeaveRightAway) {
+  grid.remove(b);
+  // Unknown entities are ignored
+  grid.remove(makeEntity(7));
+  EXPECT_FALSE(grid.contains(b));
+  EXPECT_EQ(grid.size(), 3u);
+
+  std::vector<ecs::EntityID> found;
+  grid.queryRange({0.0f, 0.0f}, {10.0f, 2.0f}, found);
+  EXPECT_EQ(found, std::vector<ecs::EntityID>{a});
+
+  // Also before they were ever flushed
+  ecs::EntityID e = makeEntity(5);
+  grid.update(e, {1.6f, 1.6f});
+  grid.remove(e);
+  grid.flush();
+  found.clear();
+  grid.queryRange({0.0f, 0.0f}, {10.0f, 2.0f}, found);
+  EXPECT_EQ(found, std::vector<ecs::EntityID>{a});
+}
+
+TEST_F(UniformGridTest, StaleGenerationsAreDropped) {
+  ecs::EntityID reused = makeEntity(ecs::Entity::getId(c), 1);
+  grid.update(reused, {0.5f, 0.5f});
+  grid.flush();
+
+  EXPECT_FALSE(grid.contains(c));
+  EXPECT_TRUE(grid.contains(reused));
+  EXPECT_EQ(grid.size(), 4u);
+  // Removing through the stale id leaves the new one alone
+  grid.remove(c);
+  EXPECT_TRUE(grid.contains(reused));
+
+  std::vector<ecs::EntityID> found;
+  grid.queryRange({-100.0f, -100.0f}, {100.0f, 100.0f}, found);
+  EXPECT_EQ(sorted(found), sorted({a, b, reused, d}));
+}
+
+// Random inserts, moves and removals, checked against a linear scan
+TEST(UniformGridRandomTest, MatchesABruteForceScan) {
+  constexpr ecs::EntityID COUNT = 500;
+  UniformGrid grid({-8.0f, -8.0f}, 2.0f, 8, 8);
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+  std::uniform_int_distribution<int> action(0, 9);
+
+  std::vector<glm::vec2> positions(COUNT + 1);
+  std::vector<bool> alive(COUNT + 1, false);
+  for (int round = 0; round < 20; round++) {
+    for (ecs::EntityID id = 1; id <= COUNT; id++) {
+      int roll = action(generator);
+      if (roll == 0) {
+        grid.remove(makeEntity(id));
+        alive[id] = false;
+      } else if (roll < 5) {
+        positions[id] = {coordinate(generator), coordinate(generator)};
+        grid.update(makeEntity(id), positions[id]);
+        alive[id] = true;
+      }
+    }
+    grid.flush();
+
+    glm::vec2 center{coordinate(generator), coordinate(generator)};
+    float radius = 3.0f;
+    std::vector<ecs::EntityID> expected;
+    ecs::EntityID nearestExpected = 0;
+    float nearestDistance = 5.0f * 5.0f;
+    for (ecs::EntityID id = 1; id <= COUNT; id++) {
+      if (!alive[id]) {
+        continue;
+      }
+      glm::vec2 offset = positions[id] - center;
+      float distance = glm::dot(offset, offset);
+      if (distance <= radius * radius) {
+        expected.push_back(makeEntity(id));
+      }
+      if (distance <= nearestDistance) {
+        nearestDistance = distance;
+        nearestExpected = makeEntity(id);
+      }
+    }
+
+    std::vector<ecs::EntityID> found;
+    grid.queryRadius(center, radius, found);
+    ASSERT_EQ(sorted(found), sorted(expected)) << "round " << round;
+    ecs::EntityID nearest = 0;
+    ASSERT_EQ(grid.findNearest(center, 5.0f, nearest), nearestExpected != 0);
+    if (nearestExpected != 0) {
+      glm::vec2 offset = positions[ecs::Entity::getId(nearest)] - center;
+      EXPECT_EQ(glm::dot(offset, offset), nearestDistance);
+    }
+    EXPECT_EQ(
+        grid.size(),
+        static_cast<size_t>(std::count(alive.begin(), alive.end(), true)));
+  }
+}
+
+}  // namespace uniform_grid_test
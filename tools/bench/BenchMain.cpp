@@ -0,0 +1,60 @@
+// Runs one engine benchmark without a window or a Vulkan device, so the perf
+// check measures the CPU side on machines without a GPU as well.
+//
+//   tetcipp_bench --bench-transforms|--bench-snapshots|--bench-profiler
+//                 [--bench-json <file>]
+//
+// Exits with 1 when --bench-profiler finds a zone over its budget, after
+// writing the numbers, so the perf check fails on it.
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "engine/benchmark/BenchmarkReport.hpp"
+#include "engine/benchmark/ProfilerBenchmark.hpp"
+#include "engine/benchmark/SnapshotBenchmark.hpp"
+#include "engine/benchmark/TransformBenchmark.hpp"
+
+int main(int argc, char **argv) {
+  try {
+    std::string_view benchmark;
+    std::string jsonOutput;
+    for (int i = 1; i < argc; i++) {
+      std::string_view argument = argv[i];
+      if (argument == "--bench-json" && i + 1 < argc) {
+        jsonOutput = argv[++i];
+      } else if (argument.starts_with("--bench-") && benchmark.empty()) {
+        benchmark = argument;
+      } else {
+        throw std::runtime_error("unknown option " + std::string(argument));
+      }
+    }
+
+    engine::benchmark::BenchmarkReport report;
+    bool withinBudget = true;
+    if (benchmark == "--bench-transforms") {
+      engine::benchmark::runTransformBenchmark(report);
+    } else if (benchmark == "--bench-snapshots") {
+      engine::benchmark::runSnapshotBenchmark(report);
+    } else if (benchmark == "--bench-profiler") {
+      withinBudget = engine::benchmark::runProfilerBenchmark(report);
+    } else {
+      throw std::runtime_error(
+          "expected --bench-transforms, --bench-snapshots or "
+          "--bench-profiler");
+    }
+    if (!jsonOutput.empty()) {
+      report.writeJson(jsonOutput);
+    }
+    if (!withinBudget) {
+      return EXIT_FAILURE;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
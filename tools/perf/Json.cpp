@@ -0,0 +1,174 @@
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "Json.hpp"
+
+namespace perf {
+
+namespace {
+
+// Recursive descent over the whole grammar, only numbers make it into the
+// result
+class Parser {
+ public:
+  Parser(const std::string &text, std::map<std::string, double> &numbers)
+      : text(text), numbers(numbers) {}
+
+  void parseDocument() {
+    parseValue("");
+    skipWhitespace();
+    if (position != text.size()) {
+      fail("trailing characters");
+    }
+  }
+
+ private:
+  void parseValue(const std::string &path) {
+    skipWhitespace();
+    if (position == text.size()) {
+      fail("unexpected end");
+    }
+    char c = text[position];
+    if (c == '{') {
+      parseObject(path);
+    } else if (c == '[') {
+      parseArray(path);
+    } else if (c == '"') {
+      parseString();
+    } else if (c == 't') {
+      expect("true");
+    } else if (c == 'f') {
+      expect("false");
+    } else if (c == 'n') {
+      expect("null");
+    } else {
+      numbers[path] = parseNumber();
+    }
+  }
+
+  void parseObject(const std::string &path) {
+    position++;
+    skipWhitespace();
+    if (consume('}')) {
+      return;
+    }
+    do {
+      skipWhitespace();
+      std::string key = parseString();
+      skipWhitespace();
+      if (!consume(':')) {
+        fail("expected ':'");
+      }
+      parseValue(path.empty() ? key : path + "." + key);
+      skipWhitespace();
+    } while (consume(','));
+    if (!consume('}')) {
+      fail("expected '}'");
+    }
+  }
+
+  void parseArray(const std::string &path) {
+    position++;
+    skipWhitespace();
+    if (consume(']')) {
+      return;
+    }
+    size_t index = 0;
+    do {
+      std::string key = std::to_string(index++);
+      parseValue(path.empty() ? key : path + "." + key);
+      skipWhitespace();
+    } while (consume(','));
+    if (!consume(']')) {
+      fail("expected ']'");
+    }
+  }
+
+  // Escapes are kept as written, keys of our reports never need them
+  std::string parseString() {
+    if (!consume('"')) {
+      fail("expected a string");
+    }
+    size_t begin = position;
+    while (position < text.size() && text[position] != '"') {
+      position += text[position] == '\\' ? 2 : 1;
+    }
+    if (position >= text.size()) {
+      fail("unterminated string");
+    }
+    return text.substr(begin, position++ - begin);
+  }
+
+  double parseNumber() {
+    double value;
+    auto [end, error] = std::from_chars(
+        text.data() + position, text.data() + text.size(), value);
+    if (error != std::errc()) {
+      fail("expected a value");
+    }
+    position = end - text.data();
+    return value;
+  }
+
+  void expect(const char *word) {
+    std::string_view expected = word;
+    if (text.compare(position, expected.size(), expected) != 0) {
+      fail("expected a value");
+    }
+    position += expected.size();
+  }
+
+  bool consume(char c) {
+    if (position < text.size() && text[position] == c) {
+      position++;
+      return true;
+    }
+    return false;
+  }
+
+  void skipWhitespace() {
+    while (position < text.size() &&
+           std::isspace(static_cast<unsigned char>(text[position]))) {
+      position++;
+    }
+  }
+
+  [[noreturn]] void fail(const char *message) {
+    throw std::runtime_error(
+        "invalid JSON at offset " + std::to_string(position) + ": " +
+        message);
+  }
+
+  const std::string &text;
+  std::map<std::string, double> &numbers;
+  size_t position = 0;
+};
+
+}  // namespace
+
+std::map<std::string, double> flattenJson(const std::string &text) {
+  std::map<std::string, double> numbers;
+  Parser(text, numbers).parseDocument();
+  return numbers;
+}
+
+std::map<std::string, double> readJsonFile(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("failed to open " + path);
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+  try {
+    return flattenJson(text.str());
+  } catch (const std::runtime_error &e) {
+    throw std::runtime_error(path + ": " + e.what());
+  }
+}
+
+}  // namespace perf
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+namespace perf {
+
+/// Reads the numbers of a JSON document keyed by their path, with '.' between
+/// object keys and array indices, e.g. "phases.frame.p95". Strings, booleans
+/// and nulls are skipped.
+/// @throws std::runtime_error if the document isn't valid JSON
+std::map<std::string, double> flattenJson(const std::string &text);
+
+/// @throws std::runtime_error if the file can't be read or isn't valid JSON
+std::map<std::string, double> readJsonFile(const std::string &path);
+
+}  // namespace perf
@@ -0,0 +1,403 @@
+// Runs the engine benchmarks a few times, compares the results with a stored
+// baseline and exits with 1 when a metric got significantly slower. Every
+// metric is a time or a ratio of times, lower is better. Without a baseline
+// file the benchmarks still run and print, and the check reports itself as
+// skipped and exits with 0. --update-baseline records the file.
+//
+//   perf_driver --bench-binary <tetcipp_bench> --baseline <json>
+//               [--binary <tetcipp>] [--runs N] [--threshold fraction]
+//               [--frames N] [--output <json>] [--update-baseline]
+//
+// The stress scene needs a Vulkan device and only runs with --binary, the
+// benchmarks of tetcipp_bench run anywhere.
+//
+// --compare-pipelined runs the stress scene in a window instead, once
+// single-threaded and once pipelined, resizing every --resize-every frames,
+// and prints the pipelined runs against the single-threaded ones. It needs a
+// display and no baseline.
+
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Json.hpp"
+#include "Statistics.hpp"
+
+namespace perf {
+
+namespace {
+
+struct Options {
+  std::string benchBinary;
+  std::string binary;
+  std::string baseline;
+  std::string output;
+  int runs = 5;
+  // Slowdown of the mean, as a fraction of the baseline, that counts as a
+  // regression once it is also statistically significant
+  double threshold = 0.05;
+  int frames = 600;
+  bool updateBaseline = false;
+  bool comparePipelined = false;
+  int resizeEvery = 120;
+};
+
+// Percentiles of the stress scene that get compared, the max of a run is too
+// noisy to gate on
+constexpr std::string_view STRESS_STATISTICS[] = {"p50", "p95", "p99"};
+
+using Runs = std::map<std::string, std::vector<double>>;
+
+Options parseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string_view argument = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (argument == "--bench-binary" && hasValue) {
+      options.benchBinary = argv[++i];
+    } else if (argument == "--binary" && hasValue) {
+      options.binary = argv[++i];
+    } else if (argument == "--baseline" && hasValue) {
+      options.baseline = argv[++i];
+    } else if (argument == "--output" && hasValue) {
+      options.output = argv[++i];
+    } else if (argument == "--runs" && hasValue) {
+      options.runs = std::stoi(argv[++i]);
+    } else if (argument == "--threshold" && hasValue) {
+      options.threshold = std::stod(argv[++i]);
+    } else if (argument == "--frames" && hasValue) {
+      options.frames = std::stoi(argv[++i]);
+    } else if (argument == "--update-baseline") {
+      options.updateBaseline = true;
+    } else if (argument == "--compare-pipelined") {
+      options.comparePipelined = true;
+    } else if (argument == "--resize-every" && hasValue) {
+      options.resizeEvery = std::stoi(argv[++i]);
+    } else {
+      throw std::runtime_error("unknown option " + std::string(argument));
+    }
+  }
+  if (options.comparePipelined && options.binary.empty()) {
+    throw std::runtime_error("--compare-pipelined needs --binary");
+  }
+  if (!options.comparePipelined &&
+      (options.benchBinary.empty() || options.baseline.empty())) {
+    throw std::runtime_error("--bench-binary and --baseline are required");
+  }
+  if (options.runs < 1) {
+    throw std::runtime_error("--runs has to be at least 1");
+  }
+  return options;
+}
+
+void runCommand(const std::string &command) {
+  std::cout << "perf: " << command << std::endl;
+  if (std::system(command.c_str()) != 0) {
+    throw std::runtime_error("command failed: " + command);
+  }
+}
+
+// Adds the metrics of a BenchmarkReport file, "metrics.<name>.value"
+void readBenchmark(const std::string &path, Runs &runs) {
+  constexpr std::string_view prefix = "metrics.";
+  constexpr std::string_view suffix = ".value";
+  for (auto &[key, value] : readJsonFile(path)) {
+    if (key.starts_with(prefix) && key.ends_with(suffix)) {
+      runs[key.substr(
+               prefix.size(), key.size() - prefix.size() - suffix.size())]
+          .push_back(value);
+    }
+  }
+}
+
+// Adds the percentiles of a stress scene report, "phases.<phase>.<stat>", as
+// "<name>/<phase>/<stat>". Phases without samples, like the GPU one on queues
+// without timestamps, are left out.
+void readStressReport(
+    const std::string &path,
+    std::string_view name,
+    Runs &runs) {
+  constexpr std::string_view prefix = "phases.";
+  constexpr std::string_view suffix = ".samples";
+  auto numbers = readJsonFile(path);
+  for (auto &[key, value] : numbers) {
+    if (!key.starts_with(prefix) || !key.ends_with(suffix) || value == 0.0) {
+      continue;
+    }
+    std::string phase = key.substr(
+        prefix.size(), key.size() - prefix.size() - suffix.size());
+    for (std::string_view statistic : STRESS_STATISTICS) {
+      auto found = numbers.find(std::format("phases.{}.{}", phase, statistic));
+      if (found != numbers.end()) {
+        runs[std::format("{}/{}/{}", name, phase, statistic)].push_back(
+            found->second);
+      }
+    }
+  }
+}
+
+// Median pipelined frame over the median single-threaded frame of the same
+// run, as "stress-pipelined/frame-ratio". Headless runs step one tick per
+// frame, so this is the throughput the pipeline buys: 0.5 means it doubled.
+void addPipelinedRatio(Runs &runs) {
+  auto single = runs.find("stress/frame/p50");
+  auto pipelined = runs.find("stress-pipelined/frame/p50");
+  if (single == runs.end() || pipelined == runs.end() ||
+      single->second.size() != pipelined->second.size() ||
+      single->second.back() <= 0.0) {
+    return;
+  }
+  runs["stress-pipelined/frame-ratio"].push_back(
+      pipelined->second.back() / single->second.back());
+}
+
+Runs runBenchmarks(const Options &options) {
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "tetcipp-perf";
+  std::filesystem::create_directories(directory);
+  std::string benchBinary = std::format("\"{}\"", options.benchBinary);
+  std::string binary = std::format("\"{}\"", options.binary);
+
+  Runs runs;
+  for (int run = 0; run < options.runs; run++) {
+    std::cout << std::format("perf: run {}/{}\n", run + 1, options.runs);
+    for (std::string_view benchmark : {"transforms", "snapshots", "profiler"}) {
+      std::string path =
+          (directory / std::format("{}.json", benchmark)).string();
+      runCommand(
+          std::format(
+              "{} --bench-{} --bench-json \"{}\"",
+              benchBinary,
+              benchmark,
+              path));
+      readBenchmark(path, runs);
+    }
+    if (options.binary.empty()) {
+      continue;
+    }
+    // Headless, so every frame is one tick and runs see the same workload
+    std::string path = (directory / "stress.json").string();
+    runCommand(
+        std::format(
+            "{} --stress --headless --frames {} --report \"{}\"",
+            binary,
+            options.frames,
+            path));
+    readStressReport(path, "stress", runs);
+    runCommand(
+        std::format(
+            "{} --stress --headless --pipelined --frames {} --report \"{}\"",
+            binary,
+            options.frames,
+            path));
+    readStressReport(path, "stress-pipelined", runs);
+    addPipelinedRatio(runs);
+  }
+  return runs;
+}
+
+// Windowed stress runs of one mode, the resizes recreate the swap chain while
+// the simulation keeps going
+Runs runWindowedStress(const Options &options, bool pipelined) {
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "tetcipp-perf";
+  std::filesystem::create_directories(directory);
+  std::string path = (directory / "stress-windowed.json").string();
+
+  Runs runs;
+  for (int run = 0; run < options.runs; run++) {
+    std::cout << std::format(
+        "perf: {} run {}/{}\n",
+        pipelined ? "pipelined" : "single-threaded",
+        run + 1,
+        options.runs);
+    runCommand(
+        std::format(
+            "\"{}\" --stress{} --frames {} --resize-every {} --report \"{}\"",
+            options.binary,
+            pipelined ? " --pipelined" : "",
+            options.frames,
+            options.resizeEvery,
+            path));
+    readStressReport(path, "stress", runs);
+  }
+  return runs;
+}
+
+std::map<std::string, Summary> summarizeRuns(const Runs &runs) {
+  std::map<std::string, Summary> summaries;
+  for (auto &[name, values] : runs) {
+    summaries[name] = summarize(values);
+  }
+  return summaries;
+}
+
+void writeSummaries(
+    const std::string &path,
+    const std::map<std::string, Summary> &summaries) {
+  std::filesystem::path parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) {
+    std::filesystem::create_directories(parent);
+  }
+  std::ofstream file(path);
+  if (!file) {
+    throw std::runtime_error("failed to open " + path);
+  }
+  file << "{\n  \"metrics\": {";
+  bool first = true;
+  for (auto &[name, summary] : summaries) {
+    file << std::format(
+        "{}\n    \"{}\": {{\"mean\": {}, \"stddev\": {}, \"runs\": {}}}",
+        first ? "" : ",",
+        name,
+        summary.mean,
+        summary.stddev,
+        summary.runs);
+    first = false;
+  }
+  file << "\n  }\n}\n";
+}
+
+std::map<std::string, Summary> readSummaries(const std::string &path) {
+  constexpr std::string_view prefix = "metrics.";
+  std::map<std::string, Summary> summaries;
+  for (auto &[key, value] : readJsonFile(path)) {
+    if (!key.starts_with(prefix)) {
+      continue;
+    }
+    size_t dot = key.rfind('.');
+    std::string name = key.substr(prefix.size(), dot - prefix.size());
+    std::string_view field = std::string_view(key).substr(dot + 1);
+    Summary &summary = summaries[name];
+    if (field == "mean") {
+      summary.mean = value;
+    } else if (field == "stddev") {
+      summary.stddev = value;
+    } else if (field == "runs") {
+      summary.runs = static_cast<size_t>(value);
+    }
+  }
+  return summaries;
+}
+
+// Prints one line per metric
+// @return The number of regressions
+int compareWithBaseline(
+    const std::map<std::string, Summary> &baseline,
+    const std::map<std::string, Summary> &current,
+    double threshold) {
+  std::cout << std::format(
+      "\n{:<32} {:>22} {:>22} {:>8}\n",
+      "metric",
+      "baseline (95% CI)",
+      "current (95% CI)",
+      "change");
+  int regressions = 0;
+  for (auto &[name, summary] : current) {
+    auto found = baseline.find(name);
+    if (found == baseline.end()) {
+      std::cout << std::format(
+          "{:<32} {:>22} {:>12.4f} ± {:<7.4f} new\n",
+          name,
+          "-",
+          summary.mean,
+          confidenceHalfWidth(summary));
+      continue;
+    }
+    const Summary &reference = found->second;
+    Difference difference = compare(reference, summary);
+    double allowed = threshold * reference.mean;
+    // The whole interval has to lie beyond the threshold, a slowdown within
+    // the noise of either side doesn't fail the check
+    const char *verdict = "";
+    if (difference.lower > allowed) {
+      verdict = "REGRESSION";
+      regressions++;
+    } else if (difference.upper < -allowed) {
+      verdict = "faster";
+    }
+    std::cout << std::format(
+        "{:<32} {:>12.4f} ± {:<7.4f} {:>12.4f} ± {:<7.4f} {:>+7.1f}% {}\n",
+        name,
+        reference.mean,
+        confidenceHalfWidth(reference),
+        summary.mean,
+        confidenceHalfWidth(summary),
+        reference.mean != 0.0 ? 100.0 * difference.estimate / reference.mean
+                              : 0.0,
+        verdict);
+  }
+  for (auto &[name, summary] : baseline) {
+    if (!current.contains(name)) {
+      std::cout << std::format("{:<32} missing from this run\n", name);
+    }
+  }
+  return regressions;
+}
+
+int run(int argc, char **argv) {
+  Options options = parseOptions(argc, argv);
+  if (options.comparePipelined) {
+    std::map<std::string, Summary> singleThreaded =
+        summarizeRuns(runWindowedStress(options, false));
+    std::map<std::string, Summary> pipelined =
+        summarizeRuns(runWindowedStress(options, true));
+    if (!options.output.empty()) {
+      writeSummaries(options.output, pipelined);
+    }
+    // Informational, a slower pipelined phase doesn't fail the comparison
+    std::cout << "\nperf: single-threaded as baseline, pipelined as current";
+    compareWithBaseline(singleThreaded, pipelined, options.threshold);
+    return 0;
+  }
+  std::map<std::string, Summary> current =
+      summarizeRuns(runBenchmarks(options));
+  if (!options.output.empty()) {
+    writeSummaries(options.output, current);
+  }
+  if (options.updateBaseline) {
+    writeSummaries(options.baseline, current);
+    std::cout << "perf: wrote baseline " << options.baseline << std::endl;
+    return 0;
+  }
+  if (!std::filesystem::exists(options.baseline)) {
+    // Every metric shows up as new
+    compareWithBaseline({}, current, options.threshold);
+    std::cout << "\nperf: SKIPPED, no baseline at " << options.baseline
+              << ", record one on the reference machine with the perf-baseline"
+                 " target\n";
+    return 0;
+  }
+
+  int regressions = compareWithBaseline(
+      readSummaries(options.baseline), current, options.threshold);
+  if (regressions > 0) {
+    std::cout << std::format(
+        "\nperf: {} significant regressions above {:.1f}%\n",
+        regressions,
+        options.threshold * 100.0);
+    return 1;
+  }
+  std::cout << "\nperf: no significant regressions\n";
+  return 0;
+}
+
+}  // namespace
+
+}  // namespace perf
+
+int main(int argc, char **argv) {
+  try {
+    return perf::run(argc, argv);
+  } catch (const std::exception &e) {
+    std::cerr << "perf: " << e.what() << std::endl;
+    return 2;
+  }
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Statistics.hpp"
+
+namespace perf {
+
+namespace {
+
+// Two sided 95% quantiles of Student's t for 1 to 30 degrees of freedom
+constexpr double T_QUANTILES[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+
+// Fractional degrees of freedom round down, which widens the interval
+double tQuantile(double degreesOfFreedom) {
+  if (degreesOfFreedom < 1.0) {
+    return T_QUANTILES[0];
+  }
+  size_t index = static_cast<size_t>(degreesOfFreedom);
+  if (index > std::size(T_QUANTILES)) {
+    return 1.960;
+  }
+  return T_QUANTILES[index - 1];
+}
+
+}  // namespace
+
+Summary summarize(const std::vector<double> &values) {
+  Summary summary;
+  summary.runs = values.size();
+  if (values.empty()) {
+    return summary;
+  }
+  double sum = 0.0;
+  for (double value : values) {
+    sum += value;
+  }
+  summary.mean = sum / values.size();
+  if (values.size() > 1) {
+    double squares = 0.0;
+    for (double value : values) {
+      squares += (value - summary.mean) * (value - summary.mean);
+    }
+    summary.stddev = std::sqrt(squares / (values.size() - 1));
+  }
+  return summary;
+}
+
+double confidenceHalfWidth(const Summary &summary) {
+  if (summary.runs < 2) {
+    return 0.0;
+  }
+  return tQuantile(summary.runs - 1) * summary.stddev /
+         std::sqrt(static_cast<double>(summary.runs));
+}
+
+Difference compare(const Summary &baseline, const Summary &current) {
+  double estimate = current.mean - baseline.mean;
+  double baselineVariance =
+      baseline.runs > 0 ? baseline.stddev * baseline.stddev / baseline.runs
+                        : 0.0;
+  double currentVariance =
+      current.runs > 0 ? current.stddev * current.stddev / current.runs : 0.0;
+  double variance = baselineVariance + currentVariance;
+  if (variance == 0.0) {
+    return {estimate, estimate, estimate};
+  }
+  // Welch-Satterthwaite, a side with a single run contributes no variance
+  // and no degrees of freedom
+  double denominator = 0.0;
+  if (baseline.runs > 1) {
+    denominator +=
+        baselineVariance * baselineVariance / (baseline.runs - 1);
+  }
+  if (current.runs > 1) {
+    denominator += currentVariance * currentVariance / (current.runs - 1);
+  }
+  double degreesOfFreedom = variance * variance / denominator;
+  double halfWidth = tQuantile(degreesOfFreedom) * std::sqrt(variance);
+  return {estimate, estimate - halfWidth, estimate + halfWidth};
+}
+
+}  // namespace perf
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace perf {
+
+/// Mean and spread of the runs of one metric
+struct Summary {
+  double mean = 0.0;
+  // Sample standard deviation, 0 for a single run
+  double stddev = 0.0;
+  size_t runs = 0;
+};
+
+Summary summarize(const std::vector<double> &values);
+
+/// Half width of the 95% confidence interval of the mean, from Student's t
+/// distribution since we only have a handful of runs
+double confidenceHalfWidth(const Summary &summary);
+
+/// 95% confidence interval of current.mean - baseline.mean, from Welch's t
+/// test so the two sides may have different variances and run counts
+struct Difference {
+  double estimate;
+  double lower;
+  double upper;
+};
+
+Difference compare(const Summary &baseline, const Summary &current);
+
+}  // namespace perf